@@ -0,0 +1,46 @@
+#ifndef WF_BENCHMARK_HPP
+#define WF_BENCHMARK_HPP
+
+#include <chrono>
+
+namespace wf
+{
+namespace benchmark
+{
+/**
+ * Make the compiler assume that the value is used, so that the computation of
+ * the value is not optimized away.
+ */
+template<class T>
+inline void keep(const T& value)
+{
+    asm volatile ("" : : "g" (&value) : "memory");
+}
+
+/**
+ * Call fn the given number of times, after a warm-up of a tenth of the runs.
+ *
+ * @return The average duration of a single call, in nanoseconds.
+ */
+template<class Fn>
+double measure_ns(long runs, Fn&& fn)
+{
+    for (long i = 0; i < runs / 10; i++)
+    {
+        fn();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < runs; i++)
+    {
+        fn();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / runs;
+}
+}
+}
+
+#endif /* end of include guard: WF_BENCHMARK_HPP */
@@ -0,0 +1,218 @@
+/*
+ * Dispatch of key events to the key and activator bindings of the active
+ * output, before and after bindings were indexed by their input.
+ *
+ * input_manager cannot be created without a running compositor, but the
+ * bindings and their index live in src/core/seat/binding-index.hpp, which
+ * only needs wf-config. The new path uses wf::binding_index_t from there,
+ * followed by a copy of the loop of input_manager::call_key_bindings(),
+ * without the modifier check which needs a seat. The old path is a copy of
+ * the replaced input_manager::match_keys(), kept as the baseline.
+ */
+#include <wayfire/config/option.hpp>
+#include <wayfire/config/types.hpp>
+#include <wayfire/bindings.hpp>
+#include <linux/input-event-codes.h>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "binding-index.hpp"
+
+namespace
+{
+/* Same values as WLR_MODIFIER_* */
+const uint32_t MODIFIER_SHIFT = 1 << 0;
+const uint32_t MODIFIER_ALT   = 1 << 3;
+const uint32_t MODIFIER_LOGO  = 1 << 6;
+
+const int NUM_OUTPUTS = 4;
+const long NUM_EVENTS = 1'000'000;
+
+const std::vector<std::pair<uint32_t, std::string>> KEYS = {
+    {KEY_A, "KEY_A"}, {KEY_B, "KEY_B"}, {KEY_C, "KEY_C"}, {KEY_D, "KEY_D"},
+    {KEY_E, "KEY_E"}, {KEY_F, "KEY_F"}, {KEY_G, "KEY_G"}, {KEY_H, "KEY_H"},
+    {KEY_I, "KEY_I"}, {KEY_J, "KEY_J"}, {KEY_K, "KEY_K"}, {KEY_L, "KEY_L"},
+    {KEY_M, "KEY_M"}, {KEY_N, "KEY_N"}, {KEY_O, "KEY_O"}, {KEY_P, "KEY_P"},
+    {KEY_Q, "KEY_Q"}, {KEY_R, "KEY_R"}, {KEY_S, "KEY_S"}, {KEY_T, "KEY_T"},
+    {KEY_U, "KEY_U"}, {KEY_V, "KEY_V"}, {KEY_W, "KEY_W"}, {KEY_X, "KEY_X"},
+    {KEY_Y, "KEY_Y"}, {KEY_Z, "KEY_Z"}, {KEY_1, "KEY_1"}, {KEY_2, "KEY_2"},
+    {KEY_3, "KEY_3"}, {KEY_4, "KEY_4"},
+};
+
+wf::binding_index_t::bindings_t bindings;
+
+/* Outputs are only compared, so any distinct addresses will do */
+char output_storage[NUM_OUTPUTS];
+wf::output_t *get_output(int i)
+{
+    return reinterpret_cast<wf::output_t*>(&output_storage[i]);
+}
+
+wf::output_t *active_output = get_output(0);
+
+/* The old dispatch: check every binding, and collect the callbacks */
+std::vector<std::function<bool()>> match_keys(uint32_t mods, uint32_t key)
+{
+    std::vector<std::function<bool()>> callbacks;
+    for (auto& binding : bindings[WF_BINDING_KEY])
+    {
+        auto as_key = std::dynamic_pointer_cast<
+            wf::config::option_t<wf::keybinding_t>>(binding->value);
+        if ((as_key->get_value() == wf::keybinding_t{mods, key}) &&
+            (binding->output == active_output))
+        {
+            auto callback = binding->call.key;
+            callbacks.push_back([key, callback] ()
+            {
+                return (*callback)(key);
+            });
+        }
+    }
+
+    for (auto& binding : bindings[WF_BINDING_ACTIVATOR])
+    {
+        auto as_activator = std::dynamic_pointer_cast<
+            wf::config::option_t<wf::activatorbinding_t>>(binding->value);
+        if (as_activator->get_value().has_match(wf::keybinding_t{mods, key}) &&
+            (binding->output == active_output))
+        {
+            auto callback = binding->call.activator;
+            callbacks.push_back([=] ()
+            {
+                return (*callback)(wf::ACTIVATOR_SOURCE_KEYBINDING, key);
+            });
+        }
+    }
+
+    return callbacks;
+}
+
+bool dispatch_old(uint32_t mods, uint32_t key)
+{
+    bool handled = false;
+    for (auto& callback : match_keys(mods, key))
+    {
+        handled |= callback();
+    }
+
+    return handled;
+}
+
+/* The new dispatch: push_matched_bindings() and call_key_bindings() */
+wf::binding_index_t binding_index;
+
+bool dispatch_new(uint32_t mods, uint32_t key)
+{
+    size_t first = binding_index.push_matched(bindings, wf::BINDING_INPUT_KEY,
+        mods, key, active_output);
+
+    size_t last  = binding_index.matched.size();
+    bool handled = false;
+    for (size_t i = first; i < last; i++)
+    {
+        auto match = binding_index.matched[i];
+        if (match.type == WF_BINDING_KEY)
+        {
+            handled |= (*match.call.key)(key);
+        } else
+        {
+            handled |= (*match.call.activator)(
+                wf::ACTIVATOR_SOURCE_KEYBINDING, key);
+        }
+    }
+
+    binding_index.matched.resize(first);
+
+    return handled;
+}
+
+/* Every plugin on every output has one key binding, <super> KEY, and one
+ * activator binding, <super> <shift> KEY | <alt> KEY */
+void add_bindings(wf::key_callback *key_cb,
+    wf::activator_callback *activator_cb)
+{
+    for (int output = 0; output < NUM_OUTPUTS; output++)
+    {
+        for (auto& [code, name] : KEYS)
+        {
+            auto key = std::make_unique<wf::binding_t>();
+            key->value = wf::create_option(
+                wf::keybinding_t{MODIFIER_LOGO, code});
+            key->type   = WF_BINDING_KEY;
+            key->output = get_output(output);
+            key->call.key = key_cb;
+            bindings[WF_BINDING_KEY].push_back(std::move(key));
+
+            auto value = wf::option_type::from_string<wf::activatorbinding_t>(
+                "<super> <shift> " + name + " | <alt> " + name);
+            auto activator = std::make_unique<wf::binding_t>();
+            activator->value  = wf::create_option(value.value());
+            activator->type   = WF_BINDING_ACTIVATOR;
+            activator->output = get_output(output);
+            activator->call.activator = activator_cb;
+            bindings[WF_BINDING_ACTIVATOR].push_back(std::move(activator));
+        }
+    }
+}
+
+/* Mostly plain typing, which matches no binding. Some keys are pressed with
+ * the modifiers of the key or the activator bindings. */
+std::pair<uint32_t, uint32_t> event_at(long i)
+{
+    uint32_t mods = (i % 4 == 0) ? MODIFIER_LOGO : 0;
+    if (i % 16 == 1)
+    {
+        mods = MODIFIER_LOGO | MODIFIER_SHIFT;
+    } else if (i % 16 == 3)
+    {
+        mods = MODIFIER_ALT;
+    }
+
+    return {mods, KEYS[i % KEYS.size()].first};
+}
+}
+
+int main()
+{
+    long calls = 0;
+    wf::key_callback key_cb = [&] (uint32_t)
+    {
+        ++calls;
+        return true;
+    };
+    wf::activator_callback activator_cb =
+        [&] (wf::activator_source_t, uint32_t)
+    {
+        ++calls;
+        return true;
+    };
+
+    add_bindings(&key_cb, &activator_cb);
+
+    long i = 0;
+    double old_ns = wf::benchmark::measure_ns(NUM_EVENTS, [&] ()
+    {
+        auto [mods, key] = event_at(i++);
+        dispatch_old(mods, key);
+    });
+
+    i = 0;
+    double new_ns = wf::benchmark::measure_ns(NUM_EVENTS, [&] ()
+    {
+        auto [mods, key] = event_at(i++);
+        dispatch_new(mods, key);
+    });
+
+    wf::benchmark::keep(calls);
+    printf("%zu key and %zu activator bindings on %d outputs\n",
+        bindings[WF_BINDING_KEY].size(), bindings[WF_BINDING_ACTIVATOR].size(),
+        NUM_OUTPUTS);
+    printf("%ld key events: old %.1f ms, new %.1f ms\n", NUM_EVENTS,
+        old_ns * NUM_EVENTS / 1'000'000, new_ns * NUM_EVENTS / 1'000'000);
+
+    return 0;
+}
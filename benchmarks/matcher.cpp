@@ -0,0 +1,404 @@
+/*
+ * Matching 1000 views against 50 view matchers, with and without the result
+ * cache of view_matcher_t.
+ *
+ * Views cannot be created without a running compositor, so the views here are
+ * plain structs. The result table and the matcher slots are the ones from
+ * src/core/matcher-cache.hpp, which matcher.cpp uses too. The parts which read
+ * views are a model of view_access_interface_t and matcher.cpp, for the
+ * properties the conditions here use: the property lookup before and after it
+ * was indexed, and the state a result depends on. The conditions are parsed
+ * and evaluated by wf-config, as in view_matcher_t.
+ */
+#include <wayfire/lexer/lexer.hpp>
+#include <wayfire/condition/condition.hpp>
+#include <wayfire/condition/access_interface.hpp>
+#include <wayfire/parser/condition_parser.hpp>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "matcher-cache.hpp"
+
+namespace
+{
+const int NUM_VIEWS = 1000;
+const int NUM_RULES = 50;
+const int NUM_PASSES = 20;
+
+/* Same values as WLR_EDGE_* */
+const uint32_t EDGE_TOP    = 1 << 0;
+const uint32_t EDGE_BOTTOM = 1 << 1;
+const uint32_t EDGE_LEFT   = 1 << 2;
+const uint32_t EDGE_RIGHT  = 1 << 3;
+const uint32_t EDGES_ALL   = EDGE_TOP | EDGE_BOTTOM | EDGE_LEFT | EDGE_RIGHT;
+
+/* The view state which the conditions can read */
+struct bench_view_t
+{
+    std::string app_id;
+    std::string title;
+    bool fullscreen = false;
+    bool activated  = false;
+    bool minimized  = false;
+    uint32_t tiled_edges = 0;
+
+    /* Bumped on title-changed and app-id-changed */
+    int64_t title_version  = 0;
+    int64_t app_id_version = 0;
+
+    std::string get_app_id()
+    {
+        return app_id;
+    }
+
+    std::string get_title()
+    {
+        return title;
+    }
+};
+
+/* The old view_access_interface_t::get(): a chain of string comparisons */
+class old_access_interface_t : public wf::access_interface_t
+{
+  public:
+    old_access_interface_t(bench_view_t *view) : view(view)
+    {}
+
+    wf::variant_t get(const std::string& identifier, bool& error) override
+    {
+        wf::variant_t out = std::string("");
+        error = false;
+        if (identifier == "app_id")
+        {
+            out = view->get_app_id();
+        } else if (identifier == "title")
+        {
+            out = view->get_title();
+        } else if (identifier == "fullscreen")
+        {
+            out = view->fullscreen;
+        } else if (identifier == "activated")
+        {
+            out = view->activated;
+        } else if (identifier == "minimized")
+        {
+            out = view->minimized;
+        } else if (identifier == "tiled-left")
+        {
+            out = (view->tiled_edges & EDGE_LEFT) > 0;
+        } else if (identifier == "tiled-right")
+        {
+            out = (view->tiled_edges & EDGE_RIGHT) > 0;
+        } else if (identifier == "tiled-top")
+        {
+            out = (view->tiled_edges & EDGE_TOP) > 0;
+        } else if (identifier == "tiled-bottom")
+        {
+            out = (view->tiled_edges & EDGE_BOTTOM) > 0;
+        } else if (identifier == "maximized")
+        {
+            out = view->tiled_edges == EDGES_ALL;
+        } else if (identifier == "floating")
+        {
+            out = view->tiled_edges == 0;
+        }
+
+        return out;
+    }
+
+  private:
+    bench_view_t *view;
+};
+
+/* Model of view_access_interface_t::property_t and find_property() */
+enum property_t
+{
+    PROPERTY_APP_ID,
+    PROPERTY_TITLE,
+    PROPERTY_FULLSCREEN,
+    PROPERTY_ACTIVATED,
+    PROPERTY_MINIMIZED,
+    PROPERTY_TILED_LEFT,
+    PROPERTY_TILED_RIGHT,
+    PROPERTY_TILED_TOP,
+    PROPERTY_TILED_BOTTOM,
+    PROPERTY_MAXIMIZED,
+    PROPERTY_FLOATING,
+    PROPERTY_UNKNOWN,
+};
+
+property_t find_property(const std::string& identifier)
+{
+    static const std::unordered_map<std::string, property_t> properties = {
+        {"app_id", PROPERTY_APP_ID},
+        {"title", PROPERTY_TITLE},
+        {"fullscreen", PROPERTY_FULLSCREEN},
+        {"activated", PROPERTY_ACTIVATED},
+        {"minimized", PROPERTY_MINIMIZED},
+        {"tiled-left", PROPERTY_TILED_LEFT},
+        {"tiled-right", PROPERTY_TILED_RIGHT},
+        {"tiled-top", PROPERTY_TILED_TOP},
+        {"tiled-bottom", PROPERTY_TILED_BOTTOM},
+        {"maximized", PROPERTY_MAXIMIZED},
+        {"floating", PROPERTY_FLOATING},
+    };
+
+    auto it = properties.find(identifier);
+
+    return it == properties.end() ? PROPERTY_UNKNOWN : it->second;
+}
+
+/* Model of the new lookup, recording the properties which were read, like
+ * recording_access_interface_t in matcher.cpp */
+class recording_access_interface_t : public wf::access_interface_t
+{
+  public:
+    recording_access_interface_t(bench_view_t *view) : view(view)
+    {}
+
+    wf::variant_t get(const std::string& identifier, bool& error) override
+    {
+        auto property = find_property(identifier);
+        properties |= (1u << property);
+        error = false;
+        switch (property)
+        {
+          case PROPERTY_APP_ID:
+            return view->get_app_id();
+
+          case PROPERTY_TITLE:
+            return view->get_title();
+
+          case PROPERTY_FULLSCREEN:
+            return view->fullscreen;
+
+          case PROPERTY_ACTIVATED:
+            return view->activated;
+
+          case PROPERTY_MINIMIZED:
+            return view->minimized;
+
+          case PROPERTY_TILED_LEFT:
+            return (view->tiled_edges & EDGE_LEFT) > 0;
+
+          case PROPERTY_TILED_RIGHT:
+            return (view->tiled_edges & EDGE_RIGHT) > 0;
+
+          case PROPERTY_TILED_TOP:
+            return (view->tiled_edges & EDGE_TOP) > 0;
+
+          case PROPERTY_TILED_BOTTOM:
+            return (view->tiled_edges & EDGE_BOTTOM) > 0;
+
+          case PROPERTY_MAXIMIZED:
+            return view->tiled_edges == EDGES_ALL;
+
+          case PROPERTY_FLOATING:
+            return view->tiled_edges == 0;
+
+          default:
+            return std::string("");
+        }
+    }
+
+    /** A bitmask of the properties which were read */
+    uint32_t properties = 0;
+
+  private:
+    bench_view_t *view;
+};
+
+/* The results of the matchers for a view, as in matcher_cache_t */
+class matcher_cache_t
+{
+  public:
+    using state_t  = wf::matcher_results_t::state_t;
+    using result_t = wf::matcher_results_t::result_t;
+
+    const result_t *find(bench_view_t *view, size_t slot, uint64_t condition_id)
+    {
+        return results.find(slot, condition_id, [&] (uint32_t properties)
+        {
+            return get_state(view, properties);
+        });
+    }
+
+    void store(bench_view_t *view, size_t slot, uint64_t condition_id,
+        uint32_t properties, bool matches)
+    {
+        results.store(slot, condition_id, properties,
+            get_state(view, properties), matches);
+    }
+
+  private:
+    wf::matcher_results_t results;
+
+    /* Model of matcher_cache_t::get_state(), for the properties above */
+    state_t get_state(bench_view_t *view, uint32_t properties)
+    {
+        auto has = [&] (property_t property)
+        {
+            return (properties & (1u << property)) != 0;
+        };
+
+        state_t state;
+        if (has(PROPERTY_TITLE))
+        {
+            state.title_version = view->title_version;
+        }
+
+        if (has(PROPERTY_APP_ID))
+        {
+            state.app_id_version = view->app_id_version;
+        }
+
+        uint64_t flags = 0;
+        if (has(PROPERTY_FULLSCREEN))
+        {
+            flags |= (uint64_t)view->fullscreen << 8;
+        }
+
+        if (has(PROPERTY_ACTIVATED))
+        {
+            flags |= (uint64_t)view->activated << 9;
+        }
+
+        if (has(PROPERTY_MINIMIZED))
+        {
+            flags |= (uint64_t)view->minimized << 10;
+        }
+
+        if (has(PROPERTY_TILED_LEFT) || has(PROPERTY_TILED_RIGHT) ||
+            has(PROPERTY_TILED_TOP) || has(PROPERTY_TILED_BOTTOM) ||
+            has(PROPERTY_MAXIMIZED) || has(PROPERTY_FLOATING))
+        {
+            flags |= (uint64_t)view->tiled_edges << 16;
+        }
+
+        state.flags = flags;
+
+        return state;
+    }
+};
+
+std::shared_ptr<wf::condition_t> parse_condition(const std::string& value)
+{
+    wf::lexer_t lexer;
+    wf::condition_parser_t parser;
+    lexer.reset(value);
+
+    return parser.parse(lexer);
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+}
+
+int main()
+{
+    std::vector<bench_view_t> views(NUM_VIEWS);
+    for (int i = 0; i < NUM_VIEWS; i++)
+    {
+        views[i].app_id = "org.example.application" + std::to_string(i % 97);
+        views[i].title  = "Some document title with a few words " +
+            std::to_string(i);
+        views[i].tiled_edges = (i % 3) ? 0 : EDGES_ALL;
+    }
+
+    std::vector<std::shared_ptr<wf::condition_t>> rules;
+    for (int i = 0; i < NUM_RULES; i++)
+    {
+        rules.push_back(parse_condition("(app_id is \"org.example.application" +
+            std::to_string(i * 2) + "\" | title contains \"word" +
+            std::to_string(i) + "\") & floating is true"));
+    }
+
+    long matches = 0;
+    bool error   = false;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (auto& view : views)
+        {
+            for (auto& rule : rules)
+            {
+                old_access_interface_t access{&view};
+                matches += rule->evaluate(access, error);
+            }
+        }
+    }
+
+    printf("uncached, old property lookup  %6.2f ms\n",
+        elapsed_ms(start) / NUM_PASSES);
+
+    std::vector<size_t> slots;
+    for (int i = 0; i < NUM_RULES; i++)
+    {
+        slots.push_back(wf::matcher_slots_t::acquire());
+    }
+
+    std::vector<matcher_cache_t> caches(NUM_VIEWS);
+    auto cached_pass = [&] ()
+    {
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            for (size_t r = 0; r < rules.size(); r++)
+            {
+                size_t slot = slots[r];
+                uint64_t condition_id = r + 1;
+                if (auto result = caches[i].find(&views[i], slot, condition_id))
+                {
+                    matches += result->matches;
+                    continue;
+                }
+
+                recording_access_interface_t access{&views[i]};
+                bool result = rules[r]->evaluate(access, error);
+                caches[i].store(&views[i], slot, condition_id,
+                    access.properties, result);
+                matches += result;
+            }
+        }
+    };
+
+    start = std::chrono::steady_clock::now();
+    cached_pass();
+    printf("first pass, filling the cache  %6.2f ms\n", elapsed_ms(start));
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        cached_pass();
+    }
+
+    printf("cached                         %6.2f ms\n",
+        elapsed_ms(start) / NUM_PASSES);
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (auto& view : views)
+        {
+            ++view.title_version;
+        }
+
+        cached_pass();
+    }
+
+    printf("all titles changed             %6.2f ms\n",
+        elapsed_ms(start) / NUM_PASSES);
+
+    wf::benchmark::keep(matches);
+
+    return 0;
+}
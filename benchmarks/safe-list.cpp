@@ -0,0 +1,120 @@
+/*
+ * Compares wf::safe_list_t with its previous implementation, which stored
+ * each element in a separate allocation and cleaned up removed elements from
+ * an idle source.
+ */
+#include <wayfire/nonstd/safe-list.hpp>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "benchmark.hpp"
+#include "old-safe-list.hpp"
+
+namespace
+{
+const long RUNS = 2'000'000;
+const long MODIFY_RUNS = 200'000;
+
+wl_event_loop *event_loop;
+
+template<class List>
+double bench_for_each(int size)
+{
+    static int values[64];
+    List list;
+    for (int i = 0; i < size; i++)
+    {
+        list.push_back(&values[i]);
+    }
+
+    long sum = 0;
+    double result = wf::benchmark::measure_ns(RUNS, [&] ()
+    {
+        list.for_each([&] (int *value) { sum += *value + 1; });
+    });
+    wf::benchmark::keep(sum);
+
+    return result;
+}
+
+template<class List>
+double bench_for_each_reverse(int size)
+{
+    List list;
+    for (int i = 0; i < size; i++)
+    {
+        list.push_back(std::make_shared<int>(i));
+    }
+
+    long sum = 0;
+    double result = wf::benchmark::measure_ns(RUNS, [&] ()
+    {
+        list.for_each_reverse([&] (auto& value)
+        {
+            sum += *value;
+        });
+    });
+    wf::benchmark::keep(sum);
+
+    return result;
+}
+
+/* Adding and removing an element, for ex. connecting and disconnecting a
+ * signal handler. The event loop is dispatched after each removal, so that
+ * the cleanup of the old implementation is included. */
+template<class List>
+double bench_add_remove(int size)
+{
+    static int values[64];
+    List list;
+    for (int i = 0; i < size; i++)
+    {
+        list.push_back(&values[i]);
+    }
+
+    return wf::benchmark::measure_ns(MODIFY_RUNS, [&] ()
+    {
+        list.push_back(&values[63]);
+        list.remove_all(&values[63]);
+        wl_event_loop_dispatch(event_loop, 0);
+    });
+}
+
+void print_result(const std::string& name, double old_ns, double new_ns)
+{
+    printf("%-36s %6.1f ns -> %6.1f ns\n", name.c_str(), old_ns, new_ns);
+}
+}
+
+int main()
+{
+    event_loop = wl_event_loop_create();
+    wf::benchmark::old_safe_list_detail::event_loop = event_loop;
+
+    using old_ptr_list_t = wf::benchmark::old_safe_list_t<int*>;
+    using new_ptr_list_t = wf::safe_list_t<int*>;
+    using old_shared_list_t =
+        wf::benchmark::old_safe_list_t<std::shared_ptr<int>>;
+    using new_shared_list_t = wf::safe_list_t<std::shared_ptr<int>>;
+
+    for (int size : {4, 16})
+    {
+        double old_ns = bench_for_each<old_ptr_list_t>(size);
+        double new_ns = bench_for_each<new_ptr_list_t>(size);
+        print_result("for_each, " + std::to_string(size) + " raw pointers",
+            old_ns, new_ns);
+    }
+
+    double old_ns = bench_for_each_reverse<old_shared_list_t>(16);
+    double new_ns = bench_for_each_reverse<new_shared_list_t>(16);
+    print_result("for_each_reverse, 16 shared_ptrs", old_ns, new_ns);
+
+    old_ns = bench_add_remove<old_ptr_list_t>(16);
+    new_ns = bench_add_remove<new_ptr_list_t>(16);
+    print_result("push_back + remove_all, 16 elements", old_ns, new_ns);
+
+    wl_event_loop_destroy(event_loop);
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Cost of emitting a signal with 0, 1 and 10 connected listeners, by name and
+ * through a typed wf::signal_t.
+ */
+#include <wayfire/object.hpp>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "benchmark.hpp"
+
+namespace
+{
+class provider_t : public wf::signal_provider_t
+{};
+
+struct bench_signal_data_t : public wf::signal_data_t
+{
+    int value = 1;
+};
+
+const long RUNS = 5'000'000;
+}
+
+int main()
+{
+    const wf::signal_t<bench_signal_data_t> typed_signal{"bench-signal"};
+    printf("listeners   by name      signal_t\n");
+
+    for (int listeners : {0, 1, 10})
+    {
+        long calls = 0;
+        wf::signal_callback_t callback = [&] (wf::signal_data_t *data)
+        {
+            calls += static_cast<bench_signal_data_t*>(data)->value;
+        };
+
+        provider_t provider;
+        std::vector<std::unique_ptr<wf::signal_connection_t>> connections;
+        for (int i = 0; i < listeners; i++)
+        {
+            connections.push_back(
+                std::make_unique<wf::signal_connection_t>(callback));
+            provider.connect_signal("bench-signal", connections.back().get());
+        }
+
+        bench_signal_data_t data;
+        double by_name = wf::benchmark::measure_ns(RUNS, [&] ()
+        {
+            provider.emit_signal("bench-signal", &data);
+        });
+        double by_id = wf::benchmark::measure_ns(RUNS, [&] ()
+        {
+            provider.emit_signal(typed_signal, &data);
+        });
+
+        wf::benchmark::keep(calls);
+        printf("%-11d %6.1f ns    %6.1f ns\n", listeners, by_name, by_id);
+    }
+
+    return 0;
+}
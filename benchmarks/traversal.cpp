@@ -0,0 +1,442 @@
+/*
+ * Traversal of deep surface and view trees: the recursive
+ * enumerate_surfaces() and enumerate_views(), which build a vector at every
+ * level, against the iterators behind traverse_surfaces() and
+ * traverse_views().
+ *
+ * Surfaces and views cannot be created without a running compositor, so the
+ * trees are built from stub nodes which have the members the traversal uses.
+ * The iterators run the walk from src/view/tree-walk.hpp, the same code as
+ * surface_tree_iterator_t and view_tree_iterator_t. The recursive functions
+ * are copies of the ones which were replaced, kept as the baseline. Before
+ * measuring, the benchmark checks that both visit the same nodes in the same
+ * order.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "tree-walk.hpp"
+
+namespace
+{
+struct point_t
+{
+    int x, y;
+};
+
+point_t operator +(const point_t& a, const point_t& b)
+{
+    return {a.x + b.x, a.y + b.y};
+}
+
+point_t operator -(const point_t& a, const point_t& b)
+{
+    return {a.x - b.x, a.y - b.y};
+}
+
+/* The parts of surface_interface_t used for traversal */
+struct surface_node_t
+{
+    struct impl
+    {
+        surface_node_t *parent_surface = nullptr;
+        std::vector<std::unique_ptr<surface_node_t>> surface_children_above;
+        std::vector<std::unique_ptr<surface_node_t>> surface_children_below;
+    };
+
+    std::unique_ptr<impl> priv = std::make_unique<impl>();
+    point_t offset = {0, 0};
+    bool mapped    = true;
+
+    bool is_mapped() const
+    {
+        return mapped;
+    }
+
+    point_t get_offset() const
+    {
+        return offset;
+    }
+};
+
+struct surface_position_t
+{
+    surface_node_t *surface;
+    point_t position;
+};
+
+/* The old surface_interface_t::enumerate_surfaces() */
+std::vector<surface_position_t> enumerate_surfaces(surface_node_t *surface,
+    point_t origin)
+{
+    std::vector<surface_position_t> result;
+    auto add_surfaces_recursive = [&] (surface_node_t *child)
+    {
+        if (!child->is_mapped())
+        {
+            return;
+        }
+
+        auto child_surfaces =
+            enumerate_surfaces(child, child->get_offset() + origin);
+        result.insert(result.end(),
+            child_surfaces.begin(), child_surfaces.end());
+    };
+
+    for (auto& child : surface->priv->surface_children_above)
+    {
+        add_surfaces_recursive(child.get());
+    }
+
+    if (surface->is_mapped())
+    {
+        result.push_back({surface, origin});
+    }
+
+    for (auto& child : surface->priv->surface_children_below)
+    {
+        add_surfaces_recursive(child.get());
+    }
+
+    return result;
+}
+
+/* surface_tree_iterator_t, with the same state as in wayfire/surface.hpp */
+class surface_tree_iterator_t
+{
+  public:
+    surface_tree_iterator_t() = default;
+    surface_tree_iterator_t(surface_node_t *root, point_t root_origin,
+        bool bottom_first)
+    {
+        this->root    = root;
+        this->current = {root, root_origin};
+        this->bottom_first = bottom_first;
+        advance();
+    }
+
+    const surface_position_t& operator *() const
+    {
+        return current;
+    }
+
+    surface_tree_iterator_t& operator ++()
+    {
+        advance();
+
+        return *this;
+    }
+
+    bool operator !=(const surface_tree_iterator_t& other) const
+    {
+        return current.surface != other.current.surface;
+    }
+
+  private:
+    surface_node_t *root = nullptr;
+    surface_position_t current = {nullptr, {0, 0}};
+    bool bottom_first = false;
+    bool in_first_children = true;
+    size_t visited_children = 0;
+
+    void advance()
+    {
+        wf::tree_walk::advance_surface(root, current, bottom_first,
+            in_first_children, visited_children);
+    }
+};
+
+/* The parts of view_interface_t used for traversal */
+struct view_node_t
+{
+    view_node_t *parent = nullptr;
+    std::vector<view_node_t*> children;
+    bool mapped = true;
+
+    bool is_mapped() const
+    {
+        return mapped;
+    }
+};
+
+/* The old view_interface_t::enumerate_views() */
+std::vector<view_node_t*> enumerate_views(view_node_t *view, bool mapped_only)
+{
+    if (!view->is_mapped() && mapped_only)
+    {
+        return {};
+    }
+
+    std::vector<view_node_t*> result;
+    for (auto& child : view->children)
+    {
+        auto child_views = enumerate_views(child, true);
+        result.insert(result.end(), child_views.begin(), child_views.end());
+    }
+
+    result.push_back(view);
+
+    return result;
+}
+
+/* view_tree_iterator_t, with the same state as in wayfire/view.hpp */
+class view_tree_iterator_t
+{
+  public:
+    view_tree_iterator_t() = default;
+    view_tree_iterator_t(view_node_t *root, bool mapped_only)
+    {
+        if (root->is_mapped() || !mapped_only)
+        {
+            this->root    = root;
+            this->current = root;
+            wf::tree_walk::descend_view(current, visited_children);
+        }
+    }
+
+    view_node_t *operator *() const
+    {
+        return current;
+    }
+
+    view_tree_iterator_t& operator ++()
+    {
+        wf::tree_walk::advance_view(root, current, visited_children);
+
+        return *this;
+    }
+
+    bool operator !=(const view_tree_iterator_t& other) const
+    {
+        return current != other.current;
+    }
+
+  private:
+    view_node_t *root    = nullptr;
+    view_node_t *current = nullptr;
+    size_t visited_children = 0;
+};
+
+template<class Iterator>
+struct iterator_range_t
+{
+    Iterator first, last;
+
+    Iterator begin() const
+    {
+        return first;
+    }
+
+    Iterator end() const
+    {
+        return last;
+    }
+};
+
+iterator_range_t<surface_tree_iterator_t> traverse_surfaces(
+    surface_node_t *surface, point_t origin, bool bottom_first = false)
+{
+    return {surface_tree_iterator_t{surface, origin, bottom_first},
+        surface_tree_iterator_t{}};
+}
+
+iterator_range_t<view_tree_iterator_t> traverse_views(view_node_t *view,
+    bool mapped_only)
+{
+    return {view_tree_iterator_t{view, mapped_only}, view_tree_iterator_t{}};
+}
+
+/* A fifth of the subsurfaces and child views are not mapped */
+std::mt19937 rng;
+
+void build_surface_tree(surface_node_t *surface, int depth, int fan_out)
+{
+    if (depth == 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < fan_out; i++)
+    {
+        auto child = std::make_unique<surface_node_t>();
+        child->priv->parent_surface = surface;
+        child->offset = {int(rng() % 50), int(rng() % 50)};
+        child->mapped = rng() % 5 != 0;
+        build_surface_tree(child.get(), depth - 1, fan_out);
+
+        auto& children = (rng() % 2) ?
+            surface->priv->surface_children_below :
+            surface->priv->surface_children_above;
+        children.insert(children.begin(), std::move(child));
+    }
+}
+
+void build_view_tree(view_node_t *view, int depth, int fan_out,
+    std::vector<std::unique_ptr<view_node_t>>& storage)
+{
+    if (depth == 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < fan_out; i++)
+    {
+        storage.push_back(std::make_unique<view_node_t>());
+        auto child = storage.back().get();
+        child->parent = view;
+        child->mapped = rng() % 5 != 0;
+        view->children.push_back(child);
+        build_view_tree(child, depth - 1, fan_out, storage);
+    }
+}
+
+bool check_surfaces(std::vector<surface_node_t>& roots)
+{
+    for (auto& root : roots)
+    {
+        auto expected = enumerate_surfaces(&root, {0, 0});
+        std::vector<surface_position_t> forward, backward;
+        for (auto& child : traverse_surfaces(&root, {0, 0}))
+        {
+            forward.push_back(child);
+        }
+
+        for (auto& child : traverse_surfaces(&root, {0, 0}, true))
+        {
+            backward.insert(backward.begin(), child);
+        }
+
+        auto same = [] (const surface_position_t& a, const surface_position_t& b)
+        {
+            return a.surface == b.surface && a.position.x == b.position.x &&
+                   a.position.y == b.position.y;
+        };
+        if (!std::equal(expected.begin(), expected.end(), forward.begin(),
+            forward.end(), same) ||
+            !std::equal(expected.begin(), expected.end(), backward.begin(),
+                backward.end(), same))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool bench_surfaces(const char *name, int depth, int fan_out, int num_views)
+{
+    rng.seed(7);
+    std::vector<surface_node_t> roots(num_views);
+    for (auto& root : roots)
+    {
+        build_surface_tree(&root, depth, fan_out);
+    }
+
+    if (!check_surfaces(roots))
+    {
+        printf("%s: the traversals differ\n", name);
+
+        return false;
+    }
+
+    size_t count = 0;
+    for (auto& root : roots)
+    {
+        for (auto& child : traverse_surfaces(&root, {0, 0}))
+        {
+            count += (child.surface != nullptr);
+        }
+    }
+
+    long sum = 0;
+    double recursive = wf::benchmark::measure_ns(2000, [&] ()
+    {
+        for (auto& root : roots)
+        {
+            for (auto& child : enumerate_surfaces(&root, {0, 0}))
+            {
+                sum += child.position.x;
+            }
+        }
+    });
+    double iterator = wf::benchmark::measure_ns(2000, [&] ()
+    {
+        for (auto& root : roots)
+        {
+            for (auto& child : traverse_surfaces(&root, {0, 0}))
+            {
+                sum += child.position.x;
+            }
+        }
+    });
+
+    wf::benchmark::keep(sum);
+    printf("%s, %zu surfaces in %d views: %.2f us -> %.2f us\n", name, count,
+        num_views, recursive / 1000, iterator / 1000);
+
+    return true;
+}
+
+bool bench_views(const char *name, int depth, int fan_out, int num_views)
+{
+    rng.seed(7);
+    std::vector<std::unique_ptr<view_node_t>> storage;
+    std::vector<view_node_t> roots(num_views);
+    for (auto& root : roots)
+    {
+        build_view_tree(&root, depth, fan_out, storage);
+        std::vector<view_node_t*> visited;
+        for (auto view : traverse_views(&root, true))
+        {
+            visited.push_back(view);
+        }
+
+        if (visited != enumerate_views(&root, true))
+        {
+            printf("%s: the traversals differ\n", name);
+
+            return false;
+        }
+    }
+
+    long count = 0;
+    double recursive = wf::benchmark::measure_ns(2000, [&] ()
+    {
+        for (auto& root : roots)
+        {
+            count += enumerate_views(&root, true).size();
+        }
+    });
+    double iterator = wf::benchmark::measure_ns(2000, [&] ()
+    {
+        for (auto& root : roots)
+        {
+            for (auto view : traverse_views(&root, true))
+            {
+                count += (view != nullptr);
+            }
+        }
+    });
+
+    wf::benchmark::keep(count);
+    printf("%s, %d view trees: %.2f us -> %.2f us\n", name, num_views,
+        recursive / 1000, iterator / 1000);
+
+    return true;
+}
+}
+
+int main()
+{
+    printf("Time per pass over all views, recursive -> iterator\n");
+    bool ok = bench_surfaces("Firefox-like, depth 4, fan-out 2", 4, 2, 20) &&
+        bench_surfaces("Electron popup chains, depth 8", 8, 1, 20) &&
+        bench_surfaces("flat, depth 1, fan-out 3", 1, 3, 50) &&
+        bench_views("dialog chains, depth 3, fan-out 2", 3, 2, 20);
+
+    return ok ? 0 : 1;
+}
@@ -70,7 +70,7 @@ struct animation_hook : public animation_hook_base
         if (new_output)
         {
             new_output->render->add_effect(&update_animation_hook,
-                wf::OUTPUT_EFFECT_PRE);
+                wf::OUTPUT_EFFECT_PRE, "animate");
         }
 
         current_output = new_output;
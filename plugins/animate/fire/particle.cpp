@@ -181,6 +181,13 @@ void ParticleSystem::create_program()
     OpenGL::render_begin();
     program.set_simple(OpenGL::compile_program(particle_vert_source,
         particle_frag_source));
+
+    handles.position  = program.get_attrib("position");
+    handles.radius    = program.get_attrib("radius");
+    handles.center    = program.get_attrib("center");
+    handles.color     = program.get_attrib("color");
+    handles.matrix    = program.get_uniform("matrix");
+    handles.smoothing = program.get_uniform("smoothing");
     OpenGL::render_end();
 }
 
@@ -194,33 +201,33 @@ void ParticleSystem::render(glm::mat4 matrix)
         -1, 1
     };
 
-    program.attrib_pointer("position", 2, 0, vertex_data);
-    program.attrib_divisor("position", 0);
+    program.attrib_pointer(handles.position, 2, 0, vertex_data);
+    program.attrib_divisor(handles.position, 0);
 
-    program.attrib_pointer("radius", 1, 0, radius.data());
-    program.attrib_divisor("radius", 1);
+    program.attrib_pointer(handles.radius, 1, 0, radius.data());
+    program.attrib_divisor(handles.radius, 1);
 
-    program.attrib_pointer("center", 2, 0, center.data());
-    program.attrib_divisor("center", 1);
+    program.attrib_pointer(handles.center, 2, 0, center.data());
+    program.attrib_divisor(handles.center, 1);
 
     // matrix
-    program.uniformMatrix4f("matrix", matrix);
+    program.uniformMatrix4f(handles.matrix, matrix);
 
     /* Darken the background */
-    program.attrib_pointer("color", 4, 0, dark_color.data());
-    program.attrib_divisor("color", 1);
+    program.attrib_pointer(handles.color, 4, 0, dark_color.data());
+    program.attrib_divisor(handles.color, 1);
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ZERO, GL_ONE_MINUS_SRC_ALPHA));
-    program.uniform1f("smoothing", 0.7);
+    program.uniform1f(handles.smoothing, 0.7);
 
     // TODO: optimize shaders for this case
     GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, ps.size()));
 
     // particle color
-    program.attrib_pointer("color", 4, 0, color.data());
+    program.attrib_pointer(handles.color, 4, 0, color.data());
     GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE));
-    program.uniform1f("smoothing", 0.5);
+    program.uniform1f(handles.smoothing, 0.5);
     GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, ps.size()));
 
     GL_CALL(glDisable(GL_BLEND));
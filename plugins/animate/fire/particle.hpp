@@ -77,6 +77,13 @@ class ParticleSystem
     std::vector<float> center;
 
     OpenGL::program_t program;
+    /* Handles of the shader inputs, resolved in create_program() */
+    struct
+    {
+        OpenGL::program_t::attrib_t position, radius, center, color;
+        OpenGL::program_t::uniform_t matrix, smoothing;
+    } handles;
+
     void exec_worker_threads(std::function<void(int, int)> spawn_worker);
     void update_worker(float time, int start, int end);
     void create_program();
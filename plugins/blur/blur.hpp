@@ -96,6 +96,12 @@ class wf_blur_base
     /* the program used by wf_blur_base to combine the blurred, unblurred and
      * view texture */
     OpenGL::program_t blend_program;
+    /* Handles of the inputs of blend_program */
+    struct
+    {
+        OpenGL::program_t::attrib_t position;
+        OpenGL::program_t::uniform_t mvp, bg_texture;
+    } blend_handles;
 
     /* used to get individual algorithm options from config
      * should be set by the constructor */
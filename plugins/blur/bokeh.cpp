@@ -56,12 +56,23 @@ void main()
 
 class wf_bokeh_blur : public wf_blur_base
 {
+    /* Handles of the inputs of program[0], resolved in the constructor */
+    struct
+    {
+        OpenGL::program_t::attrib_t position;
+        OpenGL::program_t::uniform_t halfpixel, offset, iterations;
+    } handles;
+
   public:
     wf_bokeh_blur(wf::output_t *output) : wf_blur_base(output, "bokeh")
     {
         OpenGL::render_begin();
         program[0].set_simple(OpenGL::compile_program(bokeh_vertex_shader,
             bokeh_fragment_shader));
+        handles.position   = program[0].get_attrib("position");
+        handles.halfpixel  = program[0].get_uniform("halfpixel");
+        handles.offset     = program[0].get_uniform("offset");
+        handles.iterations = program[0].get_uniform("iterations");
         OpenGL::render_end();
     }
 
@@ -80,11 +91,11 @@ class wf_bokeh_blur : public wf_blur_base
         OpenGL::render_begin();
         /* Upload data to shader */
         program[0].use(wf::TEXTURE_TYPE_RGBA);
-        program[0].uniform2f("halfpixel", 0.5f / width, 0.5f / height);
-        program[0].uniform1f("offset", offset);
-        program[0].uniform1i("iterations", iterations);
+        program[0].uniform2f(handles.halfpixel, 0.5f / width, 0.5f / height);
+        program[0].uniform1f(handles.offset, offset);
+        program[0].uniform1i(handles.iterations, iterations);
 
-        program[0].attrib_pointer("position", 2, 0, vertexData);
+        program[0].attrib_pointer(handles.position, 2, 0, vertexData);
         GL_CALL(glDisable(GL_BLEND));
         render_iteration(blur_region, fb[0], fb[1], width, height);
 
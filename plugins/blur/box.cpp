@@ -70,6 +70,13 @@ void main()
 
 class wf_box_blur : public wf_blur_base
 {
+    /* Handles of the inputs of program[i], resolved in the constructor */
+    struct
+    {
+        OpenGL::program_t::attrib_t position;
+        OpenGL::program_t::uniform_t size, offset;
+    } handles[2];
+
   public:
     void get_id_locations(int i)
     {}
@@ -81,6 +88,14 @@ class wf_box_blur : public wf_blur_base
             box_vertex_shader, box_fragment_shader_horz));
         program[1].set_simple(OpenGL::compile_program(
             box_vertex_shader, box_fragment_shader_vert));
+
+        for (int i = 0; i < 2; i++)
+        {
+            handles[i].position = program[i].get_attrib("position");
+            handles[i].size     = program[i].get_uniform("size");
+            handles[i].offset   = program[i].get_uniform("offset");
+        }
+
         OpenGL::render_end();
     }
 
@@ -95,9 +110,9 @@ class wf_box_blur : public wf_blur_base
         };
 
         program[i].use(wf::TEXTURE_TYPE_RGBA);
-        program[i].uniform2f("size", width, height);
-        program[i].uniform1f("offset", offset);
-        program[i].attrib_pointer("position", 2, 0, vertexData);
+        program[i].uniform2f(handles[i].size, width, height);
+        program[i].uniform1f(handles[i].offset, offset);
+        program[i].attrib_pointer(handles[i].position, 2, 0, vertexData);
     }
 
     void blur(const wf::region_t& blur_region, int i, int width, int height)
@@ -77,15 +77,20 @@ class workspace_stream_pool_t : public noncopyable_t, public wf::custom_data_t
      * Update the contents of the given workspace.
      *
      * If the workspace has not been started before, it will be started.
+     *
+     * @param scale_x The horizontal scale to render the workspace with.
+     * @param scale_y The vertical scale to render the workspace with.
      */
-    void update(wf::point_t workspace)
+    void update(wf::point_t workspace, float scale_x = 1, float scale_y = 1)
     {
         auto& stream = get(workspace);
         if (stream.running)
         {
-            output->render->workspace_stream_update(stream);
+            output->render->workspace_stream_update(stream, scale_x, scale_y);
         } else
         {
+            stream.scale_x = scale_x;
+            stream.scale_y = scale_y;
             output->render->workspace_stream_start(stream);
         }
     }
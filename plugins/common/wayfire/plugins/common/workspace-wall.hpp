@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 #include "workspace-stream-sharing.hpp"
 
@@ -10,11 +11,17 @@ namespace wf
  * When the workspace wall is rendered via a render hook, the frame event
  * is emitted on each frame.
  *
- * The target framebuffer is passed as signal data.
+ * The target framebuffer is passed as signal data. Listeners which draw on
+ * top of the wall must add the area they draw to to damage, so that the wall
+ * includes it in the damage of the frame and repaints it in the next one.
  */
 struct wall_frame_event_t : public signal_data_t
 {
     const wf::framebuffer_t& target;
+    /* The region of target drawn by the listeners, in the same coordinate
+     * system as the framebuffer's geometry */
+    wf::region_t damage;
+
     wall_frame_event_t(const wf::framebuffer_t& t) : target(t)
     {}
 };
@@ -48,6 +55,7 @@ class workspace_wall_t : public wf::signal_provider_t
     void set_background_color(const wf::color_t& color)
     {
         this->background_color = color;
+        this->needs_full_repaint = true;
     }
 
     /**
@@ -59,6 +67,7 @@ class workspace_wall_t : public wf::signal_provider_t
     void set_gap_size(int size)
     {
         this->gap_size = size;
+        this->needs_full_repaint = true;
     }
 
     /**
@@ -102,29 +111,60 @@ class workspace_wall_t : public wf::signal_provider_t
      */
     void render_wall(const wf::framebuffer_t& fb, wf::geometry_t geometry)
     {
-        update_streams();
+        render_wall(fb, geometry, geometry);
+    }
 
-        OpenGL::render_begin(fb);
-        fb.logic_scissor(geometry);
+    /**
+     * Render the selected viewport on the framebuffer, but repaint only the
+     * parts which have changed since the last frame or which are damaged.
+     *
+     * @param fb The framebuffer to render on.
+     * @param geometry The rectangle in fb to draw to, in the same coordinate
+     *   system as the framebuffer's geometry.
+     * @param damage The region of fb which has to be repainted in any case,
+     *   in the same coordinate system as the framebuffer's geometry.
+     *
+     * @return The region of fb whose contents changed since the last frame,
+     *   including the parts drawn by the listeners of the frame event.
+     */
+    wf::region_t render_wall(const wf::framebuffer_t& fb,
+        wf::geometry_t geometry, const wf::region_t& damage)
+    {
+        /* Must be calculated before the streams are updated, because starting
+         * a stream damages it. What the frame listeners drew in the last frame
+         * has to be painted over, otherwise they would blend on top of it. */
+        wf::region_t changed = calculate_wall_damage(geometry);
+        changed |= last_frame_damage & geometry;
+        update_streams(geometry);
 
-        OpenGL::clear(this->background_color);
         auto wall_matrix =
             calculate_viewport_transformation_matrix(this->viewport, geometry);
         /* After all transformations of the framebuffer, the workspace should
          * span the visible part of the OpenGL coordinate space. */
         const wf::geometry_t workspace_geometry = {-1, 1, 2, -2};
-        for (auto& ws : get_visible_workspaces(this->viewport))
+        auto visible = get_visible_workspaces(this->viewport);
+
+        OpenGL::render_begin(fb);
+        for (const auto& rect : (changed | damage) & geometry)
         {
-            auto ws_matrix = calculate_workspace_matrix(ws);
-            OpenGL::render_transformed_texture(
-                streams->get(ws).buffer.tex, workspace_geometry,
-                fb.get_orthographic_projection() * wall_matrix * ws_matrix);
+            fb.logic_scissor(wlr_box_from_pixman_box(rect));
+            OpenGL::clear(this->background_color);
+            for (auto& ws : visible)
+            {
+                auto ws_matrix = calculate_workspace_matrix(ws);
+                OpenGL::render_transformed_texture(
+                    streams->get(ws).buffer.tex, workspace_geometry,
+                    fb.get_orthographic_projection() * wall_matrix * ws_matrix);
+            }
         }
 
         OpenGL::render_end();
 
         wall_frame_event_t data{fb};
         this->emit_signal("frame", &data);
+        last_frame_damage = data.damage;
+
+        return changed | data.damage;
     }
 
     /**
@@ -135,8 +175,9 @@ class workspace_wall_t : public wf::signal_provider_t
     {
         if (!render_hook_set)
         {
-            this->output->render->set_renderer(on_render);
-            render_hook_set = true;
+            this->output->render->set_damage_renderer(on_render);
+            render_hook_set    = true;
+            needs_full_repaint = true;
         }
     }
 
@@ -203,12 +244,100 @@ class workspace_wall_t : public wf::signal_provider_t
     wf::geometry_t viewport = {0, 0, 0, 0};
     nonstd::observer_ptr<workspace_stream_pool_t> streams;
 
+    /* Whether the whole wall has to be repainted in the next frame */
+    bool needs_full_repaint = true;
+    /* The viewport and target rectangle of the last rendered frame */
+    wf::geometry_t last_viewport = {0, 0, 0, 0};
+    wf::geometry_t last_geometry = {0, 0, 0, 0};
+    /* The region drawn by the frame listeners in the last frame */
+    wf::region_t last_frame_damage;
+
+    /**
+     * Calculate which part of the target rectangle changes in the current
+     * frame. These are the damaged parts of the visible workspaces, or the
+     * whole rectangle if the wall itself has changed.
+     *
+     * @param geometry The rectangle the wall is rendered to.
+     */
+    wf::region_t calculate_wall_damage(wf::geometry_t geometry)
+    {
+        if (needs_full_repaint || (geometry != last_geometry) ||
+            (viewport != last_viewport) ||
+            (viewport.width <= 0) || (viewport.height <= 0))
+        {
+            needs_full_repaint = false;
+            last_geometry = geometry;
+            last_viewport = viewport;
+
+            return geometry;
+        }
+
+        const double scale_x = geometry.width * 1.0 / viewport.width;
+        const double scale_y = geometry.height * 1.0 / viewport.height;
+
+        wf::region_t damage;
+        for (auto& ws : get_visible_workspaces(viewport))
+        {
+            /* The stream was not running, so it will be fully repainted */
+            auto ws_box    = output->render->get_ws_box(ws);
+            auto scheduled = output->render->get_ws_damage(ws);
+            if (!streams->get(ws).running)
+            {
+                scheduled |= ws_box;
+            }
+
+            auto ws_rect = get_workspace_rectangle(ws);
+            for (const auto& rect : scheduled & ws_box)
+            {
+                /* From output-local coordinates to the wall, and from the wall
+                 * to the target rectangle */
+                double x1 = rect.x1 - ws_box.x + ws_rect.x - viewport.x;
+                double y1 = rect.y1 - ws_box.y + ws_rect.y - viewport.y;
+                double x2 = rect.x2 - ws_box.x + ws_rect.x - viewport.x;
+                double y2 = rect.y2 - ws_box.y + ws_rect.y - viewport.y;
+
+                int tx1 = std::floor(geometry.x + x1 * scale_x);
+                int ty1 = std::floor(geometry.y + y1 * scale_y);
+                int tx2 = std::ceil(geometry.x + x2 * scale_x);
+                int ty2 = std::ceil(geometry.y + y2 * scale_y);
+                damage |= wf::geometry_t{tx1, ty1, tx2 - tx1, ty2 - ty1};
+            }
+        }
+
+        return damage & geometry;
+    }
+
+    /**
+     * Calculate the scale at which to render the workspace streams, when the
+     * viewport is rendered to the given rectangle.
+     *
+     * The scale is rounded up to 1/N, so that the streams are not repainted
+     * on every frame of a zoom animation.
+     */
+    float calculate_stream_scale(wf::geometry_t geometry) const
+    {
+        if ((viewport.width <= 0) || (viewport.height <= 0))
+        {
+            return 1;
+        }
+
+        double scale = std::max(geometry.width * 1.0 / viewport.width,
+            geometry.height * 1.0 / viewport.height);
+        if (scale >= 1)
+        {
+            return 1;
+        }
+
+        return 1.0 / std::max(1.0, std::floor(1.0 / scale));
+    }
+
     /** Update or start visible streams */
-    void update_streams()
+    void update_streams(wf::geometry_t geometry)
     {
+        float scale = calculate_stream_scale(geometry);
         for (auto& ws : get_visible_workspaces(viewport))
         {
-            streams->update(ws);
+            streams->update(ws, scale, scale);
         }
     }
 
@@ -277,9 +406,11 @@ class workspace_wall_t : public wf::signal_provider_t
     }
 
     bool render_hook_set = false;
-    wf::render_hook_t on_render = [=] (const wf::framebuffer_t& target)
+    wf::damage_render_hook_t on_render = [=] (const wf::framebuffer_t& target,
+                                              const wf::region_t& damage)
     {
-        render_wall(target, this->output->get_relative_geometry());
+        return render_wall(target, this->output->get_relative_geometry(),
+            damage);
     };
 };
 }
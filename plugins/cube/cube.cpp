@@ -50,6 +50,12 @@ class wayfire_cube : public wf::plugin_interface_t
     float identity_z_offset;
 
     OpenGL::program_t program;
+    /* Handles of the shader inputs, resolved in load_program() */
+    struct
+    {
+        OpenGL::program_t::attrib_t position, uv_position;
+        OpenGL::program_t::uniform_t model, vp, deform, light, ease;
+    } handles;
 
     wf_cube_animation_attribs animation;
     wf::option_wrapper_t<bool> use_light{"cube/light"};
@@ -220,6 +226,14 @@ class wayfire_cube : public wf::plugin_interface_t
 #endif
         }
 
+        handles.position    = program.get_attrib("position");
+        handles.uv_position = program.get_attrib("uvPosition");
+        handles.model  = program.get_uniform("model");
+        handles.vp     = program.get_uniform("VP");
+        handles.deform = program.get_uniform("deform");
+        handles.light  = program.get_uniform("light");
+        handles.ease   = program.get_uniform("ease");
+
         streams = wf::workspace_stream_pool_t::ensure_pool(output);
         animation.projection = glm::perspective(45.0f, 1.f, 0.1f, 100.f);
     }
@@ -480,7 +494,7 @@ class wayfire_cube : public wf::plugin_interface_t
                 streams->get({index, cws.y}).buffer.tex));
 
             auto model = calculate_model_matrix(i, fb_transform);
-            program.uniformMatrix4f("model", model);
+            program.uniformMatrix4f(handles.model, model);
 
             if (tessellation_support)
             {
@@ -531,14 +545,14 @@ class wayfire_cube : public wf::plugin_interface_t
             0.0f, 0.0f
         };
 
-        program.attrib_pointer("position", 2, 0, vertexData);
-        program.attrib_pointer("uvPosition", 2, 0, coordData);
-        program.uniformMatrix4f("VP", vp);
+        program.attrib_pointer(handles.position, 2, 0, vertexData);
+        program.attrib_pointer(handles.uv_position, 2, 0, coordData);
+        program.uniformMatrix4f(handles.vp, vp);
         if (tessellation_support)
         {
-            program.uniform1i("deform", use_deform);
-            program.uniform1i("light", use_light);
-            program.uniform1f("ease",
+            program.uniform1i(handles.deform, use_deform);
+            program.uniform1i(handles.light, use_light);
+            program.uniform1f(handles.ease,
                 animation.cube_animation.ease_deformation);
         }
 
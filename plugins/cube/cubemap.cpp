@@ -25,6 +25,8 @@ void wf_cube_background_cubemap::create_program()
     OpenGL::render_begin();
     program.set_simple(
         OpenGL::compile_program(cubemap_vertex, cubemap_fragment));
+    position_attrib = program.get_attrib("position");
+    matrix_uniform  = program.get_uniform("cubeMapMatrix");
     OpenGL::render_end();
 }
 
@@ -43,23 +45,33 @@ void wf_cube_background_cubemap::reload_texture()
         GL_CALL(glGenTextures(1, &tex));
     }
 
-    GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, tex));
+    OpenGL::render_end();
+
+    std::vector<GLenum> faces;
     for (int i = 0; i < 6; i++)
     {
-        if (!image_io::load_from_file(last_background_image,
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i))
-        {
-            LOGE("Failed to load cubemap background image from \"%s\".",
-                last_background_image.c_str());
-
-            GL_CALL(glDeleteTextures(1, &tex));
-            tex = -1;
-            break;
-        }
+        faces.push_back(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
     }
 
-    if (tex != (uint32_t)-1)
+    /* Large images take a while to decode, so they are loaded in the
+     * background, see the loading check in render_frame() */
+    texture_load = image_io::load_from_file_async(last_background_image, tex,
+        faces, [=] (bool success) { texture_loaded(success); });
+}
+
+void wf_cube_background_cubemap::texture_loaded(bool success)
+{
+    OpenGL::render_begin();
+    if (!success)
+    {
+        LOGE("Failed to load cubemap background image from \"%s\".",
+            last_background_image.c_str());
+
+        GL_CALL(glDeleteTextures(1, &tex));
+        tex = -1;
+    } else
     {
+        GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, tex));
         GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
             GL_LINEAR));
         GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER,
@@ -84,6 +96,15 @@ void wf_cube_background_cubemap::render_frame(const wf::framebuffer_t& fb,
     reload_texture();
 
     OpenGL::render_begin(fb);
+    if (texture_load && !texture_load->is_done())
+    {
+        GL_CALL(glClearColor(0, 0, 0, 1));
+        GL_CALL(glClear(GL_COLOR_BUFFER_BIT));
+        OpenGL::render_end();
+
+        return;
+    }
+
     if (tex == (uint32_t)-1)
     {
         GL_CALL(glClearColor(TEX_ERROR_FLAG_COLOR));
@@ -97,7 +118,7 @@ void wf_cube_background_cubemap::render_frame(const wf::framebuffer_t& fb,
     GL_CALL(glDepthMask(GL_FALSE));
 
     GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, tex));
-    program.attrib_pointer("position", 3, 0, skyboxVertices);
+    program.attrib_pointer(position_attrib, 3, 0, skyboxVertices);
 
     auto model = glm::rotate(glm::mat4(1.0),
         float(attribs.cube_animation.rotation * 0.7f),
@@ -111,7 +132,7 @@ void wf_cube_background_cubemap::render_frame(const wf::framebuffer_t& fb,
     auto vp   = fb.transform * attribs.projection * view;
 
     model = vp * model;
-    program.uniformMatrix4f("cubeMapMatrix", model);
+    program.uniformMatrix4f(matrix_uniform, model);
 
     GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 6 * 6));
 
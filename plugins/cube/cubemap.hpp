@@ -2,6 +2,7 @@
 #define WF_CUBE_CUBEMAP_HPP
 
 #include "cube-background.hpp"
+#include <wayfire/img.hpp>
 
 class wf_cube_background_cubemap : public wf_cube_background_base
 {
@@ -14,10 +15,17 @@ class wf_cube_background_cubemap : public wf_cube_background_base
 
   private:
     void reload_texture();
+    void texture_loaded(bool success);
     void create_program();
 
     OpenGL::program_t program;
+    /* Handles of the shader inputs, resolved in create_program() */
+    OpenGL::program_t::attrib_t position_attrib;
+    OpenGL::program_t::uniform_t matrix_uniform;
+
     GLuint tex = -1;
+    /* The load of the texture, if one was started */
+    std::unique_ptr<image_io::async_load_t> texture_load;
 
     std::string last_background_image;
     wf::option_wrapper_t<std::string> background_image{"cube/cubemap_image"};
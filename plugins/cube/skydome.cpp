@@ -30,6 +30,10 @@ void wf_cube_background_skydome::load_program()
 {
     OpenGL::render_begin();
     program.set_simple(OpenGL::compile_program(cube_vertex_2_0, cube_fragment_2_0));
+    handles.position    = program.get_attrib("position");
+    handles.uv_position = program.get_attrib("uvPosition");
+    handles.vp    = program.get_uniform("VP");
+    handles.model = program.get_uniform("model");
     OpenGL::render_end();
 }
 
@@ -48,14 +52,25 @@ void wf_cube_background_skydome::reload_texture()
         GL_CALL(glGenTextures(1, &tex));
     }
 
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+    OpenGL::render_end();
+
+    /* Large images take a while to decode, so they are loaded in the
+     * background, see the loading check in render_frame() */
+    texture_load = image_io::load_from_file_async(last_background_image, tex,
+        {GL_TEXTURE_2D}, [=] (bool success) { texture_loaded(success); });
+}
 
-    if (image_io::load_from_file(last_background_image, GL_TEXTURE_2D))
+void wf_cube_background_skydome::texture_loaded(bool success)
+{
+    OpenGL::render_begin();
+    if (success)
     {
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
     } else
     {
         LOGE("Failed to load skydome image from \"%s\".",
@@ -64,8 +79,6 @@ void wf_cube_background_skydome::reload_texture()
         tex = -1;
     }
 
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-
     OpenGL::render_end();
 }
 
@@ -130,6 +143,14 @@ void wf_cube_background_skydome::render_frame(const wf::framebuffer_t& fb,
     fill_vertices();
     reload_texture();
 
+    if (texture_load && !texture_load->is_done())
+    {
+        GL_CALL(glClearColor(0, 0, 0, 1));
+        GL_CALL(glClear(GL_COLOR_BUFFER_BIT));
+
+        return;
+    }
+
     if (tex == (uint32_t)-1)
     {
         GL_CALL(glClearColor(TEX_ERROR_FLAG_COLOR));
@@ -150,17 +171,17 @@ void wf_cube_background_skydome::render_frame(const wf::framebuffer_t& fb,
         glm::vec3(0., 1., 0.));
 
     auto vp = fb.transform * attribs.projection * view * rotation;
-    program.uniformMatrix4f("VP", vp);
+    program.uniformMatrix4f(handles.vp, vp);
 
-    program.attrib_pointer("position", 3, 0, vertices.data());
-    program.attrib_pointer("uvPosition", 2, 0, coords.data());
+    program.attrib_pointer(handles.position, 3, 0, vertices.data());
+    program.attrib_pointer(handles.uv_position, 2, 0, coords.data());
 
     auto cws   = output->workspace->get_current_workspace();
     auto model = glm::rotate(glm::mat4(1.0),
         float(attribs.cube_animation.rotation) - cws.x * attribs.side_angle,
         glm::vec3(0, 1, 0));
 
-    program.uniformMatrix4f("model", model);
+    program.uniformMatrix4f(handles.model, model);
 
     GL_CALL(glActiveTexture(GL_TEXTURE0));
     GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
@@ -3,6 +3,7 @@
 
 #include "cube-background.hpp"
 #include "wayfire/output.hpp"
+#include <wayfire/img.hpp>
 #include <vector>
 
 class wf_cube_background_skydome : public wf_cube_background_base
@@ -20,9 +21,19 @@ class wf_cube_background_skydome : public wf_cube_background_base
     void load_program();
     void fill_vertices();
     void reload_texture();
+    void texture_loaded(bool success);
 
     OpenGL::program_t program;
+    /* Handles of the shader inputs, resolved in load_program() */
+    struct
+    {
+        OpenGL::program_t::attrib_t position, uv_position;
+        OpenGL::program_t::uniform_t vp, model;
+    } handles;
+
     GLuint tex = -1;
+    /* The load of the texture, if one was started */
+    std::unique_ptr<image_io::async_load_t> texture_load;
 
     std::vector<GLfloat> vertices;
     std::vector<GLfloat> coords;
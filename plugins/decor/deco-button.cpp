@@ -66,11 +66,8 @@ void button_t::set_pressed(bool is_pressed)
 void button_t::render(const wf::framebuffer_t& fb, wf::geometry_t geometry,
     wf::geometry_t scissor)
 {
-    OpenGL::render_begin(fb);
-    fb.logic_scissor(scissor);
-    OpenGL::render_texture(button_texture.tex, fb, geometry, {1, 1, 1, 1},
-        OpenGL::TEXTURE_TRANSFORM_INVERT_Y);
-    OpenGL::render_end();
+    OpenGL::batch_texture(button_texture.tex, fb, geometry, scissor,
+        {1, 1, 1, 1}, OpenGL::TEXTURE_TRANSFORM_INVERT_Y);
 
     if (this->hover.running())
     {
@@ -61,7 +61,7 @@ class button_t : public noncopyable_t
      * Render the button on the given framebuffer at the given coordinates.
      * Precondition: set_button_type() has been called, otherwise result is no-op
      *
-     * @param buffer The target framebuffer
+     * @param buffer The target framebuffer, must have been bound already
      * @param geometry The geometry of the button, in logical coordinates
      * @param scissor The scissor rectangle to render.
      */
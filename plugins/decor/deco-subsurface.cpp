@@ -109,48 +109,67 @@ class simple_decoration_surface : public wf::surface_interface_t,
     }
 
     void render_title(const wf::framebuffer_t& fb,
-        wf::geometry_t geometry)
+        wf::geometry_t geometry, const wlr_box& scissor)
     {
-        update_title(geometry.width, geometry.height, fb.scale);
-        OpenGL::render_texture(title_texture.tex.tex, fb, geometry,
+        OpenGL::batch_texture(title_texture.tex.tex, fb, geometry, scissor,
             glm::vec4(1.0f), OpenGL::TEXTURE_TRANSFORM_INVERT_Y);
     }
 
-    void render_scissor_box(const wf::framebuffer_t& fb, wf::point_t origin,
-        const wlr_box& scissor)
+    virtual void simple_render(const wf::framebuffer_t& fb, int x, int y,
+        const wf::region_t& damage) override
     {
-        /* Clear background */
-        wlr_box geometry{origin.x, origin.y, width, height};
-        theme.render_background(fb, geometry, scissor, active);
+        wf::region_t frame = this->cached_region + wf::point_t{x, y};
+        frame &= damage;
 
-        /* Draw title & buttons */
-        auto renderables = layout.get_renderable_areas();
+        if (frame.empty())
+        {
+            return;
+        }
+
+        wf::point_t origin = {x, y};
+        auto renderables   = layout.get_renderable_areas();
+
+        OpenGL::render_begin(fb);
+        /* Upload the title before queueing anything, so that no texture
+         * changes while it is queued for drawing */
         for (auto item : renderables)
         {
             if (item->get_type() == wf::decor::DECORATION_AREA_TITLE)
             {
-                OpenGL::render_begin(fb);
-                fb.logic_scissor(scissor);
-                render_title(fb, item->get_geometry() + origin);
-                OpenGL::render_end();
-            } else // button
-            {
-                item->as_button().render(fb,
-                    item->get_geometry() + origin, scissor);
+                auto title = item->get_geometry();
+                update_title(title.width, title.height, fb.scale);
             }
         }
-    }
 
-    virtual void simple_render(const wf::framebuffer_t& fb, int x, int y,
-        const wf::region_t& damage) override
-    {
-        wf::region_t frame = this->cached_region + wf::point_t{x, y};
-        frame &= damage;
+        /* The damaged boxes don't overlap, so we draw each layer in all boxes
+         * at once. This way, each layer needs only a single draw call. */
 
+        /* Clear background */
+        wlr_box geometry{origin.x, origin.y, width, height};
         for (const auto& box : frame)
         {
-            render_scissor_box(fb, {x, y}, wlr_box_from_pixman_box(box));
+            theme.render_background(fb, geometry,
+                wlr_box_from_pixman_box(box), active);
+        }
+
+        /* Draw title & buttons */
+        for (auto item : renderables)
+        {
+            for (const auto& box : frame)
+            {
+                auto scissor = wlr_box_from_pixman_box(box);
+                if (item->get_type() == wf::decor::DECORATION_AREA_TITLE)
+                {
+                    render_title(fb, item->get_geometry() + origin, scissor);
+                } else // button
+                {
+                    item->as_button().render(fb,
+                        item->get_geometry() + origin, scissor);
+                }
+            }
         }
+
+        OpenGL::render_end();
     }
 
     bool accepts_input(int32_t sx, int32_t sy) override
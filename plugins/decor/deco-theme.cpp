@@ -37,17 +37,14 @@ int decoration_theme_t::get_border_size() const
  *
  * @param fb The target framebuffer, must have been bound already
  * @param rectangle The rectangle to redraw.
- * @param scissor The GL scissor rectangle to use.
+ * @param scissor The part of the rectangle to redraw.
  * @param active Whether to use active or inactive colors
  */
 void decoration_theme_t::render_background(const wf::framebuffer_t& fb,
     wf::geometry_t rectangle, const wf::geometry_t& scissor, bool active) const
 {
     wf::color_t color = active ? active_color : inactive_color;
-    OpenGL::render_begin(fb);
-    fb.logic_scissor(scissor);
-    OpenGL::render_rectangle(rectangle, color, fb.get_orthographic_projection());
-    OpenGL::render_end();
+    OpenGL::batch_rectangle(fb, rectangle, scissor, color);
 }
 
 /**
@@ -26,7 +26,7 @@ class decoration_theme_t
      *
      * @param fb The target framebuffer, must have been bound already.
      * @param rectangle The rectangle to redraw.
-     * @param scissor The GL scissor rectangle to use.
+     * @param scissor The part of the rectangle to redraw.
      * @param active Whether to use active or inactive colors
      */
     void render_background(const wf::framebuffer_t& fb, wf::geometry_t rectangle,
@@ -270,8 +270,14 @@ class wayfire_command : public wf::plugin_interface_t
         using namespace std::placeholders;
 
         setup_bindings_from_config();
-        reload_config = [=] (wf::signal_data_t*)
+        reload_config = [=] (wf::signal_data_t *data)
         {
+            auto ev = static_cast<wf::reload_config_signal*>(data);
+            if (!ev->section_changed("command"))
+            {
+                return;
+            }
+
             clear_bindings();
             setup_bindings_from_config();
         };
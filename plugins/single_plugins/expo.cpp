@@ -517,7 +517,9 @@ class wayfire_expo : public wf::plugin_interface_t
         /* TODO: adjust to delimiter offset */
         wlr_box box = {local.x, local.y, 1, 1};
 
-        for (auto& view : output->workspace->get_views_in_layer(wf::WM_LAYERS))
+        auto views = output->workspace->get_views_in_layer_snapshot(
+            wf::WM_LAYERS);
+        for (auto& view : *views)
         {
             if (view->intersects_region(box))
             {
@@ -107,6 +107,11 @@ class wayfire_fisheye : public wf::plugin_interface_t
     wf::option_wrapper_t<double> zoom{"fisheye/zoom"};
 
     OpenGL::program_t program;
+    struct
+    {
+        OpenGL::program_t::attrib_t position;
+        OpenGL::program_t::uniform_t mouse, resolution, radius, zoom;
+    } handles;
 
   public:
     void init() override
@@ -131,6 +136,11 @@ class wayfire_fisheye : public wf::plugin_interface_t
         OpenGL::render_begin();
         program.set_simple(
             OpenGL::compile_program(vertex_shader, fragment_shader));
+        handles.position   = program.get_attrib("position");
+        handles.mouse      = program.get_uniform("u_mouse");
+        handles.resolution = program.get_uniform("u_resolution");
+        handles.radius     = program.get_uniform("u_radius");
+        handles.zoom = program.get_uniform("u_zoom");
         OpenGL::render_end();
     }
 
@@ -152,7 +162,7 @@ class wayfire_fisheye : public wf::plugin_interface_t
             if (!hook_set)
             {
                 hook_set = true;
-                output->render->add_post(&render_hook);
+                output->render->add_post(&render_hook, "fisheye");
                 output->render->set_redraw_always();
             }
         }
@@ -182,12 +192,13 @@ class wayfire_fisheye : public wf::plugin_interface_t
         GL_CALL(glBindTexture(GL_TEXTURE_2D, source.tex));
         GL_CALL(glActiveTexture(GL_TEXTURE0));
 
-        program.uniform2f("u_mouse", oc.x, oc.y);
-        program.uniform2f("u_resolution", dest.viewport_width, dest.viewport_height);
-        program.uniform1f("u_radius", radius);
-        program.uniform1f("u_zoom", progression);
+        program.uniform2f(handles.mouse, oc.x, oc.y);
+        program.uniform2f(handles.resolution,
+            dest.viewport_width, dest.viewport_height);
+        program.uniform1f(handles.radius, radius);
+        program.uniform1f(handles.zoom, progression);
 
-        program.attrib_pointer("position", 2, 0, vertexData);
+        program.attrib_pointer(handles.position, 2, 0, vertexData);
 
         GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
         GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
@@ -58,7 +58,7 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
         {
             adjust_geometry();
         };
-        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE, "grid");
 
         unmapped = [=] (wf::signal_data_t *data)
         {
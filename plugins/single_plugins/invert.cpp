@@ -40,6 +40,7 @@ class wayfire_invert_screen : public wf::plugin_interface_t
 
     bool active = false;
     OpenGL::program_t program;
+    OpenGL::program_t::attrib_t position_attrib, uv_attrib;
 
   public:
     void init() override
@@ -67,7 +68,8 @@ class wayfire_invert_screen : public wf::plugin_interface_t
                 output->render->rem_post(&hook);
             } else
             {
-                output->render->add_post(&hook);
+                output->render->add_post(&hook, "invert",
+                    {wf::POST_DAMAGE_IDENTITY});
             }
 
             active = !active;
@@ -78,6 +80,8 @@ class wayfire_invert_screen : public wf::plugin_interface_t
         OpenGL::render_begin();
         program.set_simple(
             OpenGL::compile_program(vertex_shader, fragment_shader));
+        position_attrib = program.get_attrib("position");
+        uv_attrib = program.get_attrib("uvPosition");
         OpenGL::render_end();
 
         output->add_activator(toggle_key, &toggle_cb);
@@ -106,8 +110,8 @@ class wayfire_invert_screen : public wf::plugin_interface_t
         GL_CALL(glBindTexture(GL_TEXTURE_2D, source.tex));
         GL_CALL(glActiveTexture(GL_TEXTURE0));
 
-        program.attrib_pointer("position", 2, 0, vertexData);
-        program.attrib_pointer("uvPosition", 2, 0, coordData);
+        program.attrib_pointer(position_attrib, 2, 0, vertexData);
+        program.attrib_pointer(uv_attrib, 2, 0, coordData);
 
         GL_CALL(glDisable(GL_BLEND));
         GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
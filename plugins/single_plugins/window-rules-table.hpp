@@ -0,0 +1,255 @@
+#ifndef WINDOW_RULES_TABLE_HPP
+#define WINDOW_RULES_TABLE_HPP
+
+/* The rule table used by the window-rules plugin.
+ *
+ * Rules are indexed by what they match, so that finding the rules which apply
+ * to a view takes a single pass over its title and app-id, regardless of the
+ * number of rules. */
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wf
+{
+namespace window_rules
+{
+/**
+ * Finds which of a set of patterns occur in a text, using the Aho-Corasick
+ * algorithm.
+ */
+class substring_index_t
+{
+  public:
+    /** Add a pattern, identified by the given id. */
+    void add(const std::string& pattern, uint32_t id)
+    {
+        if (pattern.empty())
+        {
+            everywhere.push_back(id);
+
+            return;
+        }
+
+        uint32_t node = 0;
+        for (unsigned char c : pattern)
+        {
+            uint32_t next = child(node, c);
+            if (!next)
+            {
+                next = nodes.size();
+                auto& children = nodes[node].children;
+                auto pos = std::lower_bound(children.begin(), children.end(),
+                    std::make_pair(c, 0u));
+                children.insert(pos, std::make_pair(c, next));
+                nodes.emplace_back();
+            }
+
+            node = next;
+        }
+
+        nodes[node].ids.push_back(id);
+    }
+
+    /** Compute the failure links. Must be called after adding patterns. */
+    void build()
+    {
+        /* Breadth-first, so that the links of shorter prefixes are known */
+        std::vector<uint32_t> queue = {0};
+        for (size_t i = 0; i < queue.size(); i++)
+        {
+            uint32_t node = queue[i];
+            for (auto& [c, next] : nodes[node].children)
+            {
+                uint32_t fail = 0;
+                if (node != 0)
+                {
+                    uint32_t state = nodes[node].fail;
+                    while (state && !child(state, c))
+                    {
+                        state = nodes[state].fail;
+                    }
+
+                    fail = child(state, c);
+                }
+
+                nodes[next].fail   = fail;
+                nodes[next].output =
+                    nodes[fail].ids.empty() ? nodes[fail].output : fail;
+                queue.push_back(next);
+            }
+        }
+    }
+
+    /**
+     * Call callback with the id of each pattern found in the text. Patterns
+     * which occur several times are reported several times.
+     */
+    template<class Callback>
+    void find(const std::string& text, Callback callback) const
+    {
+        for (auto id : everywhere)
+        {
+            callback(id);
+        }
+
+        if (nodes.size() == 1)
+        {
+            return;
+        }
+
+        uint32_t state = 0;
+        for (unsigned char c : text)
+        {
+            while (state && !child(state, c))
+            {
+                state = nodes[state].fail;
+            }
+
+            state = child(state, c);
+            for (uint32_t node = state; node; node = nodes[node].output)
+            {
+                for (auto id : nodes[node].ids)
+                {
+                    callback(id);
+                }
+            }
+        }
+    }
+
+  private:
+    struct node_t
+    {
+        /* Sorted by character */
+        std::vector<std::pair<unsigned char, uint32_t>> children;
+        /* The node of the longest proper suffix which is in the trie */
+        uint32_t fail = 0;
+        /* The node of the longest proper suffix which ends a pattern */
+        uint32_t output = 0;
+        /* The patterns ending at this node */
+        std::vector<uint32_t> ids;
+    };
+
+    /* The root is at index 0, so 0 is never a valid child */
+    std::vector<node_t> nodes = std::vector<node_t>(1);
+    /* Empty patterns, which occur in every text */
+    std::vector<uint32_t> everywhere;
+
+    uint32_t child(uint32_t node, unsigned char c) const
+    {
+        auto& children = nodes[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(),
+            std::make_pair(c, 0u));
+
+        return (it != children.end() && it->first == c) ? it->second : 0;
+    }
+};
+
+/**
+ * An index of the rules for one event.
+ */
+class rule_table_t
+{
+  public:
+    enum match_t
+    {
+        MATCH_TITLE,
+        MATCH_TITLE_CONTAINS,
+        MATCH_APP_ID,
+        MATCH_APP_ID_CONTAINS,
+    };
+
+    /**
+     * Add a rule.
+     *
+     * @return The id of the rule. Rules are numbered in the order they were
+     *   added, starting from 0.
+     */
+    uint32_t add_rule(match_t match, const std::string& pattern)
+    {
+        uint32_t id = num_rules++;
+        switch (match)
+        {
+          case MATCH_TITLE:
+            title[pattern].push_back(id);
+            break;
+
+          case MATCH_TITLE_CONTAINS:
+            title_contains.add(pattern, id);
+            break;
+
+          case MATCH_APP_ID:
+            app_id[pattern].push_back(id);
+            break;
+
+          case MATCH_APP_ID_CONTAINS:
+            app_id_contains.add(pattern, id);
+            break;
+        }
+
+        return id;
+    }
+
+    /** Prepare the table for matching. Must be called after adding rules. */
+    void build()
+    {
+        title_contains.build();
+        app_id_contains.build();
+        last_match.assign(num_rules, 0);
+    }
+
+    /**
+     * Find the rules matching a view.
+     *
+     * @return The ids of the matching rules, in the order they were added.
+     *   Valid until the next call.
+     */
+    const std::vector<uint32_t>& find_matches(const std::string& view_title,
+        const std::string& view_app_id)
+    {
+        matches.clear();
+        ++generation;
+        auto add_match = [&] (uint32_t id)
+        {
+            if (last_match[id] != generation)
+            {
+                last_match[id] = generation;
+                matches.push_back(id);
+            }
+        };
+
+        auto add_exact_matches = [&] (auto& bucket, const std::string& value)
+        {
+            auto it = bucket.find(value);
+            if (it != bucket.end())
+            {
+                std::for_each(it->second.begin(), it->second.end(), add_match);
+            }
+        };
+
+        add_exact_matches(title, view_title);
+        add_exact_matches(app_id, view_app_id);
+        title_contains.find(view_title, add_match);
+        app_id_contains.find(view_app_id, add_match);
+        std::sort(matches.begin(), matches.end());
+
+        return matches;
+    }
+
+  private:
+    uint32_t num_rules = 0;
+    std::unordered_map<std::string, std::vector<uint32_t>> title, app_id;
+    substring_index_t title_contains, app_id_contains;
+
+    std::vector<uint32_t> matches;
+    /* The last find_matches() call which matched each rule */
+    std::vector<uint64_t> last_match;
+    uint64_t generation = 0;
+};
+}
+}
+
+#endif /* end of include guard: WINDOW_RULES_TABLE_HPP */
@@ -8,6 +8,8 @@
 #include <map>
 #include <cfloat>
 #include "wayfire/view-transform.hpp"
+#include <wayfire/util/log.hpp>
+#include "window-rules-table.hpp"
 
 using std::string;
 
@@ -65,48 +67,20 @@ static bool ends_with(string x, string y)
 
 class wayfire_window_rules : public wf::plugin_interface_t
 {
-    using verification_func = std::function<bool (wayfire_view, std::string)>;
+    using rule_table_t = wf::window_rules::rule_table_t;
 
     struct verificator
     {
-        verification_func func;
+        rule_table_t::match_t match;
         std::string atom;
     };
 
     std::vector<verificator> verficators =
     {
-        {[] (wayfire_view view, std::string match) -> bool
-            {
-                auto title = view->get_title();
-
-                return title.find(match) != std::string::npos;
-            },
-            "title contains"
-        },
-        {[] (wayfire_view view, std::string match) -> bool
-            {
-                auto title = view->get_title();
-
-                return title == match;
-            },
-            "title"
-        },
-        {[] (wayfire_view view, std::string match) -> bool
-            {
-                auto app_id = view->get_app_id();
-
-                return app_id.find(match) != std::string::npos;
-            },
-            "app-id contains"
-        },
-        {[] (wayfire_view view, std::string match) -> bool
-            {
-                auto app_id = view->get_app_id();
-
-                return app_id == match;
-            },
-            "app-id"
-        },
+        {rule_table_t::MATCH_TITLE_CONTAINS, "title contains"},
+        {rule_table_t::MATCH_TITLE, "title"},
+        {rule_table_t::MATCH_APP_ID_CONTAINS, "app-id contains"},
+        {rule_table_t::MATCH_APP_ID, "app-id"},
     };
 
     std::vector<std::string> events = {
@@ -115,24 +89,19 @@ class wayfire_window_rules : public wf::plugin_interface_t
 
     using action_func = std::function<void (wayfire_view view)>;
 
-    struct lambda_executor
-    {
-        verification_func verify;
-        std::string verification_string;
-        action_func action;
-    };
-
-    using rule_func = std::function<void (wayfire_view)>;
     struct rule
     {
         std::string signal;
-        std::function<void(wayfire_view)> func;
+        rule_table_t::match_t match;
+        std::string verification_string;
+        action_func action;
     };
 
     rule parse_add_rule(std::string rule)
     {
         std::string predicate, action;
         struct rule result;
+        bool found_predicate = false;
 
         size_t pos = 0;
         for (; pos < rule.size() - 2; ++pos)
@@ -164,23 +133,20 @@ class wayfire_window_rules : public wf::plugin_interface_t
             }
         }
 
-        lambda_executor exec;
-        exec.verify = nullptr;
-        exec.action = nullptr;
-
         for (const auto& pred : verficators)
         {
             if (starts_with(predicate, pred.atom))
             {
-                exec.verify = pred.func;
-                exec.verification_string =
+                found_predicate = true;
+                result.match    = pred.match;
+                result.verification_string =
                     trim(predicate.substr(pred.atom.length(),
                         predicate.length() - pred.atom.length()));
                 break;
             }
         }
 
-        if (!exec.verify || !event.length())
+        if (!found_predicate || !event.length())
         {
             return result;
         }
@@ -195,7 +161,7 @@ class wayfire_window_rules : public wf::plugin_interface_t
                 return result;
             }
 
-            exec.action = [x, y] (wayfire_view view)
+            result.action = [x, y] (wayfire_view view)
             {
                 auto og = view->get_output()->get_relative_geometry();
                 view->move(og.x + x, og.y + y);
@@ -210,7 +176,7 @@ class wayfire_window_rules : public wf::plugin_interface_t
                 return result;
             }
 
-            exec.action = [w, h] (wayfire_view view) mutable
+            result.action = [w, h] (wayfire_view view) mutable
             {
                 auto screen_size = view->get_output()->get_screen_size();
                 if (w > 100000)
@@ -227,7 +193,7 @@ class wayfire_window_rules : public wf::plugin_interface_t
             };
         } else if (ends_with(action, "set maximized"))
         {
-            exec.action = [action] (wayfire_view view)
+            result.action = [action] (wayfire_view view)
             {
                 uint32_t edges =
                     starts_with(action, "set") ? wf::TILED_EDGES_ALL : 0;
@@ -235,7 +201,7 @@ class wayfire_window_rules : public wf::plugin_interface_t
             };
         } else if (ends_with(action, "set fullscreen"))
         {
-            exec.action = [action] (wayfire_view view)
+            result.action = [action] (wayfire_view view)
             {
                 wf::view_fullscreen_signal data;
                 data.view  = view;
@@ -254,7 +220,7 @@ class wayfire_window_rules : public wf::plugin_interface_t
             a = std::max(std::min(1.0f, a), 0.1f); /* clamp a in range [0.1f, 1.0f]
                                                     * */
 
-            exec.action = [a] (wayfire_view view)
+            result.action = [a] (wayfire_view view)
             {
                 wf::view_2D *transformer;
 
@@ -274,26 +240,48 @@ class wayfire_window_rules : public wf::plugin_interface_t
             };
         }
 
-        if (!exec.action)
+        if (result.action)
         {
-            return result;
+            result.signal = event;
         }
 
-        result.signal = event;
-        result.func   = [exec] (wayfire_view view)
-        {
-            if (exec.verify(view, exec.verification_string))
-            {
-                exec.action(view);
-            }
-        };
-
         return result;
     }
 
     wf::signal_callback_t created, maximized, fullscreened;
 
-    std::map<std::string, std::vector<rule_func>> rules_list;
+    struct rule_entry_t
+    {
+        /* The rule, as written in the config file */
+        std::string text;
+        action_func action;
+        /* How many times the rule has been applied */
+        uint64_t hits = 0;
+    };
+
+    /* The rules for a single event, indexed by rule_table_t ids */
+    struct event_rules_t
+    {
+        rule_table_t table;
+        std::vector<rule_entry_t> rules;
+    };
+
+    std::map<std::string, event_rules_t> rules_list;
+
+    void apply_rules(event_rules_t& event_rules, wayfire_view view)
+    {
+        /* Copied, because the actions may trigger other rules */
+        std::vector<uint32_t> matches = event_rules.table.find_matches(
+            view->get_title(), view->get_app_id());
+        for (auto id : matches)
+        {
+            auto& rule = event_rules.rules[id];
+            ++rule.hits;
+            LOGD("window-rules: applying rule \"", rule.text, "\" (",
+                rule.hits, " hits)");
+            rule.action(view);
+        }
+    }
 
   public:
     void init()
@@ -301,16 +289,27 @@ class wayfire_window_rules : public wf::plugin_interface_t
         auto section = wf::get_core().config.get_section("window-rules");
         for (auto opt : section->get_registered_options())
         {
-            auto rule = parse_add_rule(opt->get_value_str());
-            rules_list[rule.signal].push_back(rule.func);
+            auto text = opt->get_value_str();
+            auto rule = parse_add_rule(text);
+            if (rule.signal.empty())
+            {
+                LOGE("window-rules: failed to parse rule \"", text, "\"");
+                continue;
+            }
+
+            auto& event_rules = rules_list[rule.signal];
+            event_rules.table.add_rule(rule.match, rule.verification_string);
+            event_rules.rules.push_back({text, rule.action});
+        }
+
+        for (auto& event_rules : rules_list)
+        {
+            event_rules.second.table.build();
         }
 
         created = [=] (wf::signal_data_t *data)
         {
-            for (const auto& rule : rules_list["created"])
-            {
-                rule(get_signaled_view(data));
-            }
+            apply_rules(rules_list["created"], get_signaled_view(data));
         };
         output->connect_signal("view-mapped", &created);
 
@@ -324,10 +323,7 @@ class wayfire_window_rules : public wf::plugin_interface_t
                 return;
             }
 
-            for (const auto& rule : rules_list["maximized"])
-            {
-                rule(conv->view);
-            }
+            apply_rules(rules_list["maximized"], conv->view);
         };
         output->connect_signal("view-maximized", &maximized);
 
@@ -341,10 +337,7 @@ class wayfire_window_rules : public wf::plugin_interface_t
                 return;
             }
 
-            for (const auto& rule : rules_list["fullscreened"])
-            {
-                rule(conv->view);
-            }
+            apply_rules(rules_list["fullscreened"], conv->view);
 
             conv->carried_out = true;
         };
@@ -353,6 +346,15 @@ class wayfire_window_rules : public wf::plugin_interface_t
 
     void fini()
     {
+        for (auto& event_rules : rules_list)
+        {
+            for (auto& rule : event_rules.second.rules)
+            {
+                LOGI("window-rules: rule \"", rule.text, "\" was applied ",
+                    rule.hits, " times");
+            }
+        }
+
         output->disconnect_signal("view-mapped", &created);
         output->disconnect_signal("view-maximized", &maximized);
         output->disconnect_signal("view-fullscreen", &fullscreened);
@@ -36,7 +36,7 @@ class wayfire_zoom_screen : public wf::plugin_interface_t
             if (!hook_set)
             {
                 hook_set = true;
-                output->render->add_post(&render_hook);
+                output->render->add_post(&render_hook, "zoom");
                 output->render->set_redraw_always();
             }
         }
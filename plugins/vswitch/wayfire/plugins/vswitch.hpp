@@ -182,11 +182,17 @@ class workspace_switch_t
     bool running = false;
     wf::signal_connection_t on_frame = [=] (wf::signal_data_t *data)
     {
-        render_frame(static_cast<wall_frame_event_t*>(data)->target);
+        auto ev = static_cast<wall_frame_event_t*>(data);
+        render_frame(ev->target);
+        ev->damage |= overlay_damage;
     };
 
+    /* The area covered by the overlay view in the current frame */
+    wf::region_t overlay_damage;
+
     virtual void render_overlay_view(const framebuffer_t& fb)
     {
+        overlay_damage.clear();
         if (!overlay_view)
         {
             return;
@@ -215,6 +221,7 @@ class workspace_switch_t
         for (auto v : wf::reverse(all_views))
         {
             v->render_transformed(fb, fb.geometry);
+            overlay_damage |= v->get_bounding_box();
         }
     }
 
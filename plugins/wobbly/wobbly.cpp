@@ -46,6 +46,13 @@ void main()
 }
 
 OpenGL::program_t program;
+/* Handles of the shader inputs, resolved in load_program() */
+struct
+{
+    OpenGL::program_t::attrib_t position, uv_position;
+    OpenGL::program_t::uniform_t mvp;
+} handles;
+
 int times_loaded = 0;
 
 void load_program()
@@ -57,6 +64,9 @@ void load_program()
 
     OpenGL::render_begin();
     program.compile(vertex_source, frag_source);
+    handles.position    = program.get_attrib("position");
+    handles.uv_position = program.get_attrib("uvPosition");
+    handles.mvp = program.get_uniform("MVP");
     OpenGL::render_end();
 }
 
@@ -131,9 +141,9 @@ void render_triangles(wf::texture_t tex, glm::mat4 mat, float *pos, float *uv,
     program.use(tex.type);
     program.set_active_texture(tex);
 
-    program.attrib_pointer("position", 2, 0, pos);
-    program.attrib_pointer("uvPosition", 2, 0, uv);
-    program.uniformMatrix4f("MVP", mat);
+    program.attrib_pointer(handles.position, 2, 0, pos);
+    program.attrib_pointer(handles.uv_position, 2, 0, uv);
+    program.uniformMatrix4f(handles.mvp, mat);
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
@@ -524,7 +534,7 @@ class wf_wobbly : public wf::view_transformer_t
 
         sig->output->render->rem_effect(&pre_hook);
         view->get_output()->render->add_effect(&pre_hook,
-            wf::OUTPUT_EFFECT_PRE);
+            wf::OUTPUT_EFFECT_PRE, "wobbly");
     };
 
     std::unique_ptr<wobbly_surface> model;
@@ -560,7 +570,8 @@ class wf_wobbly : public wf::view_transformer_t
         last_frame = wf::get_current_time();
 
         pre_hook = [=] () { update_model(); };
-        view->get_output()->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        view->get_output()->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE,
+            "wobbly");
 
         view->connect_signal("unmapped", &view_removed);
         view->connect_signal("tiled", &view_state_changed);
@@ -3,18 +3,78 @@
 
 #include <GLES2/gl2.h>
 #include <string>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <functional>
 
 namespace image_io
 {
+/* An image decoded in memory. Rows are stored from top to bottom, without
+ * any padding between them */
+struct decoded_image_t
+{
+    int width, height;
+    /* GL_RGBA or GL_RGB, with one byte per channel */
+    GLenum format;
+    std::vector<uint8_t> pixels;
+};
+
+/* Decode the image from the given file, without using GL, so it is safe to
+ * call from any thread. Decoded images are cached by path and modification
+ * time, so loading an unchanged file again doesn't decode it again.
+ * Returns nullptr on failure */
+std::shared_ptr<const decoded_image_t> decode_file(std::string name);
+
 /* Load the image from the given file, binding it to the given GL texture target
  * Bind the texture before you call this function
  * Guaranteed: doesn't change any GL state except pixel packing */
 bool load_from_file(std::string name, GLuint target);
 
-/* Function that saves the given pixels(in rgba format) to a (currently) png file */
+/* A texture load started with load_from_file_async().
+ * Destroying it cancels the load */
+class async_load_t
+{
+  public:
+    virtual ~async_load_t() = default;
+
+    /* Whether the load has finished, successfully or not */
+    virtual bool is_done() const = 0;
+};
+
+/* Load the image from the given file into the texture tex, without blocking
+ * the compositor. The image is decoded on a worker thread, and then uploaded
+ * on the main thread in bands of rows, staged in a pixel buffer object, one
+ * band per main loop iteration.
+ *
+ * targets are the texture targets to upload the image to, for ex.
+ * GL_TEXTURE_2D or the faces of a cube map. The texture is bound around each
+ * upload and unbound afterwards. Its contents are undefined until the load
+ * is done.
+ *
+ * callback is called on the main thread when the load is done, with whether
+ * it was successful. It is not called if the load is cancelled */
+std::unique_ptr<async_load_t> load_from_file_async(std::string name, GLuint tex,
+    std::vector<GLenum> targets, std::function<void(bool)> callback);
+
+/* Function that saves the given pixels (in rgba format, from the bottom row to
+ * the top one) to a png or jpg file */
 void write_to_file(std::string name, uint8_t *pixels, int w, int h,
     std::string type);
 
+/* Encode the given pixels (in rgba format) as an image of the given type
+ * ("png" or "jpg"), and write it to the file descriptor fd, on a worker thread.
+ * fd is closed afterwards.
+ *
+ * Rows are read starting from first_row, with stride bytes between consecutive
+ * rows. A negative stride flips the image, for ex. for the pixels returned by
+ * wf::framebuffer_base_t::read_pixels_async().
+ *
+ * The pixels must stay valid until callback is called on the main thread, with
+ * whether the image was written successfully */
+void write_to_fd_async(int fd, std::string type, const uint8_t *first_row,
+    int width, int height, ptrdiff_t stride, std::function<void(bool)> callback);
+
 /* Initializes all backends, called at startup */
 void init();
 }
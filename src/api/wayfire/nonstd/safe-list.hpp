@@ -1,68 +1,116 @@
 #ifndef WF_SAFE_LIST_HPP
 #define WF_SAFE_LIST_HPP
 
-#include <list>
+#include <vector>
 #include <memory>
+#include <cstdint>
 #include <algorithm>
-#include <functional>
-
-#include <wayland-server.h>
+#include <stdexcept>
 
 #include "reverse.hpp"
 
-/* This is a trimmed-down wrapper of std::list<T>.
+/* This is a trimmed-down list container, whose entries are stored
+ * contiguously in memory.
  *
  * It supports safe iteration over all elements in the collection, where any
  * element can be deleted from the list at any given time (i.e even in a
- * for-each-like loop) */
+ * for-each-like loop).
+ *
+ * Removed elements are destroyed immediately, but their entries stay in the
+ * list as tombstones until no iteration is in progress. Each element remembers
+ * the epoch in which it was added, so that iterations skip elements added after
+ * they started.
+ *
+ * Each element is allocated separately, so as with std::list, references to an
+ * element stay valid until it is removed, even if other elements are added
+ * while a callback holds one. */
 namespace wf
 {
-/* The object type depends on the safe list type, and the safe list type
- * needs access to the event loop. However, the event loop is typically
- * available from core.hpp. Because we can't resolve this circular dependency,
- * we provide a link to the event loop specially for the safe list */
-namespace _safe_list_detail
-{
-/* In main.cpp, and initialized there */
-extern wl_event_loop *event_loop;
-void idle_cleanup_func(void *data);
-}
-
 template<class T>
 class safe_list_t
 {
-    std::list<std::unique_ptr<T>> list;
-    wl_event_source *idle_cleanup_source = NULL;
+    struct entry_t
+    {
+        /* Null if the element has been removed */
+        std::unique_ptr<T> value;
+        /* The epoch in which the element was added */
+        uint64_t epoch;
+    };
+
+    /* The position of an ongoing iteration. When an element is inserted at or
+     * before the position, the position is moved forward, so that the
+     * iteration continues from the same element. */
+    struct cursor_t
+    {
+        size_t pos;
+        cursor_t *prev;
+    };
 
-    /* Remove all invalidated elements in the list */
-    std::function<void()> do_cleanup = [&] ()
+    /* Registers a cursor for the duration of an iteration, and removes the
+     * tombstones when the outermost iteration is done. */
+    struct iteration_t
     {
-        auto it = list.begin();
-        while (it != list.end())
+        const safe_list_t& list;
+        cursor_t cursor;
+
+        iteration_t(const safe_list_t& list, size_t pos) : list(list)
         {
-            if (*it)
-            {
-                ++it;
-            } else
+            cursor.pos  = pos;
+            cursor.prev = list.cursors;
+            list.cursors = &cursor;
+        }
+
+        ~iteration_t()
+        {
+            list.cursors = cursor.prev;
+            if (!list.cursors)
             {
-                it = list.erase(it);
+                list.cleanup();
             }
         }
-
-        idle_cleanup_source = NULL;
     };
 
-    /* Return whether the list has invalidated elements */
-    bool is_dirty() const
+    /* Iterations are const, but they remove the tombstones at the end */
+    mutable std::vector<entry_t> list;
+    /* Number of tombstones in the list */
+    mutable size_t dead = 0;
+    /* Ongoing iterations, innermost first */
+    mutable cursor_t *cursors = nullptr;
+    /* The epoch of the last added element */
+    uint64_t epoch = 0;
+
+    /* Remove all tombstones in the list */
+    void cleanup() const
     {
-        return idle_cleanup_source;
+        if (dead == 0)
+        {
+            return;
+        }
+
+        auto it = std::remove_if(list.begin(), list.end(),
+            [] (const entry_t& entry) { return !entry.value; });
+        list.erase(it, list.end());
+        dead = 0;
+    }
+
+    void insert(size_t pos, T&& value)
+    {
+        list.insert(list.begin() + pos,
+            entry_t{std::make_unique<T>(std::move(value)), ++epoch});
+        for (auto cursor = cursors; cursor; cursor = cursor->prev)
+        {
+            if (pos <= cursor->pos)
+            {
+                ++cursor->pos;
+            }
+        }
     }
 
   public:
     safe_list_t()
     {}
 
-    /* Copy the not-erased elements from other, but do not copy the idle source */
+    /* Copy the not-erased elements from other */
     safe_list_t(const safe_list_t& other)
     {
         *this = other;
@@ -70,34 +118,25 @@ class safe_list_t
 
     safe_list_t& operator =(const safe_list_t& other)
     {
-        this->idle_cleanup_source = NULL;
-        other.for_each([&] (auto& el)
+        if (this != &other)
         {
-            this->push_back(el);
-        });
+            clear();
+            other.for_each([&] (auto& el)
+            {
+                this->push_back(el);
+            });
+        }
+
+        return *this;
     }
 
     safe_list_t(safe_list_t&& other) = default;
     safe_list_t& operator =(safe_list_t&& other) = default;
 
-    ~safe_list_t()
-    {
-        if (idle_cleanup_source)
-        {
-            wl_event_source_remove(idle_cleanup_source);
-        }
-    }
-
     T& back()
     {
-        /* No invalidated elements */
-        if (!is_dirty())
-        {
-            return *list.back();
-        }
-
         auto it = list.rbegin();
-        while (it != list.rend() && (*it) == nullptr)
+        while (it != list.rend() && !it->value)
         {
             ++it;
         }
@@ -107,36 +146,24 @@ class safe_list_t
             throw std::out_of_range("back() called on an empty list!");
         }
 
-        return **it;
+        return *it->value;
     }
 
     size_t size() const
     {
-        if (!is_dirty())
-        {
-            return list.size();
-        }
-
-        /* Count non-null elements, because that's the real size */
-        size_t sz = 0;
-        for (auto& it : list)
-        {
-            sz += (it != nullptr);
-        }
-
-        return sz;
+        return list.size() - dead;
     }
 
     /* Push back by copying */
     void push_back(T value)
     {
-        list.push_back(std::make_unique<T>(std::move(value)));
+        insert(list.size(), std::move(value));
     }
 
     /* Push back by moving */
     void emplace_back(T&& value)
     {
-        list.push_back(std::make_unique<T>(value));
+        insert(list.size(), std::move(value));
     }
 
     enum insert_place_t
@@ -149,71 +176,71 @@ class safe_list_t
     /* Insert the given value at a position in the list, determined by the
      * check function. The value is inserted at the first position that
      * check indicates, or at the end of the list otherwise */
-    void emplace_at(T&& value, std::function<insert_place_t(T&)> check)
+    template<class Check>
+    void emplace_at(T&& value, Check check)
     {
-        auto it = list.begin();
-        while (it != list.end())
+        for (size_t i = 0; i < list.size(); i++)
         {
-            /* Skip empty elements */
-            if (*it == nullptr)
+            /* Skip removed elements */
+            if (!list[i].value)
             {
-                ++it;
                 continue;
             }
 
-            auto place = check(**it);
-            switch (place)
+            switch (check(*list[i].value))
             {
               case INSERT_AFTER:
-                /* We can safely increment it, because it points to an
-                 * element in the list */
-                ++it;
+                insert(i + 1, std::move(value));
+                return;
 
-              // fall through
               case INSERT_BEFORE:
-                list.emplace(it, std::make_unique<T>(value));
-
+                insert(i, std::move(value));
                 return;
 
               default:
                 break;
             }
-
-            ++it;
         }
 
         /* If no place found, insert at the end */
         emplace_back(std::move(value));
     }
 
-    void insert_at(T value, std::function<insert_place_t(T&)> check)
+    template<class Check>
+    void insert_at(T value, Check check)
     {
         emplace_at(std::move(value), check);
     }
 
     /* Call func for each non-erased element of the list */
-    void for_each(std::function<void(T&)> func) const
+    template<class Func>
+    void for_each(Func&& func) const
     {
         /* Go through all elements currently in the list */
-        auto it = list.begin();
-        for (int size = list.size(); size > 0; size--, it++)
+        const uint64_t current = epoch;
+        iteration_t iteration{*this, 0};
+        for (auto& i = iteration.cursor.pos; i < list.size(); i++)
         {
-            if (*it)
+            auto& entry = list[i];
+            if (entry.value && (entry.epoch <= current))
             {
-                func(**it);
+                func(*entry.value);
             }
         }
     }
 
     /* Call func for each non-erased element of the list in reversed order */
-    void for_each_reverse(std::function<void(T&)> func) const
+    template<class Func>
+    void for_each_reverse(Func&& func) const
     {
-        auto it = list.rbegin();
-        for (int size = list.size(); size > 0; size--, it++)
+        const uint64_t current = epoch;
+        iteration_t iteration{*this, list.size()};
+        for (auto& i = iteration.cursor.pos; i-- > 0;)
         {
-            if (*it)
+            auto& entry = list[i];
+            if (entry.value && (entry.epoch <= current))
             {
-                func(**it);
+                func(*entry.value);
             }
         }
     }
@@ -231,29 +258,26 @@ class safe_list_t
     }
 
     /* Remove all elements satisfying a given condition.
-     * This function resets their pointers and scheduling a cleanup operation */
-    void remove_if(std::function<bool(const T&)> predicate)
+     * The elements are destroyed immediately, and their entries are removed
+     * when no iteration is in progress. */
+    template<class Predicate>
+    void remove_if(Predicate predicate)
     {
-        bool actually_removed = false;
-        for (auto& it : list)
+        /* Destroying an element may modify the list, so the loop is
+         * registered as an iteration as well */
+        iteration_t iteration{*this, 0};
+        for (auto& i = iteration.cursor.pos; i < list.size(); i++)
         {
-            if (it && predicate(*it))
+            auto& value = list[i].value;
+            if (value && predicate(*value))
             {
-                actually_removed = true;
-                /* First reset the element in the list, and then free resources */
-                auto copy = std::move(it);
-                it = nullptr;
+                /* First reset the element in the list, and then free
+                 * resources */
+                auto copy = std::move(value);
+                ++dead;
                 /* Now copy goes out of scope */
             }
         }
-
-        /* Schedule a clean-up, but be careful to not schedule it twice */
-        if (!idle_cleanup_source && actually_removed)
-        {
-            idle_cleanup_source = wl_event_loop_add_idle(
-                _safe_list_detail::event_loop,
-                _safe_list_detail::idle_cleanup_func, &do_cleanup);
-        }
     }
 };
 }
@@ -4,6 +4,8 @@
 #include <typeinfo>
 #include <memory>
 #include <string>
+#include <functional>
+#include <type_traits>
 
 #include <wayfire/nonstd/observer_ptr.h>
 #include <wayfire/nonstd/noncopyable.hpp>
@@ -22,6 +24,42 @@ struct signal_data_t
 using signal_callback_t = std::function<void (signal_data_t*)>;
 class signal_provider_t;
 
+/**
+ * Signal names are interned into IDs. The same name always maps to the same ID,
+ * so that connections can be looked up without hashing the name on each
+ * emission.
+ */
+using signal_id_t = uint32_t;
+
+/** Get the ID of the signal with the given name, registering it if needed. */
+signal_id_t get_signal_id(const std::string& name);
+
+/**
+ * A signal declaration, binding an interned signal name to the type of its
+ * data. Emitting a signal through a signal_t checks the type of the data at
+ * compile time.
+ *
+ * signal_t objects are meant to be created once, for example as static
+ * variables, and then reused for each emission:
+ *
+ * static const wf::signal_t<wf::view_geometry_changed_signal>
+ *     geometry_changed{"geometry-changed"};
+ * view->emit_signal(geometry_changed, &data);
+ */
+template<class SignalData>
+struct signal_t
+{
+    static_assert(std::is_base_of_v<signal_data_t, SignalData>,
+        "Signal data must be derived from wf::signal_data_t");
+
+    using data_t = SignalData;
+
+    explicit signal_t(const std::string& name) : id(get_signal_id(name))
+    {}
+
+    signal_id_t id;
+};
+
 /**
  * Provides an interface to connect to signal providers.
  *
@@ -68,6 +106,8 @@ class signal_provider_t
   public:
     /** Register a connection to be called when the given signal is emitted. */
     void connect_signal(std::string name, signal_connection_t *callback);
+    /** Register a connection to the signal with the given ID. */
+    void connect_signal(signal_id_t id, signal_connection_t *callback);
     /** Unregister a connection. */
     void disconnect_signal(signal_connection_t *callback);
 
@@ -84,6 +124,16 @@ class signal_provider_t
 
     /** Emit the given signal. No type checking for data is required */
     void emit_signal(std::string name, signal_data_t *data);
+    /** Emit the signal with the given ID. */
+    void emit_signal(signal_id_t id, signal_data_t *data);
+
+    /** Emit the given signal, checking the type of the data. */
+    template<class SignalData>
+    void emit_signal(const signal_t<SignalData>& signal,
+        typename signal_t<SignalData>::data_t *data)
+    {
+        emit_signal(signal.id, data);
+    }
 
     virtual ~signal_provider_t();
 
@@ -91,6 +141,9 @@ class signal_provider_t
     signal_provider_t();
 
   private:
+    /* Connections remove themselves from the providers directly */
+    friend class signal_connection_t;
+
     class sprovider_impl;
     std::unique_ptr<sprovider_impl> sprovider_priv;
 };
@@ -105,6 +158,29 @@ class custom_data_t
     {}
 };
 
+/**
+ * Names of custom data are interned into IDs, like signal names. Data stored
+ * for a type T uses the name typeid(T).name(), so the typed and the named API
+ * refer to the same data.
+ */
+using custom_data_id_t = uint32_t;
+
+/** Get the ID of custom data with the given name, registering it if needed. */
+custom_data_id_t get_custom_data_id(const std::string& name);
+
+/**
+ * Get the ID of the custom data for the type T.
+ *
+ * The ID is looked up once per type (and per plugin, since each plugin has its
+ * own copy of the static variable), and cached afterwards.
+ */
+template<class T>
+custom_data_id_t get_custom_data_id()
+{
+    static const custom_data_id_t id = get_custom_data_id(typeid(T).name());
+    return id;
+}
+
 /**
  * A base class for "objects". Objects provide signals and ways for plugins to
  * store custom data about the object.
@@ -126,43 +202,53 @@ class object_base_t : public signal_provider_t
      * If your type doesn't have one, use store_data + get_data
      */
     template<class T>
-    nonstd::observer_ptr<T> get_data_safe(
-        std::string name = typeid(T).name())
+    nonstd::observer_ptr<T> get_data_safe(std::string name)
     {
-        auto data = get_data<T>(name);
-        if (data)
-        {
-            return data;
-        } else
-        {
-            store_data<T>(std::make_unique<T>(), name);
+        return _get_data_safe<T>(get_custom_data_id(name));
+    }
 
-            return get_data<T>(name);
-        }
+    /** Same as get_data_safe(name), for the data of type T. */
+    template<class T>
+    nonstd::observer_ptr<T> get_data_safe()
+    {
+        return _get_data_safe<T>(get_custom_data_id<T>());
     }
 
     /* Retrieve custom data stored with the given name. If no such
      * data exists, NULL is returned */
     template<class T>
-    nonstd::observer_ptr<T> get_data(
-        std::string name = typeid(T).name())
+    nonstd::observer_ptr<T> get_data(std::string name)
     {
         return nonstd::make_observer(dynamic_cast<T*>(_fetch_data(name)));
     }
 
+    /** Same as get_data(name), for the data of type T. */
+    template<class T>
+    nonstd::observer_ptr<T> get_data()
+    {
+        return nonstd::make_observer(
+            dynamic_cast<T*>(_fetch_data(get_custom_data_id<T>())));
+    }
+
     /* Assigns the given data to the given name */
     template<class T>
-    void store_data(std::unique_ptr<T> stored_data,
-        std::string name = typeid(T).name())
+    void store_data(std::unique_ptr<T> stored_data, std::string name)
     {
-        _store_data(std::move(stored_data), name);
+        _store_data(std::move(stored_data), get_custom_data_id(name));
     }
 
-    /* Returns true if there is saved data under the given name */
+    /** Same as store_data(data, name), for the data of type T. */
+    template<class T>
+    void store_data(std::unique_ptr<T> stored_data)
+    {
+        _store_data(std::move(stored_data), get_custom_data_id<T>());
+    }
+
+    /* Returns true if there is saved data for the type T */
     template<class T>
     bool has_data()
     {
-        return has_data(typeid(T).name());
+        return _fetch_data(get_custom_data_id<T>()) != nullptr;
     }
 
     /** @return true if there is saved data with the given name */
@@ -175,22 +261,21 @@ class object_base_t : public signal_provider_t
     template<class T>
     void erase_data()
     {
-        erase_data(typeid(T).name());
+        _fetch_erase(get_custom_data_id<T>()).reset();
     }
 
     /* Erase the saved data from the store and return the pointer */
     template<class T>
-    std::unique_ptr<T> release_data(
-        std::string name = typeid(T).name())
+    std::unique_ptr<T> release_data(std::string name)
     {
-        if (!has_data(name))
-        {
-            return {nullptr};
-        }
-
-        auto stored = _fetch_erase(name);
+        return _release_data<T>(_fetch_erase(name));
+    }
 
-        return std::unique_ptr<T>(dynamic_cast<T*>(stored));
+    /** Same as release_data(name), for the data of type T. */
+    template<class T>
+    std::unique_ptr<T> release_data()
+    {
+        return _release_data<T>(_fetch_erase(get_custom_data_id<T>()));
     }
 
     virtual ~object_base_t();
@@ -202,14 +287,45 @@ class object_base_t : public signal_provider_t
     void _clear_data();
 
   private:
-    /** Just get the data under the given name, or nullptr, if it does not exist */
-    custom_data_t *_fetch_data(std::string name);
-    /** Get the data under the given name, and release the pointer, deleting
-     * the entry in the map */
-    custom_data_t *_fetch_erase(std::string name);
-
-    /** Store the given data under the given name */
-    void _store_data(std::unique_ptr<custom_data_t> data, std::string name);
+    template<class T>
+    nonstd::observer_ptr<T> _get_data_safe(custom_data_id_t id)
+    {
+        auto data = dynamic_cast<T*>(_fetch_data(id));
+        if (!data)
+        {
+            auto stored = std::make_unique<T>();
+            data = stored.get();
+            _store_data(std::move(stored), id);
+        }
+
+        return nonstd::make_observer(data);
+    }
+
+    template<class T>
+    static std::unique_ptr<T> _release_data(
+        std::unique_ptr<custom_data_t> stored)
+    {
+        auto data = dynamic_cast<T*>(stored.get());
+        if (data)
+        {
+            stored.release();
+        }
+
+        return std::unique_ptr<T>(data);
+    }
+
+    /** Just get the data with the given ID, or nullptr, if it does not exist */
+    custom_data_t *_fetch_data(custom_data_id_t id);
+    /** Same as _fetch_data(id), but does not register unknown names */
+    custom_data_t *_fetch_data(const std::string& name);
+
+    /** Remove the data with the given ID from the store and return it */
+    std::unique_ptr<custom_data_t> _fetch_erase(custom_data_id_t id);
+    /** Same as _fetch_erase(id), but does not register unknown names */
+    std::unique_ptr<custom_data_t> _fetch_erase(const std::string& name);
+
+    /** Store the given data with the given ID */
+    void _store_data(std::unique_ptr<custom_data_t> data, custom_data_id_t id);
 
     class obase_impl;
     std::unique_ptr<obase_impl> obase_priv;
@@ -2,6 +2,7 @@
 #define WF_OPENGL_HPP
 
 #include <GLES3/gl3.h>
+#include <memory>
 
 #include <wayfire/config/types.hpp>
 #include <wayfire/util.hpp>
@@ -36,6 +37,32 @@ extern "C" {
 
 namespace wf
 {
+/* Pixels read from a framebuffer with framebuffer_base_t::read_pixels_async().
+ *
+ * The pixels are in RGBA format. The rows are stored from the bottom of the
+ * box to its top, as glReadPixels() returns them.
+ *
+ * The pixels can be accessed from any thread, but the object must be
+ * destroyed on the main thread. */
+struct readback_pixels_t : public noncopyable_t
+{
+    const uint8_t *data = nullptr;
+    int width = 0, height = 0;
+
+    virtual ~readback_pixels_t() = default;
+};
+
+/* A read started with framebuffer_base_t::read_pixels_async().
+ * Destroying it cancels the read. */
+class readback_t : public noncopyable_t
+{
+  public:
+    virtual ~readback_t() = default;
+};
+
+using readback_callback_t =
+    std::function<void (std::unique_ptr<readback_pixels_t> pixels)>;
+
 /* Simple framebuffer, used mostly to allocate framebuffers for workspace
  * streams.
  *
@@ -64,6 +91,16 @@ struct framebuffer_base_t : public noncopyable_t
      * coordinate space */
     void scissor(wlr_box box) const;
 
+    /* Start reading the pixels in the given box, without waiting for the GPU.
+     * The box is in the same coordinate space as for scissor(). Must be
+     * called between OpenGL::render_begin() and OpenGL::render_end().
+     *
+     * The pixels are copied to a pixel buffer object, followed by a fence.
+     * Once the fence has signaled, callback is called on the main thread
+     * with the pixels, or with nullptr if the read failed. */
+    std::unique_ptr<readback_t> read_pixels_async(wlr_box box,
+        readback_callback_t callback) const;
+
     /* Will destroy the texture and framebuffer
      * Warning: will destroy tex/fb even if they have been allocated outside of
      * allocate() */
@@ -265,6 +302,48 @@ GLuint compile_program(std::string vertex_source, std::string frag_source);
  */
 void render_rectangle(wf::geometry_t box, wf::color_t color, glm::mat4 matrix);
 
+/**
+ * Queue a textured quad on the given framebuffer, clipped to @clip.
+ *
+ * Consecutive quads with the same texture, color and framebuffer projection are
+ * collected in a vertex buffer and drawn with a single draw call when the batch
+ * is flushed. Instead of using the GL scissor, the quad is clipped on the CPU to
+ * @clip, after expanding @clip to the pixel grid of the framebuffer, the same
+ * way framebuffer_t::logic_scissor() does.
+ *
+ * The batch is flushed automatically by render_end(), clear(), the immediate
+ * rendering functions, program_t::use() and the framebuffer bind/scissor
+ * functions. Code which issues raw GL draw calls inside the same rendering
+ * block needs to call flush_batch() first.
+ *
+ * @param texture   The texture to render.
+ * @param fb        The framebuffer to render onto, already bound.
+ * @param geometry  The geometry of the quad, in the same coordinate system as
+ *                    the framebuffer geometry.
+ * @param clip      The visible part of the quad, in the same coordinate system.
+ * @param color     A color multiplier for each channel of the texture.
+ * @param bits      A bitwise OR of texture_rendering_flags_t. In this variant,
+ *                    TEX_GEOMETRY flag is ignored.
+ */
+void batch_texture(wf::texture_t texture, const wf::framebuffer_t& fb,
+    const wf::geometry_t& geometry, const wf::geometry_t& clip,
+    glm::vec4 color = glm::vec4(1.f), uint32_t bits = 0);
+
+/**
+ * Queue a colored rectangle on the given framebuffer, clipped to @clip.
+ * See batch_texture() for the batching rules.
+ *
+ * @param fb    The framebuffer to render onto, already bound.
+ * @param box   The rectangle geometry, in framebuffer geometry coordinates.
+ * @param clip  The visible part of the rectangle.
+ * @param color The color of the rectangle.
+ */
+void batch_rectangle(const wf::framebuffer_t& fb, const wf::geometry_t& box,
+    const wf::geometry_t& clip, wf::color_t color);
+
+/** Draw all quads queued with batch_texture() and batch_rectangle(). */
+void flush_batch();
+
 /**
  * An OpenGL program for rendering texture_t.
  * It contains multiple programs for the different texture types.
@@ -275,6 +354,24 @@ void render_rectangle(wf::geometry_t box, wf::color_t color, glm::mat4 matrix);
 class program_t : public noncopyable_t
 {
   public:
+    /**
+     * A handle to a uniform of the program, obtained with get_uniform().
+     *
+     * Handles are resolved to the uniform locations of all texture types when
+     * they are created and whenever the program is (re)compiled, so setting a
+     * uniform through a handle does not need any lookups.
+     */
+    struct uniform_t
+    {
+        int index = -1;
+    };
+
+    /** A handle to a vertex attribute of the program, see uniform_t. */
+    struct attrib_t
+    {
+        int index = -1;
+    };
+
     program_t();
 
     /* Does nothing */
@@ -316,6 +413,37 @@ class program_t : public noncopyable_t
     /** @return The program ID for the given texture type, or 0 on failure */
     int get_program_id(wf::texture_type_t type);
 
+    /**
+     * Get a handle to the uniform with the given name. Handles stay valid if
+     * the program is recompiled.
+     */
+    uniform_t get_uniform(const std::string& name);
+    /** Get a handle to the vertex attribute with the given name. */
+    attrib_t get_attrib(const std::string& name);
+
+    /** Set the given uniform for the currently used program. */
+    void uniform1i(uniform_t uniform, int value);
+    /** Set the given uniform for the currently used program. */
+    void uniform1f(uniform_t uniform, float value);
+    /** Set the given uniform for the currently used program. */
+    void uniform2f(uniform_t uniform, float x, float y);
+    /** Set the given uniform for the currently used program. */
+    void uniform4f(uniform_t uniform, const glm::vec4& value);
+    /** Set the given uniform for the currently used program. */
+    void uniformMatrix4f(uniform_t uniform, const glm::mat4& value);
+
+    /** Same as attrib_pointer(const std::string&, ...), but with a handle. */
+    void attrib_pointer(attrib_t attrib,
+        int size, int stride, const void *ptr, GLenum type = GL_FLOAT);
+    /** Same as attrib_divisor(const std::string&, int), but with a handle. */
+    void attrib_divisor(attrib_t attrib, int divisor);
+
+    /*
+     * The functions below take the name of the uniform or attribute. They look
+     * up the corresponding handle on each call, so the handle variants should
+     * be preferred for code which runs every frame.
+     */
+
     /** Set the given uniform for the currently used program. */
     void uniform1i(const std::string& name, int value);
     /** Set the given uniform for the currently used program. */
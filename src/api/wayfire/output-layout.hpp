@@ -33,13 +33,29 @@ enum output_image_source_t
     OUTPUT_IMAGE_SOURCE_MIRROR  = 0x4,
 };
 
+/** How a mirroring output shows the image of the output it mirrors */
+enum output_mirror_scaling_t
+{
+    /** Stretch the image over the whole output */
+    OUTPUT_MIRROR_STRETCH = 0,
+    /** Scale the image as much as possible while keeping its aspect ratio,
+     * and fill the rest of the output with black (letterboxing) */
+    OUTPUT_MIRROR_FIT     = 1,
+    /** Scale the image to cover the whole output while keeping its aspect
+     * ratio, cropping the parts which don't fit */
+    OUTPUT_MIRROR_FILL    = 2,
+    /** Show the image centered and unscaled */
+    OUTPUT_MIRROR_CENTER  = 3,
+};
+
 /** Represents the current state of an output as the output layout sees it */
 struct output_state_t
 {
     /* The current source of the output.
      *
      * If source is none, then the values below don't have a meaning.
-     * If source is mirror, then only mirror_from and mode have a meaning */
+     * If source is mirror, then only mirror_from, mirror_scaling and mode have
+     * a meaning */
     output_image_source_t source = OUTPUT_IMAGE_SOURCE_INVALID;
 
     /** Whether the output should be automatically positioned. */
@@ -57,6 +73,8 @@ struct output_state_t
 
     /* Output to take the image from. Valid only if source is mirror */
     std::string mirror_from;
+    /* How to scale the image of mirror_from. Valid only if source is mirror */
+    output_mirror_scaling_t mirror_scaling = OUTPUT_MIRROR_STRETCH;
 
     bool operator ==(const output_state_t& other) const;
 };
@@ -17,6 +17,22 @@ struct workspace_stream_t;
  * @param fb Indicates the framebuffer that the custom renderer should draw to */
 using render_hook_t = std::function<void (const wf::framebuffer_t& fb)>;
 
+/**
+ * A render hook which repaints only parts of the output and reports what it
+ * changed, so that the output does not have to be fully repainted each frame.
+ *
+ * @param fb Indicates the framebuffer that the custom renderer should draw to
+ * @param damage The region of fb which has to be repainted, because it has
+ *   been damaged or because fb is out of date there, in output-local
+ *   coordinates.
+ *
+ * @return The region of fb whose contents changed in this frame, in
+ *   output-local coordinates. The damage passed to the hook is always
+ *   repainted on the screen, so it does not need to be included.
+ */
+using damage_render_hook_t = std::function<wf::region_t(
+    const wf::framebuffer_t& fb, const wf::region_t& damage)>;
+
 /* Effect hooks provide the plugins with a way to execute custom code
  * at certain parts of the repaint cycle */
 using effect_hook_t = std::function<void ()>;
@@ -50,6 +66,30 @@ enum output_effect_type_t
 using post_hook_t = std::function<void (const wf::framebuffer_base_t& source,
     const wf::framebuffer_base_t& destination)>;
 
+/**
+ * Describes how a post hook spreads damage, i.e which pixels of its
+ * destination may change when a pixel of its source changes.
+ */
+enum post_damage_type_t
+{
+    /* A destination pixel depends only on the same pixel of the source,
+     * for example when inverting colors */
+    POST_DAMAGE_IDENTITY = 0,
+    /* A destination pixel depends on the source pixels at most a given
+     * distance away, for example when blurring */
+    POST_DAMAGE_RADIUS   = 1,
+    /* A destination pixel may depend on any source pixel. Each frame has to
+     * be fully repainted. */
+    POST_DAMAGE_GLOBAL   = 2,
+};
+
+struct post_damage_spread_t
+{
+    post_damage_type_t type = POST_DAMAGE_GLOBAL;
+    /* The distance in output framebuffer pixels, for POST_DAMAGE_RADIUS */
+    int radius = 0;
+};
+
 /** Render manager
  *
  * Each output has a render manager, which is responsible for all rendering
@@ -69,6 +109,14 @@ class render_manager : public wf::signal_provider_t
      */
     void set_renderer(render_hook_t rh = nullptr);
 
+    /**
+     * Set a render hook which reports its own damage. This replaces any
+     * render hook set with set_renderer().
+     *
+     * @param rh The render hook to use, or nullptr for default renderer
+     */
+    void set_damage_renderer(damage_render_hook_t rh);
+
     /**
      * Rendering an output is done on demand, that is, when the output is
      * damaged. Some plugins however need to redraw the output as often as
@@ -98,8 +146,11 @@ class render_manager : public wf::signal_provider_t
      * Add a new effect hook.
      * @param hook The hook callback
      * @param type The type of the effect hook
+     * @param name The name of the hook owner, typically the plugin name. It is
+     *   used to attribute frame time when profiling.
      */
-    void add_effect(effect_hook_t *hook, output_effect_type_t type);
+    void add_effect(effect_hook_t *hook, output_effect_type_t type,
+        std::string name = "");
     /**
      * Remove an added effect hook. No-op if the hook wasn't really added.
      * @param hook The hook callback to be removed
@@ -109,9 +160,21 @@ class render_manager : public wf::signal_provider_t
     /**
      * Add a new post hook.
      *
+     * Unless the spread is POST_DAMAGE_GLOBAL, the hook is called with a
+     * scissor box set to the damaged part of the destination, and it is
+     * expected to only modify that part. The destination keeps its contents
+     * from the previous frame outside of the damaged part. Hooks whose output
+     * changes even though the source did not must damage the output
+     * themselves.
+     *
      * @param hook The hook callack
+     * @param name The name of the hook owner, typically the plugin name. It is
+     *   used to attribute frame time when profiling.
+     * @param spread How the hook spreads damage from its source to its
+     *   destination.
      */
-    void add_post(post_hook_t *hook);
+    void add_post(post_hook_t *hook, std::string name = "",
+        post_damage_spread_t spread = {});
 
     /**
      * Remove a post hook. No-op if hook isn't active.
@@ -128,13 +191,26 @@ class render_manager : public wf::signal_provider_t
      */
     wf::region_t get_swap_damage();
 
+    /**
+     * @return The number of surfaces whose frame callbacks were throttled in
+     * the last frame because they were fully occluded by other surfaces.
+     */
+    uint32_t get_throttled_surfaces_count() const;
+
     /**
      * @return The damaged region on the current output for the current
-     * frame. Note that a larger region might actually be repainted due to
-     * double buffering.
+     * frame, on all workspaces. Note that a larger region might actually be
+     * repainted due to double buffering.
      */
     wf::region_t get_scheduled_damage();
 
+    /**
+     * @return The damaged region of the given workspace for the current
+     * frame, including damage from views shown on all workspaces, in
+     * output-local coordinates. The region is inside get_ws_box(ws).
+     */
+    wf::region_t get_ws_damage(wf::point_t ws);
+
     /**
      * Damage all workspaces of the output. Should not be used inside render
      * hooks, view transformers, etc.
@@ -163,6 +239,16 @@ class render_manager : public wf::signal_provider_t
      */
     void damage(const wf::region_t& region);
 
+    /**
+     * Damage a region which is shown at the same position on all workspaces,
+     * for ex. a part of a panel. The damage is recorded once, and applied to
+     * each workspace when its stream is repainted.
+     *
+     * @param region The region to be damaged, in output-local coordinates.
+     *        Parts outside of the current workspace are ignored.
+     */
+    void damage_sticky(const wf::region_t& region);
+
     /**
      * @return A box in output-local coordinates containing the given
      * workspace of the output (returned value depends on current workspace).
@@ -179,6 +265,9 @@ class render_manager : public wf::signal_provider_t
      * Initialize a workspace stream. If you need to change the stream's
      * attributes, you should stop the stream, and start it again
      *
+     * The stream is first rendered with the scale set in its scale_x and
+     * scale_y fields.
+     *
      * @param stream The stream to be initialized
      */
     void workspace_stream_start(workspace_stream_t& stream);
@@ -188,9 +277,14 @@ class render_manager : public wf::signal_provider_t
      * This function should be called inside the rendering cycle, i.e in a
      * render or an overlay hook.
      *
+     * The stream can be rendered at a lower resolution than the output, for
+     * example when it is shown scaled down. Framebuffers support only uniform
+     * scaling, so the larger of the two scales is used. Changing the scale
+     * repaints the whole stream.
+     *
      * @param stream The workspace stream to update
-     * @param scale_x Unused for now
-     * @param scale_y Unused for now
+     * @param scale_x The horizontal scale of the stream, in (0, 1]
+     * @param scale_y The vertical scale of the stream, in (0, 1]
      */
     void workspace_stream_update(workspace_stream_t& stream,
         float scale_x = 1, float scale_y = 1);
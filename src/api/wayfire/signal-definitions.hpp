@@ -108,9 +108,31 @@ struct surface_map_state_changed_signal : public wf::signal_data_t
 /**
  * name: reload-config
  * on: core
- * when: When the config file is reloaded
- * argument: unused
+ * when: When the config file is reloaded and the value of at least one option
+ *   has changed.
  */
+struct reload_config_signal : public wf::signal_data_t
+{
+    /** The names of the options which were changed, added or removed, in
+     * the form section/option */
+    std::vector<std::string> changed_options;
+
+    /** @return true if an option in the given section has changed */
+    bool section_changed(const std::string& section) const
+    {
+        for (auto& name : changed_options)
+        {
+            if ((name.size() > section.size()) &&
+                (name.compare(0, section.size(), section) == 0) &&
+                (name[section.size()] == '/'))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
 
 /**
  * name: keyboard-focus-changed
@@ -478,6 +500,13 @@ struct view_geometry_changed_signal : public _view_signal
     wf::geometry_t old_geometry;
 };
 
+/**
+ * name: transformers-changed
+ * on: view, output(view-)
+ * when: After a transformer has been added to or removed from the view.
+ */
+using view_transformers_changed_signal = _view_signal;
+
 /**
  * name: region-damaged
  * on: view
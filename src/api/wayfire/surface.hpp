@@ -1,7 +1,9 @@
 #ifndef WF_SURFACE_HPP
 #define WF_SURFACE_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <memory>
@@ -34,6 +36,93 @@ struct surface_iterator_t
     wf::point_t position;
 };
 
+/**
+ * A pair of iterators, which can be used in range-based for loops.
+ */
+template<class Iterator>
+struct iterator_range_t
+{
+    Iterator first, last;
+
+    Iterator begin() const
+    {
+        return first;
+    }
+
+    Iterator end() const
+    {
+        return last;
+    }
+};
+
+/**
+ * Iterates over the mapped surfaces in a surface tree, in the same order as
+ * surface_interface_t::enumerate_surfaces() or in the reverse order, without
+ * allocating memory.
+ *
+ * The surface tree must not change while it is being iterated.
+ */
+class surface_tree_iterator_t
+{
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = surface_iterator_t;
+    using difference_type   = std::ptrdiff_t;
+    using pointer   = const surface_iterator_t*;
+    using reference = const surface_iterator_t&;
+
+    /** Create an iterator past the end of the surface tree */
+    surface_tree_iterator_t() = default;
+
+    /**
+     * Create an iterator at the first surface of a surface tree.
+     *
+     * @param root The topmost surface of the tree.
+     * @param root_origin The coordinates of the top-left corner of root.
+     * @param bottom_first Whether to iterate from the bottom-most to the
+     *   topmost surface.
+     */
+    surface_tree_iterator_t(surface_interface_t *root,
+        wf::point_t root_origin, bool bottom_first);
+
+    reference operator *() const
+    {
+        return current;
+    }
+
+    pointer operator ->() const
+    {
+        return &current;
+    }
+
+    surface_tree_iterator_t& operator ++();
+
+    bool operator ==(const surface_tree_iterator_t& other) const
+    {
+        return current.surface == other.current.surface;
+    }
+
+    bool operator !=(const surface_tree_iterator_t& other) const
+    {
+        return !(*this == other);
+    }
+
+  private:
+    surface_interface_t *root = nullptr;
+    /* The surface being visited, or nullptr at the end */
+    surface_iterator_t current = {nullptr, {0, 0}};
+    bool bottom_first = false;
+
+    /* Whether the children which are iterated before the surface itself
+     * (the ones above it, or below it if bottom_first) are being visited */
+    bool in_first_children = true;
+    /* The number of children in the current list which have been visited */
+    size_t visited_children = 0;
+
+    /** Go to the next surface, starting from the current state */
+    void advance();
+};
+
 /**
  * surface_interface_t is the base class for everything that can be displayed
  * on the screen. It is the closest thing there is in Wayfire to a Window in X11.
@@ -95,6 +184,36 @@ class surface_interface_t
     virtual std::vector<surface_iterator_t> enumerate_surfaces(
         wf::point_t surface_origin = {0, 0});
 
+    /**
+     * Same as enumerate_surfaces(), but without allocating memory. The
+     * surfaces are visited in the order of the surface tree, so overrides of
+     * enumerate_surfaces() are not taken into account.
+     *
+     * The surface tree must not change while iterating.
+     *
+     * @param surface_origin The coordinates of the top-left corner of the
+     *   surface.
+     * @param bottom_first Whether to start from the bottom-most surface.
+     */
+    iterator_range_t<surface_tree_iterator_t> traverse_surfaces(
+        wf::point_t surface_origin = {0, 0}, bool bottom_first = false);
+
+    /**
+     * Call callback for each mapped surface in the surface tree, including
+     * the surface itself, in the order of traverse_surfaces().
+     *
+     * @param callback A function taking a const surface_iterator_t&.
+     */
+    template<class Callback>
+    void for_each_surface(Callback callback,
+        wf::point_t surface_origin = {0, 0}, bool bottom_first = false)
+    {
+        for (auto& child : traverse_surfaces(surface_origin, bottom_first))
+        {
+            callback(child);
+        }
+    }
+
     /**
      * @return The output the surface is currently attached to. Note this
      * doesn't necessarily mean that it is visible.
@@ -24,6 +24,9 @@ namespace wf
  * "fullscreen" -> bool
  * "activated" -> bool
  * "minimized" -> bool
+ * "visible" -> bool
+ * "focusable" -> bool
+ * "mapped" -> bool
  * "tiled-left" -> bool
  * "tiled-right" -> bool
  * "tiled-top" -> bool
@@ -35,6 +38,37 @@ namespace wf
 class view_access_interface_t : public access_interface_t
 {
   public:
+    /**
+     * The supported properties, in the order listed above.
+     */
+    enum property_t
+    {
+        PROPERTY_APP_ID,
+        PROPERTY_TITLE,
+        PROPERTY_ROLE,
+        PROPERTY_FULLSCREEN,
+        PROPERTY_ACTIVATED,
+        PROPERTY_MINIMIZED,
+        PROPERTY_VISIBLE,
+        PROPERTY_FOCUSABLE,
+        PROPERTY_MAPPED,
+        PROPERTY_TILED_LEFT,
+        PROPERTY_TILED_RIGHT,
+        PROPERTY_TILED_TOP,
+        PROPERTY_TILED_BOTTOM,
+        PROPERTY_MAXIMIZED,
+        PROPERTY_FLOATING,
+        PROPERTY_TYPE,
+        PROPERTY_UNKNOWN,
+    };
+
+    /**
+     * @brief find_property Look up a property by its identifier.
+     *
+     * @return The property, or PROPERTY_UNKNOWN if it is not supported.
+     */
+    static property_t find_property(const std::string& identifier);
+
     /**
      * @brief view_access_interface_t Default constructor.
      */
@@ -53,6 +87,12 @@ class view_access_interface_t : public access_interface_t
     // Inherits docs.
     virtual variant_t get(const std::string & identifier, bool & error) override;
 
+    /**
+     * @brief get Same as get(identifier, error), for an already looked up
+     * property.
+     */
+    variant_t get(property_t property, bool & error);
+
     /**
      * @brief set_view Setter for the view to interrogate.
      *
@@ -1,6 +1,7 @@
 #ifndef VIEW_TRANSFORM_HPP
 #define VIEW_TRANSFORM_HPP
 
+#include <array>
 #include <wayfire/view.hpp>
 #include <wayfire/opengl.hpp>
 
@@ -107,6 +108,23 @@ class view_transformer_t
         wlr_box scissor_box, const wf::framebuffer_t& target_fb)
     {}
 
+    /**
+     * Check whether the transformer would render differently than the last
+     * time this function was called, given the same input, for example
+     * because its parameters have changed.
+     *
+     * Views keep the result of every transformer except the last one in an
+     * offscreen buffer. If a transformer is unchanged, only the parts of the
+     * buffer whose input was damaged are rendered again, or none at all.
+     *
+     * The default implementation always returns true, i.e the result of the
+     * transformer is fully rendered again each time.
+     */
+    virtual bool has_changed()
+    {
+        return true;
+    }
+
     virtual ~view_transformer_t()
     {}
 };
@@ -138,6 +156,12 @@ class view_2D : public view_transformer_t
         wf::geometry_t view, wf::pointf_t point) override;
     void render_box(wf::texture_t src_tex, wlr_box src_box,
         wlr_box scissor_box, const wf::framebuffer_t& target_fb) override;
+    bool has_changed() override;
+
+  private:
+    /* The parameters at the last call of has_changed() */
+    std::array<float, 8> last_state;
+    bool last_state_valid = false;
 };
 
 /* Those are centered relative to the view's bounding box */
@@ -166,10 +190,17 @@ class view_3D : public view_transformer_t
         wf::geometry_t view, wf::pointf_t point) override;
     void render_box(wf::texture_t src_tex, wlr_box src_box,
         wlr_box scissor_box, const wf::framebuffer_t& target_fb) override;
+    bool has_changed() override;
 
     static const float fov; // PI / 8
     static glm::mat4 default_view_matrix();
     static glm::mat4 default_proj_matrix();
+
+  private:
+    /* The transform and color at the last call of has_changed() */
+    glm::mat4 last_transform{1.0};
+    glm::vec4 last_color{1, 1, 1, 1};
+    bool last_state_valid = false;
 };
 
 /* create a matrix which corresponds to the inverse of the given transform */
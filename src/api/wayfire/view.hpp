@@ -49,6 +49,65 @@ enum view_role_t
 constexpr uint32_t TILED_EDGES_ALL =
     WLR_EDGE_TOP | WLR_EDGE_BOTTOM | WLR_EDGE_LEFT | WLR_EDGE_RIGHT;
 
+/**
+ * Iterates over the views in the tree of a view, in the same order as
+ * view_interface_t::enumerate_views(), without allocating memory.
+ *
+ * The view tree must not change while it is being iterated.
+ */
+class view_tree_iterator_t
+{
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = wayfire_view;
+    using difference_type   = std::ptrdiff_t;
+    using pointer   = const wayfire_view*;
+    using reference = const wayfire_view&;
+
+    /** Create an iterator past the end of the view tree */
+    view_tree_iterator_t() = default;
+
+    /**
+     * Create an iterator at the first view of a view tree.
+     *
+     * @param root The view at the root of the tree.
+     * @param mapped_only Whether to skip root if it isn't mapped. Children
+     *   which aren't mapped are always skipped.
+     */
+    view_tree_iterator_t(wayfire_view root, bool mapped_only);
+
+    reference operator *() const
+    {
+        return current;
+    }
+
+    pointer operator ->() const
+    {
+        return &current;
+    }
+
+    view_tree_iterator_t& operator ++();
+
+    bool operator ==(const view_tree_iterator_t& other) const
+    {
+        return current == other.current;
+    }
+
+    bool operator !=(const view_tree_iterator_t& other) const
+    {
+        return !(*this == other);
+    }
+
+  private:
+    wayfire_view root    = nullptr;
+    wayfire_view current = nullptr;
+    /* The number of children of current which have been visited */
+    size_t visited_children = 0;
+
+    /** Descend to the first view to visit from the current state */
+    void descend();
+};
+
 /**
  * view_interface_t is the base class for all "toplevel windows", i.e surfaces
  * which have no parent.
@@ -78,6 +137,28 @@ class view_interface_t : public surface_interface_t, public wf::object_base_t
      */
     std::vector<wayfire_view> enumerate_views(bool mapped_only = true);
 
+    /**
+     * Same as enumerate_views(), but without allocating memory.
+     * The view tree must not change while iterating.
+     */
+    iterator_range_t<view_tree_iterator_t> traverse_views(
+        bool mapped_only = true);
+
+    /**
+     * Call callback for each view in the view's tree, in the order of
+     * traverse_views().
+     *
+     * @param callback A function taking a wayfire_view.
+     */
+    template<class Callback>
+    void for_each_view(Callback callback, bool mapped_only = true)
+    {
+        for (auto& view : traverse_views(mapped_only))
+        {
+            callback(view);
+        }
+    }
+
     /**
      * Set the toplevel parent of the view, and adjust the children's list of
      * the parent.
@@ -471,6 +552,8 @@ class view_interface_t : public surface_interface_t, public wf::object_base_t
 
     /** Damage the given box, in surface-local coordinates */
     virtual void damage_surface_box(const wlr_box& box) override;
+    /** Damage the given region, in surface-local coordinates */
+    virtual void damage_surface_region(const wf::region_t& region) override;
 
     /**
      * @return the bounding box of the view before transformers,
@@ -511,6 +594,9 @@ class view_interface_t : public surface_interface_t, public wf::object_base_t
      * signal is mandatory for all views.
      */
     virtual void emit_view_pre_unmap();
+
+    /** Emit the transformers-changed signal on the view and its output. */
+    void emit_transformers_changed();
 };
 
 wayfire_view wl_surface_to_wayfire_view(wl_resource *surface);
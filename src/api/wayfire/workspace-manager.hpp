@@ -2,6 +2,7 @@
 #define WORKSPACE_MANAGER_HPP
 
 #include <functional>
+#include <memory>
 #include <vector>
 #include <wayfire/view.hpp>
 
@@ -220,6 +221,18 @@ class workspace_manager
      */
     std::vector<wayfire_view> get_views_in_layer(uint32_t layers_mask);
 
+    /** A shared, read-only list of views. */
+    using views_snapshot_t = std::shared_ptr<const std::vector<wayfire_view>>;
+
+    /**
+     * Same as get_views_in_layer(), but returns the list without copying it.
+     *
+     * The list is cached until the stacking order changes, so repeated calls
+     * are cheap. A snapshot is never modified afterwards, so views may be
+     * restacked while iterating over it.
+     */
+    views_snapshot_t get_views_in_layer_snapshot(uint32_t layers_mask);
+
     /**
      * Get a list of reordered fullscreen views as explained in
      * get_views_in_layer().
@@ -609,7 +609,7 @@ void wf::compositor_core_impl_t::set_active_view(wayfire_view new_focus)
     }
 
     /* Descend into frontmost child view */
-    new_focus = new_focus ? new_focus->enumerate_views().front() : nullptr;
+    new_focus = new_focus ? *new_focus->traverse_views().begin() : nullptr;
     bool refocus = (last_active_view == new_focus);
 
     /* don't deactivate view if the next focus is not a toplevel */
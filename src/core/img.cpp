@@ -1,6 +1,8 @@
 #include <wayfire/util/log.hpp>
 #include "wayfire/img.hpp"
 #include "wayfire/opengl.hpp"
+#include "wayfire/core.hpp"
+#include "wayfire/util.hpp"
 
 #include <config.h>
 
@@ -12,17 +14,28 @@
 
 #include <stdint.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <csetjmp>
 #include <cstdio>
+#include <cstring>
 #include <unordered_map>
 #include <functional>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <wayland-server.h>
 
 #define TEXTURE_LOAD_ERROR 0
 
 namespace image_io
 {
-using Loader = std::function<bool (const char*, GLuint)>;
-using Writer = std::function<void (const char*name, uint8_t*pixels, unsigned long,
-    unsigned long)>;
+using Loader = std::function<std::shared_ptr<decoded_image_t> (const char*)>;
+using Writer = std::function<bool (FILE *file, const uint8_t *first_row,
+    int width, int height, ptrdiff_t stride)>;
 namespace
 {
 std::unordered_map<std::string, Loader> loaders;
@@ -32,39 +45,55 @@ std::unordered_map<std::string, Writer> writers;
 #ifdef BUILD_WITH_IMAGEIO
 /* All backend functions are taken from the internet.
  * If you want to be credited, contact me */
-bool texture_from_png(const char *filename, GLuint target)
+std::shared_ptr<decoded_image_t> decode_png(const char *filename)
 {
     FILE *fp = fopen(filename, "rb");
-    int width, height;
+    if (!fp)
+    {
+        LOGE("failed to read PNG file ", filename);
+
+        return nullptr;
+    }
+
     png_byte color_type;
     png_byte bit_depth;
-    png_bytep *row_pointers;
 
     png_structp png =
         png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!png)
     {
-        return false;
+        fclose(fp);
+
+        return nullptr;
     }
 
     png_infop infos = png_create_info_struct(png);
     if (!infos)
     {
-        return false;
+        png_destroy_read_struct(&png, NULL, NULL);
+        fclose(fp);
+
+        return nullptr;
     }
 
+    auto image = std::make_shared<decoded_image_t>();
+    std::vector<png_bytep> row_pointers;
     if (setjmp(png_jmpbuf(png)))
     {
-        return false;
+        png_destroy_read_struct(&png, &infos, NULL);
+        fclose(fp);
+
+        return nullptr;
     }
 
     png_init_io(png, fp);
     png_read_info(png, infos);
 
-    width  = png_get_image_width(png, infos);
-    height = png_get_image_height(png, infos);
-    color_type = png_get_color_type(png, infos);
-    bit_depth  = png_get_bit_depth(png, infos);
+    image->width  = png_get_image_width(png, infos);
+    image->height = png_get_image_height(png, infos);
+    image->format = GL_RGBA;
+    color_type    = png_get_color_type(png, infos);
+    bit_depth     = png_get_bit_depth(png, infos);
 
     if (bit_depth == 16)
     {
@@ -103,142 +132,216 @@ bool texture_from_png(const char *filename, GLuint target)
 
     png_read_update_info(png, infos);
 
-    row_pointers = new png_bytep[height];
-    png_byte *data = new png_byte[height * png_get_rowbytes(png, infos)];
-
-    for (int i = 0; i < height; i++)
+    size_t stride = png_get_rowbytes(png, infos);
+    image->pixels.resize(image->height * stride);
+    row_pointers.resize(image->height);
+    for (int i = 0; i < image->height; i++)
     {
-        row_pointers[i] = data + i * png_get_rowbytes(png, infos);
+        row_pointers[i] = image->pixels.data() + i * stride;
     }
 
-    png_read_image(png, row_pointers);
-    GL_CALL(glTexImage2D(target, 0, GL_RGBA, width, height, 0,
-        GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)data));
-
+    png_read_image(png, row_pointers.data());
     png_destroy_read_struct(&png, &infos, NULL);
-    delete[] row_pointers;
-    delete[] data;
-
     fclose(fp);
 
-    return true;
+    return image;
 }
 
-void texture_to_png(const char *name, uint8_t *pixels, int w, int h)
+bool encode_png(FILE *fp, const uint8_t *first_row, int w, int h,
+    ptrdiff_t stride)
 {
     png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr,
         nullptr, nullptr);
     if (!png)
     {
-        return;
+        return false;
     }
 
     png_infop infot = png_create_info_struct(png);
     if (!infot)
     {
-        png_destroy_write_struct(&png, &infot);
+        png_destroy_write_struct(&png, NULL);
 
-        return;
+        return false;
     }
 
-    FILE *fp = fopen(name, "wb");
-    if (!fp)
+    if (setjmp(png_jmpbuf(png)))
     {
         png_destroy_write_struct(&png, &infot);
 
-        return;
+        return false;
     }
 
     png_init_io(png, fp);
     png_set_IHDR(png, infot, w, h, 8 /* depth */, PNG_COLOR_TYPE_RGBA,
         PNG_INTERLACE_NONE,
         PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
-    png_colorp palette =
-        (png_colorp)png_malloc(png, PNG_MAX_PALETTE_LENGTH * sizeof(png_color));
-    if (!palette)
-    {
-        fclose(fp);
-        png_destroy_write_struct(&png, &infot);
-
-        return;
-    }
-
-    png_set_PLTE(png, infot, palette, PNG_MAX_PALETTE_LENGTH);
     png_write_info(png, infot);
-    png_set_packing(png);
 
-    png_bytepp rows = (png_bytepp)png_malloc(png, h * sizeof(png_bytep));
-    for (int i = 0; i < h; ++i)
+    /* Rows are written one by one, so that they can be read directly from
+     * the source, even if it is flipped */
+    for (int i = 0; i < h; i++)
     {
-        rows[i] = (png_bytep)(pixels + (h - i) * w * 4);
+        png_write_row(png, (png_const_bytep)(first_row + i * stride));
     }
 
-    png_write_image(png, rows);
     png_write_end(png, infot);
-    png_free(png, palette);
     png_destroy_write_struct(&png, &infot);
 
-    fclose(fp);
-    delete[] rows;
+    return true;
+}
+
+/* By default, libjpeg exits the process on errors. Instead, jump back to
+ * the function which uses it, so that it can fail gracefully */
+struct jpeg_error_t
+{
+    struct jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+static void handle_jpeg_error(j_common_ptr info)
+{
+    char message[JMSG_LENGTH_MAX];
+    info->err->format_message(info, message);
+    LOGE("libjpeg: ", message);
+    longjmp(((jpeg_error_t*)info->err)->jump, 1);
 }
 
-bool texture_from_jpeg(const char *FileName, GLuint target)
+std::shared_ptr<decoded_image_t> decode_jpeg(const char *FileName)
 {
-    unsigned long data_size;
     unsigned char *rowptr[1];
-    unsigned char *jdata;
     struct jpeg_decompress_struct infot;
-    struct jpeg_error_mgr err;
+    jpeg_error_t err;
 
     std::FILE *file = fopen(FileName, "rb");
-    infot.err = jpeg_std_error(&err);
-    jpeg_create_decompress(&infot);
-
     if (!file)
     {
         LOGE("failed to read JPEG file ", FileName);
 
-        return false;
+        return nullptr;
     }
 
+    /* Objects with destructors must be created before setjmp() */
+    auto image = std::make_shared<decoded_image_t>();
+    infot.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = handle_jpeg_error;
+    if (setjmp(err.jump))
+    {
+        jpeg_destroy_decompress(&infot);
+        fclose(file);
+
+        return nullptr;
+    }
+
+    jpeg_create_decompress(&infot);
     jpeg_stdio_src(&infot, file);
     jpeg_read_header(&infot, TRUE);
     jpeg_start_decompress(&infot);
 
-    data_size = infot.output_width * infot.output_height * 3;
-
-    jdata = new unsigned char [data_size];
+    image->width  = infot.output_width;
+    image->height = infot.output_height;
+    image->format = GL_RGB;
+    image->pixels.resize(infot.output_width * infot.output_height * 3);
     while (infot.output_scanline < infot.output_height)
     {
-        rowptr[0] = (unsigned char*)jdata + 3 * infot.output_width *
+        rowptr[0] = image->pixels.data() + 3 * infot.output_width *
             infot.output_scanline;
         jpeg_read_scanlines(&infot, rowptr, 1);
     }
 
     jpeg_finish_decompress(&infot);
+    jpeg_destroy_decompress(&infot);
+    fclose(file);
 
-    GL_CALL(glTexImage2D(target, 0, GL_RGB,
-        infot.output_width, infot.output_height,
-        0, GL_RGB, GL_UNSIGNED_BYTE, jdata));
+    return image;
+}
 
-    fclose(file);
-    delete[] jdata;
+bool encode_jpeg(FILE *fp, const uint8_t *first_row, int w, int h,
+    ptrdiff_t stride)
+{
+    struct jpeg_compress_struct infot;
+    jpeg_error_t err;
+
+    /* JPEG has no alpha channel, so rows are converted to RGB first */
+    std::vector<uint8_t> row(w * 3);
+    unsigned char *rowptr[1] = {row.data()};
+
+    infot.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = handle_jpeg_error;
+    if (setjmp(err.jump))
+    {
+        jpeg_destroy_compress(&infot);
+
+        return false;
+    }
+
+    jpeg_create_compress(&infot);
+    jpeg_stdio_dest(&infot, fp);
+
+    infot.image_width  = w;
+    infot.image_height = h;
+    infot.input_components = 3;
+    infot.in_color_space   = JCS_RGB;
+    jpeg_set_defaults(&infot);
+    jpeg_set_quality(&infot, 90, TRUE);
+    jpeg_start_compress(&infot, TRUE);
+
+    for (int i = 0; i < h; i++)
+    {
+        const uint8_t *src = first_row + i * stride;
+        for (int x = 0; x < w; x++)
+        {
+            row[x * 3]     = src[x * 4];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+
+        jpeg_write_scanlines(&infot, rowptr, 1);
+    }
+
+    jpeg_finish_compress(&infot);
+    jpeg_destroy_compress(&infot);
 
     return true;
 }
 
 #endif
 
-bool load_from_file(std::string name, GLuint target)
+namespace
+{
+/* Decoded images, by path. Entries don't keep the images alive, so that an
+ * image is shared while it is in use, but freed afterwards. */
+struct cache_entry_t
+{
+    struct timespec mtime;
+    off_t size;
+    std::weak_ptr<const decoded_image_t> image;
+};
+
+std::mutex cache_mutex;
+std::unordered_map<std::string, cache_entry_t> cache;
+
+/* The most recently decoded images are kept alive, up to this many bytes, so
+ * that for ex. reloading the config doesn't decode them again */
+const size_t MAX_RECENT_BYTES = 64 << 20;
+std::deque<std::shared_ptr<const decoded_image_t>> recent;
+size_t recent_bytes = 0;
+
+bool operator ==(const struct timespec& a, const struct timespec& b)
+{
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+Loader *find_loader(const std::string& name)
 {
     if (access(name.c_str(), F_OK) == -1)
     {
         if (!name.empty())
         {
-            LOGE(__func__, "() cannot access ", name);
+            LOGE("cannot access image file ", name);
         }
 
-        return false;
+        return nullptr;
     }
 
     int len = name.length();
@@ -247,7 +350,7 @@ bool load_from_file(std::string name, GLuint target)
         LOGE(
             "load_from_file() called with file without extension or with invalid extension!");
 
-        return false;
+        return nullptr;
     }
 
     auto ext = name.substr(len - 3, 3);
@@ -261,11 +364,397 @@ bool load_from_file(std::string name, GLuint target)
     {
         LOGE("load_from_file() called with unsupported extension ", ext);
 
+        return nullptr;
+    }
+
+    return &it->second;
+}
+}
+
+std::shared_ptr<const decoded_image_t> decode_file(std::string name)
+{
+    auto loader = find_loader(name);
+    struct stat st;
+    if (!loader || (stat(name.c_str(), &st) == -1))
+    {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(name);
+        if ((it != cache.end()) && (it->second.mtime == st.st_mtim) &&
+            (it->second.size == st.st_size))
+        {
+            if (auto image = it->second.image.lock())
+            {
+                return image;
+            }
+        }
+    }
+
+    /* Don't hold the lock while decoding, it may take a long time */
+    std::shared_ptr<const decoded_image_t> image = (*loader)(name.c_str());
+    if (!image)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache[name] = {st.st_mtim, st.st_size, image};
+
+    recent.push_back(image);
+    recent_bytes += image->pixels.size();
+    while (recent_bytes > MAX_RECENT_BYTES)
+    {
+        recent_bytes -= recent.front()->pixels.size();
+        recent.pop_front();
+    }
+
+    return image;
+}
+
+bool load_from_file(std::string name, GLuint target)
+{
+    auto image = decode_file(name);
+    if (!image)
+    {
         return false;
-    } else
+    }
+
+    /* Rows of RGB images are not aligned to 4 bytes */
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CALL(glTexImage2D(target, 0, image->format, image->width, image->height,
+        0, image->format, GL_UNSIGNED_BYTE, image->pixels.data()));
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+
+    return true;
+}
+
+namespace
+{
+/* Runs jobs on a worker thread. When a job is done, its completion callback
+ * is called on the main thread, which is notified through an eventfd */
+class worker_t
+{
+  public:
+    /* Run work on the worker thread, and then done on the main thread */
+    void submit(std::function<void()> work, std::function<void()> done)
+    {
+        if (!thread.joinable())
+        {
+            event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            wl_event_loop_add_fd(wf::get_core().ev_loop, event_fd,
+                WL_EVENT_READABLE, handle_done, this);
+            thread = std::thread([=] () { run(); });
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back({work, done});
+        condition.notify_one();
+    }
+
+    ~worker_t()
+    {
+        if (thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+                condition.notify_one();
+            }
+
+            thread.join();
+        }
+    }
+
+  private:
+    struct job_t
+    {
+        std::function<void()> work, done;
+    };
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<job_t> pending, finished;
+    bool quit = false;
+    int event_fd = -1;
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            condition.wait(lock, [=] () { return quit || !pending.empty(); });
+            if (quit)
+            {
+                return;
+            }
+
+            auto job = std::move(pending.front());
+            pending.pop_front();
+
+            lock.unlock();
+            job.work();
+            lock.lock();
+
+            finished.push_back(std::move(job));
+            uint64_t count = 1;
+            write(event_fd, &count, sizeof(count));
+        }
+    }
+
+    static int handle_done(int fd, uint32_t mask, void *data)
+    {
+        auto self = (worker_t*)data;
+
+        uint64_t count;
+        read(fd, &count, sizeof(count));
+
+        std::deque<job_t> jobs;
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            std::swap(jobs, self->finished);
+        }
+
+        for (auto& job : jobs)
+        {
+            job.done();
+        }
+
+        return 0;
+    }
+};
+
+/* Decoding and encoding use separate threads, so that a long encode doesn't
+ * delay loading images */
+worker_t decode_worker, encode_worker;
+
+class async_load_impl_t;
+
+/* An image to decode on the worker thread */
+struct decode_job_t
+{
+    std::string name;
+    std::shared_ptr<const decoded_image_t> image;
+
+    /* The load waiting for the job, or nullptr if it was cancelled.
+     * Accessed only on the main thread */
+    async_load_impl_t *load;
+};
+
+/* Images are uploaded in bands of at most this many bytes, for all targets */
+const size_t UPLOAD_BAND_BYTES = 4 << 20;
+
+class async_load_impl_t : public async_load_t
+{
+  public:
+    async_load_impl_t(GLuint tex, std::vector<GLenum> targets,
+        std::function<void(bool)> callback)
     {
-        return it->second(name.c_str(), target);
+        this->tex     = tex;
+        this->targets = targets;
+        this->callback = callback;
     }
+
+    ~async_load_impl_t()
+    {
+        if (job)
+        {
+            job->load = nullptr;
+        }
+
+        release_pbo();
+    }
+
+    bool is_done() const override
+    {
+        return done;
+    }
+
+    void start(std::string name)
+    {
+        job = std::make_shared<decode_job_t>();
+        job->name = name;
+        job->load = this;
+
+        auto decode_job = job;
+        decode_worker.submit([decode_job] ()
+        {
+            decode_job->image = decode_file(decode_job->name);
+        }, [decode_job] ()
+        {
+            if (decode_job->load)
+            {
+                decode_job->load->handle_decoded();
+            }
+        });
+    }
+
+    void handle_decoded()
+    {
+        image = job->image;
+        job.reset();
+        if (!image || !image->width || !image->height)
+        {
+            finish(false);
+
+            return;
+        }
+
+        upload_band();
+    }
+
+  private:
+    GLuint tex;
+    std::vector<GLenum> targets;
+    std::function<void(bool)> callback;
+
+    std::shared_ptr<decode_job_t> job;
+    std::shared_ptr<const decoded_image_t> image;
+    int uploaded_rows = 0;
+    bool done = false;
+    wf::wl_timer upload_timer;
+    /* The pixel buffer object the bands are staged in */
+    GLuint pbo = 0;
+
+    static GLenum get_binding_target(GLenum target)
+    {
+        if ((target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X) &&
+            (target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z))
+        {
+            return GL_TEXTURE_CUBE_MAP;
+        }
+
+        return target;
+    }
+
+    void upload_band()
+    {
+        size_t stride = image->pixels.size() / image->height;
+        int rows = std::max<size_t>(1,
+            UPLOAD_BAND_BYTES / (stride * targets.size()));
+        rows = std::min(rows, image->height - uploaded_rows);
+
+        OpenGL::render_begin();
+        if (uploaded_rows == 0)
+        {
+            allocate_storage();
+        }
+
+        auto band_pixels = stage_band(uploaded_rows * stride, rows * stride);
+        GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        for (auto target : targets)
+        {
+            auto binding = get_binding_target(target);
+            GL_CALL(glBindTexture(binding, tex));
+            GL_CALL(glTexSubImage2D(target, 0, 0, uploaded_rows, image->width,
+                rows, image->format, GL_UNSIGNED_BYTE, band_pixels));
+            GL_CALL(glBindTexture(binding, 0));
+        }
+
+        GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        OpenGL::render_end();
+
+        uploaded_rows += rows;
+        if (uploaded_rows < image->height)
+        {
+            /* Let the outputs render before uploading the next band */
+            upload_timer.set_timeout(1, [=] () { upload_band(); });
+        } else
+        {
+            finish(true);
+        }
+    }
+
+    /**
+     * Allocate the full size of every target. This must happen while no pixel
+     * unpack buffer is bound, otherwise the NULL data pointer would be read as
+     * offset 0 into the buffer, which only holds a single band.
+     */
+    void allocate_storage()
+    {
+        for (auto target : targets)
+        {
+            auto binding = get_binding_target(target);
+            GL_CALL(glBindTexture(binding, tex));
+            GL_CALL(glTexImage2D(target, 0, image->format, image->width,
+                image->height, 0, image->format, GL_UNSIGNED_BYTE, NULL));
+            GL_CALL(glBindTexture(binding, 0));
+        }
+    }
+
+    /**
+     * Copy a band of the image to the pixel buffer object and leave it bound,
+     * so that the driver can transfer it to the textures asynchronously,
+     * the same way framebuffer_base_t::read_pixels_async() reads back.
+     *
+     * Must be called between OpenGL::render_begin() and OpenGL::render_end().
+     *
+     * @return The pixels argument for glTexSubImage2D(). If the buffer cannot
+     *   be mapped, the band is uploaded directly from the decoded image.
+     */
+    const GLvoid *stage_band(size_t offset, size_t size)
+    {
+        if (!pbo)
+        {
+            GL_CALL(glGenBuffers(1, &pbo));
+        }
+
+        /* Reallocating the storage lets the driver keep the previous band
+         * in flight instead of waiting for it to be consumed */
+        GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo));
+        GL_CALL(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL,
+            GL_STREAM_DRAW));
+        auto data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (data)
+        {
+            std::memcpy(data, image->pixels.data() + offset, size);
+            if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+            {
+                return NULL;
+            }
+        }
+
+        GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+        return image->pixels.data() + offset;
+    }
+
+    void release_pbo()
+    {
+        if (pbo)
+        {
+            OpenGL::render_begin();
+            GL_CALL(glDeleteBuffers(1, &pbo));
+            OpenGL::render_end();
+            pbo = 0;
+        }
+    }
+
+    void finish(bool success)
+    {
+        done = true;
+        image.reset();
+        release_pbo();
+
+        /* The callback may destroy this load */
+        auto cb = callback;
+        cb(success);
+    }
+};
+}
+
+std::unique_ptr<async_load_t> load_from_file_async(std::string name, GLuint tex,
+    std::vector<GLenum> targets, std::function<void(bool)> callback)
+{
+    auto load = std::make_unique<async_load_impl_t>(tex, targets, callback);
+    load->start(name);
+
+    return load;
 }
 
 void write_to_file(std::string name, uint8_t *pixels, int w, int h, std::string type)
@@ -275,19 +764,60 @@ void write_to_file(std::string name, uint8_t *pixels, int w, int h, std::string
     if (it == writers.end())
     {
         LOGE("unsupported image_writer backend");
-    } else
+
+        return;
+    }
+
+    FILE *fp = fopen(name.c_str(), "wb");
+    if (!fp)
     {
-        it->second(name.c_str(), pixels, w, h);
+        LOGE("failed to open ", name, " for writing");
+
+        return;
     }
+
+    /* The pixels are stored from the bottom row to the top one */
+    it->second(fp, pixels + (ptrdiff_t)(h - 1) * w * 4, w, h, -(ptrdiff_t)w * 4);
+    fclose(fp);
+}
+
+void write_to_fd_async(int fd, std::string type, const uint8_t *first_row,
+    int width, int height, ptrdiff_t stride, std::function<void(bool)> callback)
+{
+    auto it = writers.find(type);
+    if (it == writers.end())
+    {
+        LOGE("unsupported image_writer backend ", type);
+    }
+
+    Writer writer = (it == writers.end()) ? nullptr : it->second;
+    auto success  = std::make_shared<bool>(false);
+    encode_worker.submit([=] ()
+    {
+        FILE *fp = writer ? fdopen(fd, "wb") : nullptr;
+        if (!fp)
+        {
+            close(fd);
+
+            return;
+        }
+
+        *success = writer(fp, first_row, width, height, stride);
+        *success &= (fclose(fp) == 0);
+    }, [=] ()
+    {
+        callback(*success);
+    });
 }
 
 void init()
 {
     LOGD("init ImageIO");
 #ifdef BUILD_WITH_IMAGEIO
-    loaders["png"] = Loader(texture_from_png);
-    loaders["jpg"] = Loader(texture_from_jpeg);
-    writers["png"] = Writer(texture_to_png);
+    loaders["png"] = Loader(decode_png);
+    loaders["jpg"] = Loader(decode_jpeg);
+    writers["png"] = Writer(encode_png);
+    writers["jpg"] = Writer(encode_jpeg);
 #endif
 }
 }
@@ -0,0 +1,131 @@
+#ifndef WF_MATCHER_CACHE_HPP
+#define WF_MATCHER_CACHE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The parts of the view matcher result cache which do not depend on views.
+ * They are shared with benchmarks/matcher.cpp, so this header must not depend
+ * on wlroots or on the compositor.
+ */
+namespace wf
+{
+/**
+ * Each matcher gets a small index, so that the views can store its results in
+ * a vector. Indices are reused after the matcher is destroyed.
+ */
+class matcher_slots_t
+{
+  public:
+    static size_t acquire()
+    {
+        auto& used = get();
+        auto it    = std::find(used.begin(), used.end(), false);
+        if (it == used.end())
+        {
+            used.push_back(true);
+
+            return used.size() - 1;
+        }
+
+        *it = true;
+
+        return it - used.begin();
+    }
+
+    static void release(size_t slot)
+    {
+        get()[slot] = false;
+    }
+
+  private:
+    static std::vector<bool>& get()
+    {
+        static std::vector<bool> used;
+
+        return used;
+    }
+};
+
+/**
+ * The results of the matchers evaluated for one view, indexed by slot.
+ *
+ * A result stays valid as long as the state of the properties read while
+ * computing it is the same. The caller provides the state, as a function of
+ * the bitmask of properties.
+ */
+class matcher_results_t
+{
+  public:
+    /** The values of the properties a result depends on. */
+    struct state_t
+    {
+        int64_t title_version  = 0;
+        int64_t app_id_version = 0;
+        /* The other properties, packed into one word */
+        uint64_t flags = 0;
+
+        bool operator ==(const state_t& other) const
+        {
+            return title_version == other.title_version &&
+                   app_id_version == other.app_id_version &&
+                   flags == other.flags;
+        }
+    };
+
+    struct result_t
+    {
+        /* The condition the result was computed with, 0 if none */
+        uint64_t condition_id = 0;
+        uint32_t properties;
+        state_t state;
+        bool matches;
+    };
+
+    /**
+     * @param get_state Called with a bitmask of properties, returns their
+     *   current state.
+     * @return The stored result of the given matcher, if still valid.
+     */
+    template<class GetState>
+    const result_t *find(size_t slot, uint64_t condition_id,
+        GetState&& get_state) const
+    {
+        if ((slot >= results.size()) ||
+            (results[slot].condition_id != condition_id))
+        {
+            return nullptr;
+        }
+
+        auto& result = results[slot];
+        if (get_state(result.properties) == result.state)
+        {
+            return &result;
+        }
+
+        return nullptr;
+    }
+
+    void store(size_t slot, uint64_t condition_id, uint32_t properties,
+        const state_t& state, bool matches)
+    {
+        if (slot >= results.size())
+        {
+            results.resize(slot + 1);
+        }
+
+        auto& result = results[slot];
+        result.condition_id = condition_id;
+        result.properties   = properties;
+        result.state   = state;
+        result.matches = matches;
+    }
+
+  private:
+    std::vector<result_t> results;
+};
+}
+
+#endif /* end of include guard: WF_MATCHER_CACHE_HPP */
@@ -5,6 +5,179 @@
 #include <wayfire/condition/condition.hpp>
 #include <wayfire/view-access-interface.hpp>
 #include <wayfire/parser/condition_parser.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/workspace-manager.hpp>
+#include <algorithm>
+
+#include "matcher-cache.hpp"
+
+namespace
+{
+using view_property_t = wf::view_access_interface_t::property_t;
+
+/**
+ * An access interface which records the properties read during the evaluation
+ * of a condition.
+ */
+class recording_access_interface_t : public wf::access_interface_t
+{
+  public:
+    recording_access_interface_t(wayfire_view view) : view_access(view)
+    {}
+
+    wf::variant_t get(const std::string& identifier, bool& error) override
+    {
+        auto property = wf::view_access_interface_t::find_property(identifier);
+        properties |= (1u << property);
+        if (property == wf::view_access_interface_t::PROPERTY_UNKNOWN)
+        {
+            return view_access.get(identifier, error);
+        }
+
+        return view_access.get(property, error);
+    }
+
+    /** A bitmask of the properties which were read */
+    uint32_t properties = 0;
+
+  private:
+    wf::view_access_interface_t view_access;
+};
+
+/**
+ * The results of the matchers evaluated for a view.
+ *
+ * A result stays valid as long as none of the properties read while computing
+ * it have changed. Title and app_id changes are tracked with signals, so that
+ * the strings do not need to be compared. The other properties are cheap to
+ * read, so their current values are compared with the cached ones.
+ */
+class matcher_cache_t : public wf::custom_data_t
+{
+  public:
+    using state_t  = wf::matcher_results_t::state_t;
+    using result_t = wf::matcher_results_t::result_t;
+
+    matcher_cache_t(wayfire_view view)
+    {
+        view->connect_signal("title-changed", &on_title_changed);
+        view->connect_signal("app-id-changed", &on_app_id_changed);
+    }
+
+    /** @return The cached result of the given matcher, if still valid. */
+    const result_t *find(wayfire_view view, size_t slot, uint64_t condition_id)
+    {
+        return results.find(slot, condition_id, [&] (uint32_t properties)
+        {
+            return get_state(view, properties);
+        });
+    }
+
+    void store(wayfire_view view, size_t slot, uint64_t condition_id,
+        uint32_t properties, bool matches)
+    {
+        results.store(slot, condition_id, properties,
+            get_state(view, properties), matches);
+    }
+
+  private:
+    wf::matcher_results_t results;
+    int64_t title_version  = 0;
+    int64_t app_id_version = 0;
+
+    wf::signal_connection_t on_title_changed = [=] (wf::signal_data_t*)
+    {
+        ++title_version;
+    };
+
+    wf::signal_connection_t on_app_id_changed = [=] (wf::signal_data_t*)
+    {
+        ++app_id_version;
+    };
+
+    /**
+     * Get the values of the given properties of the view. Two states are
+     * equal if none of the properties have changed.
+     */
+    state_t get_state(wayfire_view view, uint32_t properties)
+    {
+        using wf::view_access_interface_t;
+        auto has = [&] (view_property_t property)
+        {
+            return (properties & (1u << property)) != 0;
+        };
+
+        state_t state;
+        if (has(view_access_interface_t::PROPERTY_TITLE))
+        {
+            state.title_version = title_version;
+        }
+
+        if (has(view_access_interface_t::PROPERTY_APP_ID))
+        {
+            state.app_id_version = app_id_version;
+        }
+
+        uint64_t flags = 0;
+        if (has(view_access_interface_t::PROPERTY_ROLE) ||
+            has(view_access_interface_t::PROPERTY_TYPE))
+        {
+            flags |= (uint64_t)view->role;
+        }
+
+        if (has(view_access_interface_t::PROPERTY_FULLSCREEN))
+        {
+            flags |= (uint64_t)view->fullscreen << 8;
+        }
+
+        if (has(view_access_interface_t::PROPERTY_ACTIVATED))
+        {
+            flags |= (uint64_t)view->activated << 9;
+        }
+
+        if (has(view_access_interface_t::PROPERTY_MINIMIZED))
+        {
+            flags |= (uint64_t)view->minimized << 10;
+        }
+
+        if (has(view_access_interface_t::PROPERTY_VISIBLE))
+        {
+            flags |= (uint64_t)view->is_visible() << 11;
+        }
+
+        if (has(view_access_interface_t::PROPERTY_FOCUSABLE))
+        {
+            flags |= (uint64_t)view->is_focuseable() << 12;
+        }
+
+        if (has(view_access_interface_t::PROPERTY_MAPPED))
+        {
+            flags |= (uint64_t)view->is_mapped() << 13;
+        }
+
+        if (has(view_access_interface_t::PROPERTY_TILED_LEFT) ||
+            has(view_access_interface_t::PROPERTY_TILED_RIGHT) ||
+            has(view_access_interface_t::PROPERTY_TILED_TOP) ||
+            has(view_access_interface_t::PROPERTY_TILED_BOTTOM) ||
+            has(view_access_interface_t::PROPERTY_MAXIMIZED) ||
+            has(view_access_interface_t::PROPERTY_FLOATING))
+        {
+            flags |= (uint64_t)view->tiled_edges << 16;
+        }
+
+        /* The type also depends on the layer of the view */
+        if (has(view_access_interface_t::PROPERTY_TYPE) && view->get_output())
+        {
+            uint64_t layer = view->get_output()->workspace->get_view_layer(view);
+            flags |= ((layer << 1) | 1) << 32;
+        }
+
+        state.flags = flags;
+
+        return state;
+    }
+};
+}
 
 class wf::view_matcher_t::impl
 {
@@ -32,8 +205,46 @@ class wf::view_matcher_t::impl
         return false;
     }
 
+    /* The index of the matcher in the result caches of the views */
+    size_t slot = wf::matcher_slots_t::acquire();
+    /* Identifies the current condition in the result caches of the views */
+    uint64_t condition_id = 0;
+
+    bool evaluate(wayfire_view view)
+    {
+        bool ignored = false;
+        if (!view)
+        {
+            wf::view_access_interface_t access_interface{view};
+
+            return condition->evaluate(access_interface, ignored);
+        }
+
+        auto cache = view->get_data<matcher_cache_t>();
+        if (!cache)
+        {
+            view->store_data(std::make_unique<matcher_cache_t>(view));
+            cache = view->get_data<matcher_cache_t>();
+        }
+
+        if (auto result = cache->find(view, slot, condition_id))
+        {
+            return result->matches;
+        }
+
+        recording_access_interface_t access_interface{view};
+        bool matches = condition->evaluate(access_interface, ignored);
+        cache->store(view, slot, condition_id, access_interface.properties,
+            matches);
+
+        return matches;
+    }
+
     wf::config::option_base_t::updated_callback_t update_condition = [=] ()
     {
+        static uint64_t last_condition_id = 0;
+        condition_id = ++last_condition_id;
+
         if (!try_parse(option->get_value(), option->get_name()))
         {
             if (option->get_value() != option->get_default_value())
@@ -74,6 +285,7 @@ class wf::view_matcher_t::impl
     ~impl()
     {
         disconnect_updated_handler();
+        wf::matcher_slots_t::release(slot);
     }
 };
 
@@ -106,10 +318,7 @@ bool wf::view_matcher_t::matches(wayfire_view view)
 {
     if (this->priv->condition)
     {
-        bool ignored = false;
-        wf::view_access_interface_t access_interface{view};
-
-        return this->priv->condition->evaluate(access_interface, ignored);
+        return this->priv->evaluate(view);
     }
 
     return false;
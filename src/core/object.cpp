@@ -1,28 +1,34 @@
 #include "wayfire/object.hpp"
-#include "wayfire/nonstd/safe-list.hpp"
 #include <unordered_map>
-#include <set>
+#include <algorithm>
+#include <vector>
 
 /* Implementation note: because of circular dependencies between
  * signal_connection_t and signal_provider_t, the chosen way to resolve
  * them is to have signal_provider_t directly modify signal_connection_t
- * private data when needed. */
+ * private data when needed.
+ *
+ * Each connection to a signal is stored twice: as an entry in the provider's
+ * list of connections for the signal, and as a link in the connection's list
+ * of providers. The entry and the link store each other's index, so that
+ * either side can remove a connection in constant time. */
 
 class wf::signal_connection_t::impl
 {
   public:
     signal_callback_t callback;
-    std::set<nonstd::observer_ptr<signal_provider_t>> connected_providers;
 
-    void add(signal_provider_t *provider)
+    /** A connection to a single signal of a provider. */
+    struct link_t
     {
-        connected_providers.insert(provider);
-    }
-
-    void remove(signal_provider_t *provider)
-    {
-        connected_providers.erase(provider);
-    }
+        signal_provider_t *provider;
+        /* Index of the signal's slot in the provider */
+        uint32_t slot;
+        /* Index of the entry in the slot's connections */
+        uint32_t entry;
+    };
+
+    std::vector<link_t> links;
 };
 
 wf::signal_connection_t::signal_connection_t()
@@ -48,23 +54,206 @@ void wf::signal_connection_t::emit(signal_data_t *data)
     }
 }
 
-void wf::signal_connection_t::disconnect()
+namespace
 {
-    auto connected = this->priv->connected_providers;
-    for (auto& provider : connected)
+/** A global table of interned names. */
+struct name_registry_t
+{
+    std::unordered_map<std::string, uint32_t> ids;
+
+    /** Get the ID of the given name, registering it if needed. */
+    uint32_t get(const std::string& name)
+    {
+        auto it = ids.find(name);
+        if (it != ids.end())
+        {
+            return it->second;
+        }
+
+        uint32_t id = ids.size();
+        ids[name] = id;
+
+        return id;
+    }
+
+    /** Find the ID of an already registered name, without registering it. */
+    bool find(const std::string& name, uint32_t& id) const
     {
-        provider->disconnect_signal(this);
+        auto it = ids.find(name);
+        if (it == ids.end())
+        {
+            return false;
+        }
+
+        id = it->second;
+
+        return true;
     }
+
+    static name_registry_t& signals()
+    {
+        static name_registry_t registry;
+        return registry;
+    }
+
+    static name_registry_t& custom_data()
+    {
+        static name_registry_t registry;
+        return registry;
+    }
+};
+}
+
+wf::signal_id_t wf::get_signal_id(const std::string& name)
+{
+    return name_registry_t::signals().get(name);
+}
+
+/** Find the ID of an already registered signal, without registering it. */
+static bool find_signal_id(const std::string& name, wf::signal_id_t& id)
+{
+    return name_registry_t::signals().find(name, id);
+}
+
+wf::custom_data_id_t wf::get_custom_data_id(const std::string& name)
+{
+    return name_registry_t::custom_data().get(name);
 }
 
 class wf::signal_provider_t::sprovider_impl
 {
   public:
-    std::unordered_map<std::string,
-        wf::safe_list_t<signal_connection_t*>> signals;
+    /** A connection in the list of a signal. */
+    struct entry_t
+    {
+        /* The connection, or null if it has been disconnected */
+        signal_connection_t *connection;
+        /* Index of the corresponding link in the connection */
+        uint32_t link;
+    };
+
+    /**
+     * The connections of a single signal.
+     *
+     * Disconnected entries are set to null, and removed in bulk later, when
+     * the provider is not emitting signals. Connections added during an
+     * emission are appended, and are not called for the ongoing emission.
+     */
+    struct signal_slot_t
+    {
+        signal_id_t id;
+        std::vector<entry_t> connections;
+        /* Number of null entries in connections */
+        uint32_t dead = 0;
+
+        std::vector<signal_callback_t*> deprecated;
+    };
+
+    /* Providers usually have only a few signals with connections, so a linear
+     * search is faster than hashing. Slots are never removed, so their indices
+     * stay valid. */
+    std::vector<signal_slot_t> slots;
+
+    /* Nesting level of emit_signal() */
+    int emitting = 0;
+    /* Whether there are null entries to be removed */
+    bool dirty = false;
+
+    /** @return The index of the slot for the given signal, or -1 */
+    int find_slot(signal_id_t id) const
+    {
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            if (slots[i].id == id)
+            {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    uint32_t get_slot(signal_id_t id)
+    {
+        int idx = find_slot(id);
+        if (idx >= 0)
+        {
+            return idx;
+        }
+
+        slots.push_back({});
+        slots.back().id = id;
+
+        return slots.size() - 1;
+    }
+
+    /** Mark the given entry as disconnected. */
+    void kill_entry(uint32_t slot, uint32_t entry)
+    {
+        slots[slot].connections[entry].connection = nullptr;
+        slots[slot].dead++;
+        dirty = true;
+    }
+
+    /**
+     * Remove the link with the given index from the connection, by moving the
+     * last link in its place. The entry of the moved link is updated.
+     */
+    static void remove_link(signal_connection_t *connection, uint32_t idx)
+    {
+        auto& links = connection->priv->links;
+        if (idx + 1 < links.size())
+        {
+            links[idx] = links.back();
+            auto& moved = links[idx];
+            moved.provider->sprovider_priv->slots[moved.slot]
+                .connections[moved.entry].link = idx;
+        }
+
+        links.pop_back();
+    }
 
-    std::unordered_map<std::string,
-        wf::safe_list_t<signal_callback_t*>> deprecated_signals;
+    /** Remove the null entries, unless an emission is in progress. */
+    void cleanup()
+    {
+        if (!dirty || emitting)
+        {
+            return;
+        }
+
+        for (auto& slot : slots)
+        {
+            auto& dep = slot.deprecated;
+            dep.erase(std::remove(dep.begin(), dep.end(), nullptr), dep.end());
+
+            /* Compact only when enough entries have died, so that removing
+             * entries one by one stays amortized constant time */
+            auto& entries = slot.connections;
+            if (slot.dead * 2 < entries.size())
+            {
+                continue;
+            }
+
+            uint32_t alive = 0;
+            for (auto& entry : entries)
+            {
+                if (entry.connection)
+                {
+                    entry.connection->priv->links[entry.link].entry = alive;
+                    entries[alive++] = entry;
+                }
+            }
+
+            entries.resize(alive);
+            slot.dead = 0;
+        }
+
+        dirty = false;
+        for (auto& slot : slots)
+        {
+            dirty |= slot.dead > 0;
+        }
+    }
 };
 
 wf::signal_provider_t::signal_provider_t()
@@ -74,74 +263,167 @@ wf::signal_provider_t::signal_provider_t()
 
 wf::signal_provider_t::~signal_provider_t()
 {
-    for (auto& s : sprovider_priv->signals)
+    for (auto& slot : sprovider_priv->slots)
     {
-        s.second.for_each([=] (signal_connection_t *connection)
+        for (auto& entry : slot.connections)
         {
-            connection->priv->remove(this);
-        });
+            if (entry.connection)
+            {
+                sprovider_impl::remove_link(entry.connection, entry.link);
+            }
+        }
+    }
+}
+
+void wf::signal_connection_t::disconnect()
+{
+    auto& links = priv->links;
+    while (!links.empty())
+    {
+        auto link = links.back();
+        links.pop_back();
+
+        auto provider = link.provider->sprovider_priv.get();
+        provider->kill_entry(link.slot, link.entry);
+        provider->cleanup();
     }
 }
 
 void wf::signal_provider_t::connect_signal(std::string name,
     signal_connection_t *callback)
 {
-    sprovider_priv->signals[name].push_back(callback);
-    callback->priv->add(this);
+    connect_signal(get_signal_id(name), callback);
+}
+
+void wf::signal_provider_t::connect_signal(signal_id_t id,
+    signal_connection_t *callback)
+{
+    uint32_t slot = sprovider_priv->get_slot(id);
+    auto& entries = sprovider_priv->slots[slot].connections;
+    auto& links   = callback->priv->links;
+
+    entries.push_back({callback, (uint32_t)links.size()});
+    links.push_back({this, slot, (uint32_t)entries.size() - 1});
 }
 
 void wf::signal_provider_t::disconnect_signal(signal_connection_t *connection)
 {
-    for (auto& s : sprovider_priv->signals)
+    /* Only the links of the connection need to be checked. Iterating backwards
+     * is safe, because remove_link() moves already visited links. */
+    auto& links = connection->priv->links;
+    for (int i = (int)links.size() - 1; i >= 0; i--)
     {
-        s.second.remove_if([=] (signal_connection_t *connected)
+        if (links[i].provider == this)
         {
-            if (connected == connection)
-            {
-                connected->priv->remove(this);
-
-                return true;
-            }
-
-            return false;
-        });
+            sprovider_priv->kill_entry(links[i].slot, links[i].entry);
+            sprovider_impl::remove_link(connection, i);
+        }
     }
+
+    sprovider_priv->cleanup();
 }
 
 /* Deprecated: */
 void wf::signal_provider_t::connect_signal(std::string name,
     signal_callback_t *callback)
 {
-    sprovider_priv->deprecated_signals[name].push_back(callback);
+    uint32_t slot = sprovider_priv->get_slot(get_signal_id(name));
+    sprovider_priv->slots[slot].deprecated.push_back(callback);
 }
 
 /* Deprecated: */
 void wf::signal_provider_t::disconnect_signal(std::string name,
     signal_callback_t *callback)
 {
-    sprovider_priv->deprecated_signals[name].remove_all(callback);
+    signal_id_t id;
+    if (!find_signal_id(name, id))
+    {
+        return;
+    }
+
+    int idx = sprovider_priv->find_slot(id);
+    if (idx >= 0)
+    {
+        for (auto& entry : sprovider_priv->slots[idx].deprecated)
+        {
+            if (entry == callback)
+            {
+                entry = nullptr;
+                sprovider_priv->dirty = true;
+            }
+        }
+
+        sprovider_priv->cleanup();
+    }
 }
 
 /* Emit the given signal. No type checking for data is required */
 void wf::signal_provider_t::emit_signal(std::string name, wf::signal_data_t *data)
 {
-    sprovider_priv->signals[name].for_each([data] (auto call)
+    /* A signal which was never registered can't have any connections */
+    signal_id_t id;
+    if (find_signal_id(name, id))
+    {
+        emit_signal(id, data);
+    }
+}
+
+void wf::signal_provider_t::emit_signal(signal_id_t id, wf::signal_data_t *data)
+{
+    auto& priv = *sprovider_priv;
+    int idx    = priv.find_slot(id);
+    if (idx < 0)
     {
-        call->emit(data);
-    });
+        return;
+    }
+
+    /* Callbacks may connect to other signals, which may reallocate the slots,
+     * so the slot has to be looked up again after each call. */
+    ++priv.emitting;
+    size_t count = priv.slots[idx].connections.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        auto connection = priv.slots[idx].connections[i].connection;
+        if (connection)
+        {
+            connection->emit(data);
+        }
+    }
 
     /* Deprecated: */
-    sprovider_priv->deprecated_signals[name].for_each([data] (auto call)
+    count = priv.slots[idx].deprecated.size();
+    for (size_t i = 0; i < count; i++)
     {
-        (*call)(data);
-    });
+        auto callback = priv.slots[idx].deprecated[i];
+        if (callback)
+        {
+            (*callback)(data);
+        }
+    }
+
+    --priv.emitting;
+    priv.cleanup();
 }
 
+/* Objects usually hold only a few pieces of custom data, so they are kept in a
+ * small vector which is searched linearly by ID. */
 class wf::object_base_t::obase_impl
 {
   public:
-    std::unordered_map<std::string, std::unique_ptr<custom_data_t>> data;
+    struct entry_t
+    {
+        custom_data_id_t id;
+        std::unique_ptr<custom_data_t> data;
+    };
+
+    std::vector<entry_t> data;
     uint32_t object_id;
+
+    std::vector<entry_t>::iterator find(custom_data_id_t id)
+    {
+        return std::find_if(data.begin(), data.end(),
+            [=] (const entry_t& entry) { return entry.id == id; });
+    }
 };
 
 wf::object_base_t::object_base_t()
@@ -167,42 +449,84 @@ uint32_t wf::object_base_t::get_id() const
 
 bool wf::object_base_t::has_data(std::string name)
 {
-    return obase_priv->data[name] != nullptr;
+    return _fetch_data(name) != nullptr;
 }
 
 void wf::object_base_t::erase_data(std::string name)
 {
-    auto data = std::move(obase_priv->data[name]);
-    obase_priv->data.erase(name);
-    data.reset();
+    _fetch_erase(name).reset();
 }
 
-wf::custom_data_t*wf::object_base_t::_fetch_data(std::string name)
+wf::custom_data_t*wf::object_base_t::_fetch_data(custom_data_id_t id)
 {
-    auto it = obase_priv->data.find(name);
+    auto it = obase_priv->find(id);
     if (it == obase_priv->data.end())
     {
         return nullptr;
     }
 
-    return it->second.get();
+    return it->data.get();
+}
+
+wf::custom_data_t*wf::object_base_t::_fetch_data(const std::string& name)
+{
+    custom_data_id_t id;
+    if (!name_registry_t::custom_data().find(name, id))
+    {
+        return nullptr;
+    }
+
+    return _fetch_data(id);
 }
 
-wf::custom_data_t*wf::object_base_t::_fetch_erase(std::string name)
+std::unique_ptr<wf::custom_data_t> wf::object_base_t::_fetch_erase(
+    custom_data_id_t id)
 {
-    auto data = obase_priv->data[name].release();
-    erase_data(name);
+    auto it = obase_priv->find(id);
+    if (it == obase_priv->data.end())
+    {
+        return nullptr;
+    }
+
+    /* Remove the entry before the data is destroyed, in case the destructor
+     * of the data accesses the store again. */
+    auto data = std::move(it->data);
+    *it = std::move(obase_priv->data.back());
+    obase_priv->data.pop_back();
 
     return data;
 }
 
+std::unique_ptr<wf::custom_data_t> wf::object_base_t::_fetch_erase(
+    const std::string& name)
+{
+    custom_data_id_t id;
+    if (!name_registry_t::custom_data().find(name, id))
+    {
+        return nullptr;
+    }
+
+    return _fetch_erase(id);
+}
+
 void wf::object_base_t::_store_data(std::unique_ptr<wf::custom_data_t> data,
-    std::string name)
+    custom_data_id_t id)
 {
-    obase_priv->data[name] = std::move(data);
+    auto it = obase_priv->find(id);
+    if (it != obase_priv->data.end())
+    {
+        /* Keep the old data alive until the entry has been updated */
+        std::swap(it->data, data);
+        return;
+    }
+
+    obase_priv->data.push_back({id, std::move(data)});
 }
 
 void wf::object_base_t::_clear_data()
 {
+    /* Destructors of the data may access the store, so move it out first */
+    auto data = std::move(obase_priv->data);
     obase_priv->data.clear();
+    data.clear();
 }
@@ -1,5 +1,8 @@
 #include <wayfire/util/log.hpp>
 #include <map>
+#include <cmath>
+#include <algorithm>
+#include <vector>
 #include "opengl-priv.hpp"
 #include "wayfire/output.hpp"
 #include "core-impl.hpp"
@@ -58,6 +61,46 @@ namespace OpenGL
  * Each of the following functions uses the currently bound context
  */
 program_t program, color_program;
+
+namespace
+{
+/** Handles to the inputs of the builtin shaders, resolved in init() */
+struct builtin_handles_t
+{
+    program_t::attrib_t position, uv_position;
+    program_t::uniform_t mvp, color;
+
+    void resolve(program_t& prog)
+    {
+        position    = prog.get_attrib("position");
+        uv_position = prog.get_attrib("uvPosition");
+        mvp   = prog.get_uniform("MVP");
+        color = prog.get_uniform("color");
+    }
+} program_handles, color_program_handles;
+
+/**
+ * Quads queued by batch_texture() and batch_rectangle() which have not been
+ * drawn yet. All of them share the same program, texture, color and MVP.
+ */
+struct quad_batch_t
+{
+    /* Either &program or &color_program, nullptr if nothing is queued */
+    program_t *prog = nullptr;
+    wf::texture_t texture;
+    glm::vec4 color;
+    glm::mat4 mvp;
+
+    /* Interleaved x, y, u, v, 6 vertices per quad */
+    std::vector<GLfloat> vertices;
+
+    /* Persistent vertex buffer the vertices are streamed to */
+    GLuint vbo = 0;
+    /* Set while the batch is being drawn, see program_t::use() */
+    bool flushing = false;
+} batch;
+}
+
 GLuint compile_shader(std::string source, GLuint type)
 {
     GLuint shader = GL_CALL(glCreateShader(type));
@@ -110,12 +153,21 @@ void init()
     color_program.set_simple(compile_program(default_vertex_shader_source,
         color_rect_fragment_source));
 
+    program_handles.resolve(program);
+    color_program_handles.resolve(color_program);
+
     render_end();
 }
 
 void fini()
 {
     render_begin();
+    if (batch.vbo)
+    {
+        GL_CALL(glDeleteBuffers(1, &batch.vbo));
+        batch.vbo = 0;
+    }
+
     program.free_resources();
     color_program.free_resources();
     render_end();
@@ -143,6 +195,7 @@ void render_transformed_texture(wf::texture_t tex,
     const gl_geometry& g, const gl_geometry& texg,
     glm::mat4 model, glm::vec4 color, uint32_t bits)
 {
+    flush_batch();
     program.use(tex.type);
 
     gl_geometry final_g = g;
@@ -183,10 +236,10 @@ void render_transformed_texture(wf::texture_t tex,
     }
 
     program.set_active_texture(tex);
-    program.attrib_pointer("position", 2, 0, vertexData);
-    program.attrib_pointer("uvPosition", 2, 0, coordData);
-    program.uniformMatrix4f("MVP", model);
-    program.uniform4f("color", color);
+    program.attrib_pointer(program_handles.position, 2, 0, vertexData);
+    program.attrib_pointer(program_handles.uv_position, 2, 0, coordData);
+    program.uniformMatrix4f(program_handles.mvp, model);
+    program.uniform4f(program_handles.color, color);
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
@@ -220,6 +273,7 @@ void render_texture(wf::texture_t texture,
 void render_rectangle(wf::geometry_t geometry, wf::color_t color,
     glm::mat4 matrix)
 {
+    flush_batch();
     color_program.use(wf::TEXTURE_TYPE_RGBA);
     float x = geometry.x, y = geometry.y,
         w = geometry.width, h = geometry.height;
@@ -231,9 +285,11 @@ void render_rectangle(wf::geometry_t geometry, wf::color_t color,
         x, y,
     };
 
-    color_program.attrib_pointer("position", 2, 0, vertexData);
-    color_program.uniformMatrix4f("MVP", matrix);
-    color_program.uniform4f("color", {color.r, color.g, color.b, color.a});
+    auto& handles = color_program_handles;
+    color_program.attrib_pointer(handles.position, 2, 0, vertexData);
+    color_program.uniformMatrix4f(handles.mvp, matrix);
+    color_program.uniform4f(handles.color,
+        {color.r, color.g, color.b, color.a});
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
@@ -242,6 +298,183 @@ void render_rectangle(wf::geometry_t geometry, wf::color_t color,
     color_program.deactivate();
 }
 
+/**
+ * Start a new batch if the given parameters differ from the ones of the
+ * queued quads.
+ */
+static void prepare_batch(program_t *prog, const wf::texture_t& texture,
+    const glm::vec4& color, const glm::mat4& mvp)
+{
+    bool same_texture = (prog != &program) ||
+        ((batch.texture.type == texture.type) &&
+         (batch.texture.target == texture.target) &&
+         (batch.texture.tex_id == texture.tex_id) &&
+         (batch.texture.invert_y == texture.invert_y));
+
+    if ((batch.prog == prog) && same_texture && (batch.color == color) &&
+        (batch.mvp == mvp))
+    {
+        return;
+    }
+
+    flush_batch();
+    batch.prog    = prog;
+    batch.texture = texture;
+    batch.color   = color;
+    batch.mvp     = mvp;
+}
+
+/**
+ * Clip @quad to @clip and append it to the batch.
+ *
+ * @param quad The quad, x1/x2 and y1/y2 may be swapped to invert the texture.
+ * @param clip The clip box, already aligned to the framebuffer pixels.
+ */
+static void push_quad(const gl_geometry& quad, const gl_geometry& clip)
+{
+    float x1 = std::max(std::min(quad.x1, quad.x2), clip.x1);
+    float x2 = std::min(std::max(quad.x1, quad.x2), clip.x2);
+    float y1 = std::max(std::min(quad.y1, quad.y2), clip.y1);
+    float y2 = std::min(std::max(quad.y1, quad.y2), clip.y2);
+    if ((x1 >= x2) || (y1 >= y2))
+    {
+        return;
+    }
+
+    /* Same mapping as render_transformed_texture(): (x1, y2) is the origin of
+     * the texture, and (x2, y1) is its opposite corner. */
+    auto u = [&] (float x) { return (x - quad.x1) / (quad.x2 - quad.x1); };
+    auto v = [&] (float y) { return (quad.y2 - y) / (quad.y2 - quad.y1); };
+
+    const GLfloat corners[6][2] = {
+        {x1, y1}, {x2, y1}, {x2, y2},
+        {x1, y1}, {x2, y2}, {x1, y2},
+    };
+
+    for (auto& c : corners)
+    {
+        batch.vertices.insert(batch.vertices.end(),
+            {c[0], c[1], u(c[0]), v(c[1])});
+    }
+}
+
+/** Expand @clip to the pixel grid of @fb, like logic_scissor() does. */
+static gl_geometry align_clip(const wf::framebuffer_t& fb,
+    const wf::geometry_t& clip)
+{
+    /* Position relative to the framebuffer, in framebuffer pixels */
+    auto to_pixels = [&] (int value, int origin)
+    {
+        return (value - origin) * fb.scale;
+    };
+
+    gl_geometry result;
+    result.x1 = fb.geometry.x +
+        std::floor(to_pixels(clip.x, fb.geometry.x)) / fb.scale;
+    result.y1 = fb.geometry.y +
+        std::floor(to_pixels(clip.y, fb.geometry.y)) / fb.scale;
+    result.x2 = fb.geometry.x +
+        std::ceil(to_pixels(clip.x + clip.width, fb.geometry.x)) / fb.scale;
+    result.y2 = fb.geometry.y +
+        std::ceil(to_pixels(clip.y + clip.height, fb.geometry.y)) / fb.scale;
+
+    return result;
+}
+
+void batch_texture(wf::texture_t texture, const wf::framebuffer_t& fb,
+    const wf::geometry_t& geometry, const wf::geometry_t& clip,
+    glm::vec4 color, uint32_t bits)
+{
+    prepare_batch(&program, texture, color, fb.get_orthographic_projection());
+
+    gl_geometry quad;
+    quad.x1 = geometry.x;
+    quad.y1 = geometry.y;
+    quad.x2 = quad.x1 + geometry.width;
+    quad.y2 = quad.y1 + geometry.height;
+
+    if (bits & TEXTURE_TRANSFORM_INVERT_Y)
+    {
+        std::swap(quad.y1, quad.y2);
+    }
+
+    if (bits & TEXTURE_TRANSFORM_INVERT_X)
+    {
+        std::swap(quad.x1, quad.x2);
+    }
+
+    push_quad(quad, align_clip(fb, clip));
+}
+
+void batch_rectangle(const wf::framebuffer_t& fb, const wf::geometry_t& box,
+    const wf::geometry_t& clip, wf::color_t color)
+{
+    prepare_batch(&color_program, batch.texture,
+        {color.r, color.g, color.b, color.a},
+        fb.get_orthographic_projection());
+
+    gl_geometry quad;
+    quad.x1 = box.x;
+    quad.y1 = box.y;
+    quad.x2 = quad.x1 + box.width;
+    quad.y2 = quad.y1 + box.height;
+    push_quad(quad, align_clip(fb, clip));
+}
+
+void flush_batch()
+{
+    if (batch.flushing || batch.vertices.empty())
+    {
+        return;
+    }
+
+    batch.flushing = true;
+    auto& prog = *batch.prog;
+    bool textured = (batch.prog == &program);
+    auto& handles = textured ? program_handles : color_program_handles;
+    if (textured)
+    {
+        prog.use(batch.texture.type);
+        prog.set_active_texture(batch.texture);
+    } else
+    {
+        prog.use(wf::TEXTURE_TYPE_RGBA);
+    }
+
+    if (batch.vbo == 0)
+    {
+        GL_CALL(glGenBuffers(1, &batch.vbo));
+    }
+
+    /* Re-specifying the whole buffer lets the driver orphan the storage used by
+     * the previous draw instead of waiting for it. */
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, batch.vbo));
+    GL_CALL(glBufferData(GL_ARRAY_BUFFER,
+        batch.vertices.size() * sizeof(GLfloat), batch.vertices.data(),
+        GL_STREAM_DRAW));
+
+    const int stride = 4 * sizeof(GLfloat);
+    prog.attrib_pointer(handles.position, 2, stride, (void*)0);
+    if (textured)
+    {
+        prog.attrib_pointer(handles.uv_position, 2, stride,
+            (void*)(2 * sizeof(GLfloat)));
+    }
+
+    prog.uniformMatrix4f(handles.mvp, batch.mvp);
+    prog.uniform4f(handles.color, batch.color);
+
+    GL_CALL(glEnable(GL_BLEND));
+    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, batch.vertices.size() / 4));
+
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    prog.deactivate();
+
+    batch.vertices.clear();
+    batch.flushing = false;
+}
+
 void render_begin()
 {
     /* No real reason for 10, 10, 0 but it doesn't matter */
@@ -255,6 +488,7 @@ void render_begin(const wf::framebuffer_base_t& fb)
 
 void render_begin(int32_t viewport_width, int32_t viewport_height, uint32_t fb)
 {
+    flush_batch();
     if (!current_output && !wlr_egl_is_current(wf::get_core_impl().egl))
     {
         wlr_egl_make_current(wf::get_core_impl().egl, EGL_NO_SURFACE, NULL);
@@ -267,12 +501,14 @@ void render_begin(int32_t viewport_width, int32_t viewport_height, uint32_t fb)
 
 void clear(wf::color_t col, uint32_t mask)
 {
+    flush_batch();
     GL_CALL(glClearColor(col.r, col.g, col.b, col.a));
     GL_CALL(glClear(mask));
 }
 
 void render_end()
 {
+    flush_batch();
     GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, current_output_fb));
     wlr_renderer_scissor(wf::get_core().renderer, NULL);
     wlr_renderer_end(wf::get_core().renderer);
@@ -303,6 +539,7 @@ static std::string framebuffer_status_to_str(
 
 bool wf::framebuffer_base_t::allocate(int width, int height)
 {
+    OpenGL::flush_batch();
     bool first_allocate = false;
     if (fb == (uint32_t)-1)
     {
@@ -394,17 +631,141 @@ wf::framebuffer_base_t& wf::framebuffer_base_t::operator =(
 
 void wf::framebuffer_base_t::bind() const
 {
+    OpenGL::flush_batch();
     GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb));
     GL_CALL(glViewport(0, 0, viewport_width, viewport_height));
 }
 
 void wf::framebuffer_base_t::scissor(wlr_box box) const
 {
+    OpenGL::flush_batch();
     GL_CALL(glEnable(GL_SCISSOR_TEST));
     GL_CALL(glScissor(box.x, viewport_height - box.y - box.height,
         box.width, box.height));
 }
 
+namespace
+{
+/* Pixels in a mapped pixel buffer object */
+struct pbo_pixels_t : public wf::readback_pixels_t
+{
+    GLuint pbo;
+
+    ~pbo_pixels_t()
+    {
+        OpenGL::render_begin();
+        GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo));
+        GL_CALL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+        GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+        GL_CALL(glDeleteBuffers(1, &pbo));
+        OpenGL::render_end();
+    }
+};
+
+class readback_impl_t : public wf::readback_t
+{
+  public:
+    readback_impl_t(GLuint fb, wlr_box box, wf::readback_callback_t callback)
+    {
+        this->box = box;
+        this->callback = callback;
+
+        OpenGL::flush_batch();
+        GL_CALL(glGenBuffers(1, &pbo));
+        GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo));
+        GL_CALL(glBufferData(GL_PIXEL_PACK_BUFFER, box.width * box.height * 4,
+            NULL, GL_STREAM_READ));
+        GLint old_fb;
+        GL_CALL(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &old_fb));
+        GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, fb));
+        GL_CALL(glReadPixels(box.x, box.y, box.width, box.height,
+            GL_RGBA, GL_UNSIGNED_BYTE, 0));
+        GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, old_fb));
+        GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        /* Make sure the fence gets to the GPU, otherwise it never signals */
+        GL_CALL(glFlush());
+
+        poll_timer.set_timeout(POLL_INTERVAL_MS, [=] () { poll(); });
+    }
+
+    ~readback_impl_t()
+    {
+        if (fence)
+        {
+            OpenGL::render_begin();
+            GL_CALL(glDeleteSync(fence));
+            GL_CALL(glDeleteBuffers(1, &pbo));
+            OpenGL::render_end();
+        }
+    }
+
+  private:
+    /* How often to check whether the GPU has finished the copy */
+    static constexpr uint32_t POLL_INTERVAL_MS = 2;
+
+    wlr_box box;
+    wf::readback_callback_t callback;
+    GLuint pbo;
+    GLsync fence;
+    wf::wl_timer poll_timer;
+
+    void poll()
+    {
+        OpenGL::render_begin();
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+        {
+            OpenGL::render_end();
+            poll_timer.set_timeout(POLL_INTERVAL_MS, [=] () { poll(); });
+
+            return;
+        }
+
+        GL_CALL(glDeleteSync(fence));
+        fence = NULL;
+
+        std::unique_ptr<pbo_pixels_t> pixels;
+        if (status != GL_WAIT_FAILED)
+        {
+            GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo));
+            auto data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                box.width * box.height * 4, GL_MAP_READ_BIT);
+            GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+            if (data)
+            {
+                pixels = std::make_unique<pbo_pixels_t>();
+                pixels->pbo    = pbo;
+                pixels->data   = (const uint8_t*)data;
+                pixels->width  = box.width;
+                pixels->height = box.height;
+            }
+        }
+
+        if (!pixels)
+        {
+            LOGE("Failed to read back framebuffer pixels");
+            GL_CALL(glDeleteBuffers(1, &pbo));
+        }
+
+        OpenGL::render_end();
+
+        /* The callback may destroy this readback */
+        auto cb = callback;
+        cb(std::move(pixels));
+    }
+};
+}
+
+std::unique_ptr<wf::readback_t> wf::framebuffer_base_t::read_pixels_async(
+    wlr_box box, readback_callback_t callback) const
+{
+    box.y = viewport_height - box.y - box.height;
+
+    return std::make_unique<readback_impl_t>(fb, box, callback);
+}
+
 void wf::framebuffer_base_t::release()
 {
     if ((fb != uint32_t(-1)) && (fb != 0))
@@ -545,46 +906,118 @@ wf::texture_t::texture_t(wlr_texture *texture)
 
 namespace OpenGL
 {
-class program_t::impl
+/**
+ * The locations of the uniforms or attributes of a program_t which have a
+ * handle. The index of a handle is the index of its name in @names.
+ */
+class location_table_t
 {
   public:
-    std::set<int> active_attrs;
-    std::set<int> active_attrs_divisors;
-
-    int active_program_idx = 0;
+    location_table_t(bool uniforms) : uniforms(uniforms)
+    {}
 
-    int id[wf::TEXTURE_TYPE_ALL];
-    std::map<std::string, int> uniforms[wf::TEXTURE_TYPE_ALL];
+    std::vector<std::string> names;
+    std::map<std::string, int> index;
+    std::vector<int> locations[wf::TEXTURE_TYPE_ALL];
 
-    /** Find the uniform location for the currently bound program */
-    int find_uniform_loc(const std::string& name)
+    /** Find or create the handle index for the given name. */
+    int find(const std::string& name, const int *ids)
     {
-        auto it = uniforms[active_program_idx].find(name);
-        if (it != uniforms[active_program_idx].end())
+        auto it = index.find(name);
+        if (it != index.end())
         {
             return it->second;
         }
 
-        uniforms[active_program_idx][name] =
-            GL_CALL(glGetUniformLocation(id[active_program_idx], name.c_str()));
+        int idx = names.size();
+        names.push_back(name);
+        index[name] = idx;
+        for (int i = 0; i < wf::TEXTURE_TYPE_ALL; i++)
+        {
+            locations[i].push_back(lookup(ids[i], name));
+        }
 
-        return uniforms[active_program_idx][name];
+        return idx;
     }
 
-    std::map<std::string, int> attribs[wf::TEXTURE_TYPE_ALL];
-    /** Find the attrib location for the currently bound program */
-    int find_attrib_loc(const std::string& name)
+    /** Resolve all names again, after the programs have changed. */
+    void resolve(const int *ids)
     {
-        auto it = attribs[active_program_idx].find(name);
-        if (it != attribs[active_program_idx].end())
+        for (int i = 0; i < wf::TEXTURE_TYPE_ALL; i++)
         {
-            return it->second;
+            locations[i].resize(names.size());
+            for (size_t j = 0; j < names.size(); j++)
+            {
+                locations[i][j] = lookup(ids[i], names[j]);
+            }
+        }
+    }
+
+    /** @return The location of the given handle, or -1 if it is invalid */
+    int get(int type, int idx) const
+    {
+        if ((idx < 0) || (idx >= (int)locations[type].size()))
+        {
+            return -1;
+        }
+
+        return locations[type][idx];
+    }
+
+  private:
+    bool uniforms;
+    int lookup(int program_id, const std::string& name)
+    {
+        if (program_id == 0)
+        {
+            return -1;
+        }
+
+        if (uniforms)
+        {
+            return GL_CALL(glGetUniformLocation(program_id, name.c_str()));
         }
 
-        attribs[active_program_idx][name] =
-            GL_CALL(glGetAttribLocation(id[active_program_idx], name.c_str()));
+        return GL_CALL(glGetAttribLocation(program_id, name.c_str()));
+    }
+};
+
+class program_t::impl
+{
+  public:
+    /* Vectors instead of sets, because they keep their memory when cleared
+     * and there are only a few attributes per program. */
+    std::vector<int> active_attrs;
+    std::vector<int> active_attrs_divisors;
+
+    int active_program_idx = 0;
+
+    int id[wf::TEXTURE_TYPE_ALL];
+    location_table_t uniforms{true};
+    location_table_t attribs{false};
+
+    /* Builtin uniforms used by set_active_texture() */
+    uniform_t y_base, y_mult;
+
+    /** Resolve all handles after the programs have been (re)created. */
+    void resolve_handles()
+    {
+        uniforms.resolve(id);
+        attribs.resolve(id);
+        y_base.index = uniforms.find("_wayfire_y_base", id);
+        y_mult.index = uniforms.find("_wayfire_y_mult", id);
+    }
+
+    /** Find the uniform location for the currently bound program */
+    int uniform_loc(uniform_t uniform)
+    {
+        return uniforms.get(active_program_idx, uniform.index);
+    }
 
-        return attribs[active_program_idx][name];
+    /** Find the attrib location for the currently bound program */
+    int attrib_loc(attrib_t attrib)
+    {
+        return attribs.get(active_program_idx, attrib.index);
     }
 };
 
@@ -602,6 +1035,7 @@ void program_t::set_simple(GLuint program_id, wf::texture_type_t type)
     free_resources();
     assert(type < wf::TEXTURE_TYPE_ALL);
     this->priv->id[type] = program_id;
+    priv->resolve_handles();
 }
 
 program_t::~program_t()
@@ -648,6 +1082,8 @@ void program_t::compile(const std::string& vertex_source,
         this->priv->id[program_type.first] =
             compile_program(vertex_source, fragment);
     }
+
+    priv->resolve_handles();
 }
 
 void program_t::free_resources()
@@ -664,6 +1100,9 @@ void program_t::free_resources()
 
 void program_t::use(wf::texture_type_t type)
 {
+    /* Quads queued before switching to another program have to be drawn first.
+     * Does nothing while the batch itself is being drawn. */
+    flush_batch();
     if (priv->id[type] == 0)
     {
         throw std::runtime_error("program_t has no program for type " +
@@ -679,51 +1118,103 @@ int program_t::get_program_id(wf::texture_type_t type)
     return priv->id[type];
 }
 
+program_t::uniform_t program_t::get_uniform(const std::string& name)
+{
+    return uniform_t{priv->uniforms.find(name, priv->id)};
+}
+
+program_t::attrib_t program_t::get_attrib(const std::string& name)
+{
+    return attrib_t{priv->attribs.find(name, priv->id)};
+}
+
+void program_t::uniform1i(uniform_t uniform, int value)
+{
+    GL_CALL(glUniform1i(priv->uniform_loc(uniform), value));
+}
+
+void program_t::uniform1f(uniform_t uniform, float value)
+{
+    GL_CALL(glUniform1f(priv->uniform_loc(uniform), value));
+}
+
+void program_t::uniform2f(uniform_t uniform, float x, float y)
+{
+    GL_CALL(glUniform2f(priv->uniform_loc(uniform), x, y));
+}
+
+void program_t::uniform4f(uniform_t uniform, const glm::vec4& value)
+{
+    GL_CALL(glUniform4f(priv->uniform_loc(uniform),
+        value.r, value.g, value.b, value.a));
+}
+
+void program_t::uniformMatrix4f(uniform_t uniform, const glm::mat4& value)
+{
+    GL_CALL(glUniformMatrix4fv(priv->uniform_loc(uniform),
+        1, GL_FALSE, &value[0][0]));
+}
+
+void program_t::attrib_pointer(attrib_t attrib,
+    int size, int stride, const void *ptr, GLenum type)
+{
+    int loc = priv->attrib_loc(attrib);
+    if (std::find(priv->active_attrs.begin(), priv->active_attrs.end(), loc) ==
+        priv->active_attrs.end())
+    {
+        priv->active_attrs.push_back(loc);
+    }
+
+    GL_CALL(glEnableVertexAttribArray(loc));
+    GL_CALL(glVertexAttribPointer(loc, size, type, GL_FALSE, stride, ptr));
+}
+
+void program_t::attrib_divisor(attrib_t attrib, int divisor)
+{
+    int loc = priv->attrib_loc(attrib);
+    auto& divisors = priv->active_attrs_divisors;
+    if (std::find(divisors.begin(), divisors.end(), loc) == divisors.end())
+    {
+        divisors.push_back(loc);
+    }
+
+    GL_CALL(glVertexAttribDivisor(loc, divisor));
+}
+
 void program_t::uniform1i(const std::string& name, int value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform1i(loc, value));
+    uniform1i(get_uniform(name), value);
 }
 
 void program_t::uniform1f(const std::string& name, float value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform1f(loc, value));
+    uniform1f(get_uniform(name), value);
 }
 
 void program_t::uniform2f(const std::string& name, float x, float y)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform2f(loc, x, y));
+    uniform2f(get_uniform(name), x, y);
 }
 
 void program_t::uniform4f(const std::string& name, const glm::vec4& value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform4f(loc, value.r, value.g, value.b, value.a));
+    uniform4f(get_uniform(name), value);
 }
 
 void program_t::uniformMatrix4f(const std::string& name, const glm::mat4& value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]));
+    uniformMatrix4f(get_uniform(name), value);
 }
 
 void program_t::attrib_pointer(const std::string& attrib,
     int size, int stride, const void *ptr, GLenum type)
 {
-    int loc = priv->find_attrib_loc(attrib);
-    priv->active_attrs.insert(loc);
-
-    GL_CALL(glEnableVertexAttribArray(loc));
-    GL_CALL(glVertexAttribPointer(loc, size, type, GL_FALSE, stride, ptr));
+    attrib_pointer(get_attrib(attrib), size, stride, ptr, type);
 }
 
 void program_t::attrib_divisor(const std::string& attrib, int divisor)
 {
-    int loc = priv->find_attrib_loc(attrib);
-    priv->active_attrs_divisors.insert(loc);
-    GL_CALL(glVertexAttribDivisor(loc, divisor));
+    attrib_divisor(get_attrib(attrib), divisor);
 }
 
 void program_t::set_active_texture(const wf::texture_t& texture)
@@ -732,8 +1223,8 @@ void program_t::set_active_texture(const wf::texture_t& texture)
     GL_CALL(glBindTexture(texture.target, texture.tex_id));
     GL_CALL(glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
 
-    uniform1f("_wayfire_y_base", texture.invert_y ? 1 : 0);
-    uniform1f("_wayfire_y_mult", texture.invert_y ? -1 : 1);
+    uniform1f(priv->y_base, texture.invert_y ? 1 : 0);
+    uniform1f(priv->y_mult, texture.invert_y ? -1 : 1);
 }
 
 void program_t::deactivate()
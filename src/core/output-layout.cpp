@@ -11,8 +11,13 @@
 #include "core-impl.hpp"
 
 #include <xf86drmMode.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
 #include <sstream>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 #include <unordered_set>
 
 #include <wayfire/util/log.hpp>
@@ -29,6 +34,7 @@ extern "C"
 #include <wlr/backend/noop.h>
 #include <wlr/backend/wayland.h>
 #include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_output_damage.h>
 #include <wlr/types/wlr_matrix.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_output_management_v1.h>
@@ -288,7 +294,8 @@ bool output_state_t::operator ==(const output_state_t& other) const
     if (source == OUTPUT_IMAGE_SOURCE_MIRROR)
     {
         return other.source == OUTPUT_IMAGE_SOURCE_MIRROR &&
-               mirror_from == other.mirror_from;
+               mirror_from == other.mirror_from &&
+               mirror_scaling == other.mirror_scaling;
     }
 
     bool eq = true;
@@ -309,6 +316,190 @@ bool output_state_t::operator ==(const output_state_t& other) const
     return eq;
 }
 
+#ifndef DMA_BUF_MAGIC
+ #define DMA_BUF_MAGIC 0x444d4142
+#endif
+
+/**
+ * Textures imported from the buffers of a mirrored output.
+ *
+ * Outputs cycle through a few buffers, so instead of importing the exported
+ * buffer each frame, the textures are kept and reused when the same buffer is
+ * exported again. A buffer is identified by the inode of its first plane and
+ * its layout. Inodes are unique only on kernels where dmabufs have their own
+ * filesystem, on older kernels buffers are imported each frame.
+ */
+class mirror_texture_cache_t
+{
+  public:
+    ~mirror_texture_cache_t()
+    {
+        clear();
+    }
+
+    /**
+     * Get a texture with the current contents of the given output.
+     *
+     * @return The texture, valid until the next call or until clear(), or
+     *   nullptr if the output contents couldn't be exported.
+     */
+    wlr_texture *get_texture(wlr_output *source)
+    {
+        destroy_uncached();
+
+        entry_t entry;
+        if (!wlr_output_export_dmabuf(source, &entry.attributes))
+        {
+            return nullptr;
+        }
+
+        bool cacheable = get_inode(entry.attributes.fd[0], entry.inode);
+        if (cacheable)
+        {
+            for (auto it = entries.begin(); it != entries.end(); ++it)
+            {
+                if (it->is_same_buffer(entry))
+                {
+                    /* Keep the most recently used buffers first */
+                    std::rotate(entries.begin(), it, it + 1);
+                    close_files(entry.attributes);
+
+                    return entries.front().texture;
+                }
+            }
+        }
+
+        entry.texture = wlr_texture_from_dmabuf(get_core().renderer,
+            &entry.attributes);
+        close_files(entry.attributes);
+        if (!entry.texture || !cacheable)
+        {
+            uncached = entry.texture;
+
+            return uncached;
+        }
+
+        /* Buffers of another size or format belong to an old swapchain */
+        for (auto& old : entries)
+        {
+            if (!old.is_same_format(entry))
+            {
+                wlr_texture_destroy(old.texture);
+                old.texture = nullptr;
+            }
+        }
+
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+            [] (const entry_t& old) { return !old.texture; }), entries.end());
+
+        if (entries.size() == MAX_ENTRIES)
+        {
+            wlr_texture_destroy(entries.back().texture);
+            entries.pop_back();
+        }
+
+        entries.insert(entries.begin(), entry);
+
+        return entry.texture;
+    }
+
+    /** Destroy all textures */
+    void clear()
+    {
+        destroy_uncached();
+        for (auto& entry : entries)
+        {
+            wlr_texture_destroy(entry.texture);
+        }
+
+        entries.clear();
+    }
+
+  private:
+    /* Outputs usually have two or three buffers */
+    static constexpr size_t MAX_ENTRIES = 4;
+
+    struct entry_t
+    {
+        ino_t inode;
+        /* The file descriptors are closed once the buffer is imported */
+        wlr_dmabuf_attributes attributes;
+        wlr_texture *texture = nullptr;
+
+        bool is_same_format(const entry_t& other) const
+        {
+            auto& a = attributes;
+            auto& b = other.attributes;
+
+            return a.width == b.width && a.height == b.height &&
+                   a.format == b.format && a.modifier == b.modifier &&
+                   a.flags == b.flags && a.n_planes == b.n_planes;
+        }
+
+        bool is_same_buffer(const entry_t& other) const
+        {
+            if ((inode != other.inode) || !is_same_format(other))
+            {
+                return false;
+            }
+
+            for (int i = 0; i < attributes.n_planes; i++)
+            {
+                if ((attributes.offset[i] != other.attributes.offset[i]) ||
+                    (attributes.stride[i] != other.attributes.stride[i]))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    /* Most recently used first */
+    std::vector<entry_t> entries;
+    /* The last texture which couldn't be cached */
+    wlr_texture *uncached = nullptr;
+
+    void destroy_uncached()
+    {
+        if (uncached)
+        {
+            wlr_texture_destroy(uncached);
+            uncached = nullptr;
+        }
+    }
+
+    /**
+     * Close the files of a buffer. wlr_dmabuf_attributes_finish() also sets
+     * n_planes to 0, but the layout is needed to find the buffer again.
+     */
+    static void close_files(wlr_dmabuf_attributes& attributes)
+    {
+        auto copy = attributes;
+        wlr_dmabuf_attributes_finish(&copy);
+        for (int i = 0; i < attributes.n_planes; i++)
+        {
+            attributes.fd[i] = -1;
+        }
+    }
+
+    static bool get_inode(int fd, ino_t& inode)
+    {
+        struct statfs fs;
+        struct stat st;
+        if ((fstatfs(fd, &fs) != 0) || (fs.f_type != DMA_BUF_MAGIC) ||
+            (fstat(fd, &st) != 0))
+        {
+            return false;
+        }
+
+        inode = st.st_ino;
+
+        return true;
+    }
+};
+
 /** Represents a single output in the output layout */
 struct output_layout_output_t
 {
@@ -516,8 +707,27 @@ struct output_layout_output_t
             state.source = OUTPUT_IMAGE_SOURCE_MIRROR;
 
             std::stringstream ss(set_mode);
+            std::string scaling;
             ss >> state.mirror_from; // skip the mirror word
-            ss >> state.mirror_from;
+            ss >> state.mirror_from >> scaling;
+
+            if (scaling.empty() || (scaling == "stretch"))
+            {
+                state.mirror_scaling = OUTPUT_MIRROR_STRETCH;
+            } else if (scaling == "fit")
+            {
+                state.mirror_scaling = OUTPUT_MIRROR_FIT;
+            } else if (scaling == "fill")
+            {
+                state.mirror_scaling = OUTPUT_MIRROR_FILL;
+            } else if (scaling == "center")
+            {
+                state.mirror_scaling = OUTPUT_MIRROR_CENTER;
+            } else
+            {
+                LOGE("Invalid mirror scaling for ", handle->name, " in config: ",
+                    scaling);
+            }
 
             state.mode = select_default_mode();
         } else
@@ -713,28 +923,115 @@ struct output_layout_output_t
     }
 
     /* Mirroring implementation */
-    wl_listener_wrapper on_mirrored_frame;
+    wl_listener_wrapper on_mirrored_precommit;
+    wl_listener_wrapper on_mirrored_present;
     wl_listener_wrapper on_frame;
+    wl_listener_wrapper on_mirror_damage_destroy;
     wlr_output *locked_cursors_on = NULL;
+    wlr_output_damage *mirror_damage = NULL;
+    mirror_texture_cache_t mirror_textures;
+    /* The buffer size of the mirrored output */
+    wf::dimensions_t mirrored_size = {0, 0};
+    /* Damage of the mirrored output, committed but not presented yet */
+    wf::region_t mirrored_damage;
+
+    /** Get the box where an image of the given size is shown */
+    wlr_box get_mirror_box(wf::dimensions_t size)
+    {
+        double scale_x = 1.0 * handle->width / size.width;
+        double scale_y = 1.0 * handle->height / size.height;
+        switch (current_state.mirror_scaling)
+        {
+          case OUTPUT_MIRROR_STRETCH:
+            return {0, 0, handle->width, handle->height};
+
+          case OUTPUT_MIRROR_FIT:
+            scale_x = scale_y = std::min(scale_x, scale_y);
+            break;
+
+          case OUTPUT_MIRROR_FILL:
+            scale_x = scale_y = std::max(scale_x, scale_y);
+            break;
+
+          case OUTPUT_MIRROR_CENTER:
+            scale_x = scale_y = 1.0;
+            break;
+        }
+
+        int width  = std::round(size.width * scale_x);
+        int height = std::round(size.height * scale_y);
+
+        return {(handle->width - width) / 2, (handle->height - height) / 2,
+            width, height};
+    }
+
+    /**
+     * Convert damage on the mirrored output to damage on this output.
+     *
+     * @param damage The damage, in buffer coordinates of the mirrored output.
+     * @param size The buffer size of the mirrored output.
+     */
+    wf::region_t get_mirror_damage(const wf::region_t& damage,
+        wf::dimensions_t size)
+    {
+        auto box = get_mirror_box(size);
+        double scale_x = 1.0 * box.width / size.width;
+        double scale_y = 1.0 * box.height / size.height;
+
+        wf::region_t result;
+        for (auto& rect : damage)
+        {
+            int x1 = box.x + std::floor(rect.x1 * scale_x);
+            int y1 = box.y + std::floor(rect.y1 * scale_y);
+            int x2 = box.x + std::ceil(rect.x2 * scale_x);
+            int y2 = box.y + std::ceil(rect.y2 * scale_y);
+            result |= wlr_box{x1, y1, x2 - x1, y2 - y1};
+        }
+
+        if ((box.width != size.width) || (box.height != size.height))
+        {
+            /* Filtering blends neighbouring pixels when scaling */
+            result.expand_edges(1);
+        }
+
+        return result & wlr_box{0, 0, handle->width, handle->height};
+    }
 
-    /** Render the output using texture as source */
-    void render_output(wlr_texture *texture)
+    /** Render the damaged parts of the output using texture as source */
+    void render_output(wlr_texture *texture, wf::dimensions_t size,
+        wf::region_t& damage)
     {
         auto renderer = get_core().renderer;
-        wlr_output_attach_render(handle, NULL);
         wlr_renderer_begin(renderer, handle->width, handle->height);
 
-        /* Project a box filling the whole screen */
-        float projection[9], box[9];
+        float projection[9], matrix[9];
         wlr_matrix_projection(projection, handle->width, handle->height,
             WL_OUTPUT_TRANSFORM_NORMAL);
 
-        wlr_box geometry = {0, 0, handle->width, handle->height};
-        wlr_matrix_project_box(box, &geometry, WL_OUTPUT_TRANSFORM_NORMAL,
+        wlr_box geometry = get_mirror_box(size);
+        wlr_matrix_project_box(matrix, &geometry, WL_OUTPUT_TRANSFORM_NORMAL,
             0.0, projection);
 
-        wlr_render_texture_with_matrix(renderer, texture, box, 1.0);
+        /* Letterboxing leaves parts of the output uncovered */
+        wlr_box output_box = {0, 0, handle->width, handle->height};
+        bool needs_clear = !(wf::region_t{output_box} ^ geometry).empty();
+        static const float black[4] = {0.0, 0.0, 0.0, 1.0};
+
+        for (auto& rect : damage)
+        {
+            wlr_box scissor = wlr_box_from_pixman_box(rect);
+            wlr_renderer_scissor(renderer, &scissor);
+            if (needs_clear)
+            {
+                wlr_renderer_clear(renderer, black);
+            }
+
+            wlr_render_texture_with_matrix(renderer, texture, matrix, 1.0);
+        }
+
+        wlr_renderer_scissor(renderer, NULL);
         wlr_renderer_end(renderer);
+        wlr_output_set_damage(handle, damage.to_pixman());
         wlr_output_commit(handle);
     }
 
@@ -751,22 +1048,41 @@ struct output_layout_output_t
             return;
         }
 
-        wlr_dmabuf_attributes attributes;
-        if (!wlr_output_export_dmabuf(wo->handle, &attributes))
+        bool needs_frame;
+        wf::region_t damage;
+        if (!wlr_output_damage_attach_render(mirror_damage, &needs_frame,
+            damage.to_pixman()))
+        {
+            return;
+        }
+
+        if (!needs_frame)
+        {
+            wlr_output_rollback(handle);
+
+            return;
+        }
+
+        auto texture = mirror_textures.get_texture(wo->handle);
+        if (!texture)
         {
-            LOGE("Failed reading mirrored output contents from ", wo->handle);
+            LOGE("Failed reading mirrored output contents from ",
+                wo->handle->name);
+            wlr_output_rollback(handle);
 
             return;
         }
 
-        /* We export the output to mirror from to a dmabuf, then create
-         * a texture from this and use it to render "our" output */
-        auto texture = wlr_texture_from_dmabuf(
-            get_core().renderer, &attributes);
-        render_output(texture);
+        wf::dimensions_t size;
+        wlr_texture_get_size(texture, &size.width, &size.height);
+        if (size != mirrored_size)
+        {
+            /* The damage was computed for the old size */
+            mirrored_size = size;
+            damage |= wlr_box{0, 0, handle->width, handle->height};
+        }
 
-        wlr_texture_destroy(texture);
-        wlr_dmabuf_attributes_finish(&attributes);
+        render_output(texture, size, damage);
     }
 
     void set_enabled(bool enabled)
@@ -819,17 +1135,58 @@ struct output_layout_output_t
         wlr_output_lock_software_cursors(wo->handle, true);
         locked_cursors_on = wo->handle;
 
-        wlr_output_schedule_frame(handle);
-        on_mirrored_frame.set_callback([=] (void*)
+        mirror_damage = wlr_output_damage_create(handle);
+        on_mirror_damage_destroy.set_callback([=] (void*)
+        {
+            mirror_damage = NULL;
+            on_frame.disconnect();
+        });
+        on_mirror_damage_destroy.connect(&mirror_damage->events.destroy);
+
+        /* Start with a full repaint */
+        mirrored_size = {0, 0};
+        wlr_output_damage_add_whole(mirror_damage);
+
+        mirrored_damage.clear();
+        on_mirrored_precommit.set_callback([=] (void*)
+        {
+            /* The mirrored output is about to show a new buffer, repaint
+             * only the parts of us which change */
+            auto& pending = wo->handle->pending;
+            if (!(pending.committed & WLR_OUTPUT_STATE_BUFFER))
+            {
+                return;
+            }
+
+            wf::dimensions_t size = {wo->handle->width, wo->handle->height};
+            if ((size != mirrored_size) ||
+                !(pending.committed & WLR_OUTPUT_STATE_DAMAGE))
+            {
+                mirrored_damage |= wlr_box{0, 0, handle->width, handle->height};
+
+                return;
+            }
+
+            mirrored_damage |= get_mirror_damage(&pending.damage, size);
+        });
+        on_mirrored_precommit.connect(&wo->handle->events.precommit);
+
+        /* The DRM backend exports the buffer which is on screen, so the
+         * damage is applied only once the new buffer is presented. Otherwise
+         * a frame of ours in between would copy the old contents and consume
+         * the damage, leaving stale parts until they are damaged again. */
+        on_mirrored_present.set_callback([=] (void*)
         {
-            /* The mirrored output was repainted, schedule repaint
-             * for us as well */
-            wlr_output_schedule_frame(handle);
+            if (mirror_damage && !mirrored_damage.empty())
+            {
+                wlr_output_damage_add(mirror_damage, mirrored_damage.to_pixman());
+                mirrored_damage.clear();
+            }
         });
-        on_mirrored_frame.connect(&wo->handle->events.precommit);
+        on_mirrored_present.connect(&wo->handle->events.present);
 
         on_frame.set_callback([=] (void*) { handle_frame(); });
-        on_frame.connect(&handle->events.frame);
+        on_frame.connect(&mirror_damage->events.frame);
     }
 
     void teardown_mirror()
@@ -840,8 +1197,18 @@ struct output_layout_output_t
             locked_cursors_on = NULL;
         }
 
-        on_mirrored_frame.disconnect();
+        on_mirrored_precommit.disconnect();
+        on_mirrored_present.disconnect();
+        mirrored_damage.clear();
         on_frame.disconnect();
+        on_mirror_damage_destroy.disconnect();
+        if (mirror_damage)
+        {
+            wlr_output_damage_destroy(mirror_damage);
+            mirror_damage = NULL;
+        }
+
+        mirror_textures.clear();
     }
 
     wf::dimensions_t get_effective_size()
@@ -0,0 +1,206 @@
+#ifndef WF_SEAT_BINDING_INDEX_HPP
+#define WF_SEAT_BINDING_INDEX_HPP
+
+#include <cassert>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <wayfire/config/option.hpp>
+#include <wayfire/config/types.hpp>
+#include <wayfire/bindings.hpp>
+
+/*
+ * The bindings and their lookup. They depend only on wf-config, so that
+ * benchmarks/bindings.cpp can dispatch to them without a compositor.
+ */
+namespace wf
+{
+class output_t;
+}
+
+enum wf_binding_type
+{
+    WF_BINDING_KEY,
+    WF_BINDING_BUTTON,
+    WF_BINDING_AXIS,
+    WF_BINDING_TOUCH,
+    WF_BINDING_GESTURE,
+    WF_BINDING_ACTIVATOR,
+};
+
+struct wf::binding_t
+{
+    std::shared_ptr<wf::config::option_base_t> value;
+    wf_binding_type type;
+    wf::output_t *output;
+
+    /* Called when the value of the option changes */
+    wf::config::option_base_t::updated_callback_t value_updated;
+    ~binding_t()
+    {
+        value->rem_updated_handler(&value_updated);
+    }
+
+    union
+    {
+        void *raw;
+        wf::key_callback *key;
+        wf::axis_callback *axis;
+        wf::touch_callback *touch;
+        wf::button_callback *button;
+        wf::gesture_callback *gesture;
+        wf::activator_callback *activator;
+    } call;
+};
+
+using wf_binding_ptr = std::unique_ptr<wf::binding_t>;
+
+namespace wf
+{
+/** The kinds of input which can trigger bindings */
+enum binding_input_t
+{
+    BINDING_INPUT_KEY,
+    BINDING_INPUT_BUTTON,
+    BINDING_INPUT_AXIS,
+};
+
+/** A binding of the active output matched by an input event. */
+struct matched_binding_t
+{
+    wf_binding_type type;
+    decltype(wf::binding_t::call) call;
+};
+
+/**
+ * The bindings which match a given input, on all outputs, indexed by the
+ * kind of input, the modifiers and the key or button.
+ *
+ * The activator bindings of wf-config can only be queried with has_match(),
+ * so each entry is filled on the first lookup, and the whole table must be
+ * cleared when a binding is added, removed or changed.
+ */
+class binding_index_t
+{
+  public:
+    using bindings_t =
+        std::map<wf_binding_type, std::vector<std::unique_ptr<wf::binding_t>>>;
+
+    /**
+     * The bindings matched by the ongoing dispatches. It is used as a stack,
+     * so that dispatching does not allocate, and callbacks can remove
+     * bindings or trigger other bindings.
+     */
+    std::vector<matched_binding_t> matched;
+
+    /** Forget all lookups. The matched bindings are kept. */
+    void clear()
+    {
+        index.clear();
+    }
+
+    /** @return The bindings of all outputs which match the given input. */
+    const std::vector<wf::binding_t*>& find(bindings_t& bindings,
+        binding_input_t input, uint32_t mods, uint32_t code)
+    {
+        /* Modifiers are a mask of WLR_MODIFIER_*, so they fit in 24 bits */
+        uint64_t id = ((uint64_t)input << 56) |
+            ((uint64_t)(mods & 0xffffff) << 32) | code;
+
+        auto it = index.find(id);
+        if (it != index.end())
+        {
+            return it->second;
+        }
+
+        auto& found = index[id];
+        auto add_matching = [&] (wf_binding_type type, auto matches)
+        {
+            for (auto& binding : bindings[type])
+            {
+                if (matches(binding.get()))
+                {
+                    found.push_back(binding.get());
+                }
+            }
+        };
+
+        switch (input)
+        {
+          case BINDING_INPUT_KEY:
+            add_matching(WF_BINDING_KEY, [&] (wf::binding_t *binding)
+            {
+                return get_value<wf::keybinding_t>(binding) ==
+                       wf::keybinding_t{mods, code};
+            });
+            add_matching(WF_BINDING_ACTIVATOR, [&] (wf::binding_t *binding)
+            {
+                return get_value<wf::activatorbinding_t>(binding)
+                    .has_match(wf::keybinding_t{mods, code});
+            });
+            break;
+
+          case BINDING_INPUT_BUTTON:
+            add_matching(WF_BINDING_BUTTON, [&] (wf::binding_t *binding)
+            {
+                return wf::buttonbinding_t{mods, code} ==
+                       get_value<wf::buttonbinding_t>(binding);
+            });
+            add_matching(WF_BINDING_ACTIVATOR, [&] (wf::binding_t *binding)
+            {
+                return get_value<wf::activatorbinding_t>(binding)
+                    .has_match(wf::buttonbinding_t{mods, code});
+            });
+            break;
+
+          case BINDING_INPUT_AXIS:
+            add_matching(WF_BINDING_AXIS, [&] (wf::binding_t *binding)
+            {
+                return get_value<wf::keybinding_t>(binding) ==
+                       wf::keybinding_t{mods, 0};
+            });
+            break;
+        }
+
+        return found;
+    }
+
+    /**
+     * Push the bindings of the given output which match the given input to
+     * matched.
+     *
+     * @return The index of the first pushed binding.
+     */
+    size_t push_matched(bindings_t& bindings, binding_input_t input,
+        uint32_t mods, uint32_t code, wf::output_t *output)
+    {
+        size_t first = matched.size();
+        for (auto binding : find(bindings, input, mods, code))
+        {
+            if (binding->output == output)
+            {
+                matched.push_back({binding->type, binding->call});
+            }
+        }
+
+        return first;
+    }
+
+  private:
+    std::unordered_map<uint64_t, std::vector<wf::binding_t*>> index;
+
+    /** Get the value of the option of a binding with the given type. */
+    template<class Type>
+    static Type get_value(wf::binding_t *binding)
+    {
+        auto option = std::dynamic_pointer_cast<wf::config::option_t<Type>>(
+            binding->value);
+        assert(option);
+
+        return option->get_value();
+    }
+};
+}
+
+#endif /* end of include guard: WF_SEAT_BINDING_INDEX_HPP */
@@ -30,9 +30,13 @@ wf_cursor::wf_cursor()
     setup_listeners();
     init_xcursor();
 
-    config_reloaded = [=] (wf::signal_data_t*)
+    config_reloaded = [=] (wf::signal_data_t *data)
     {
-        init_xcursor();
+        auto ev = static_cast<wf::reload_config_signal*>(data);
+        if (ev->section_changed("input"))
+        {
+            init_xcursor();
+        }
     };
 
     wf::get_core().connect_signal("reload-config", &config_reloaded);
@@ -55,7 +59,9 @@ void wf_cursor::setup_listeners()
     on_ ## evname.set_callback([&] (void *data) { \
         set_touchscreen_mode(false); \
         auto ev = static_cast<wlr_event_pointer_ ## evname*>(data); \
-        emit_device_event_signal("pointer_" #evname, ev); \
+        static const device_event_signal_t<wlr_event_pointer_ ## evname> \
+            event_signal{"pointer_" #evname}; \
+        emit_device_event_signal(event_signal, ev); \
         core.input->lpointer->handle_pointer_ ## evname(ev); \
         wlr_idle_notify_activity(core.protocols.idle, core.get_current_seat()); \
     }); \
@@ -81,7 +87,9 @@ void wf_cursor::setup_listeners()
     on_tablet_ ## evname.set_callback([&] (void *data) { \
         set_touchscreen_mode(false); \
         auto ev = static_cast<wlr_event_tablet_tool_ ## evname*>(data); \
-        emit_device_event_signal("tablet_" #evname, ev); \
+        static const device_event_signal_t<wlr_event_tablet_tool_ ## evname> \
+            event_signal{"tablet_" #evname}; \
+        emit_device_event_signal(event_signal, ev); \
         if (ev->device->tablet->data) { \
             auto tablet = \
                 static_cast<wf::tablet_t*>(ev->device->tablet->data); \
@@ -0,0 +1,173 @@
+#include "input-index.hpp"
+#include <cmath>
+#include <algorithm>
+
+bool wf::input_index_t::entry_t::operator ==(const entry_t& other) const
+{
+    return view == other.view && box == other.box &&
+           everywhere == other.everywhere;
+}
+
+wf::input_index_t::input_index_t(wf::output_t *output)
+{
+    this->output = output;
+
+    on_view_damaged.set_callback([=] (wf::signal_data_t*)
+    {
+        check_boxes = true;
+    });
+
+    on_views_changed.set_callback([=] (wf::signal_data_t*)
+    {
+        snapshot = nullptr;
+    });
+
+    for (auto signal : {"view-mapped", "view-unmapped", "view-disappeared",
+        "view-focused"})
+    {
+        output->connect_signal(signal, &on_views_changed);
+    }
+}
+
+nonstd::observer_ptr<wf::input_index_t> wf::input_index_t::get(
+    wf::output_t *output)
+{
+    auto index = output->get_data<input_index_t>();
+    if (!index)
+    {
+        output->store_data(std::make_unique<input_index_t>(output));
+        index = output->get_data<input_index_t>();
+    }
+
+    return index;
+}
+
+std::vector<wf::input_index_t::entry_t> wf::input_index_t::generate_entries()
+{
+    std::vector<entry_t> result;
+    result.reserve(entries.size());
+    for (auto& v : *snapshot)
+    {
+        for (auto& view : v->traverse_views())
+        {
+            entry_t entry;
+            entry.view = view;
+            entry.everywhere = !view->is_mapped() || view->has_transformer();
+            entry.box = entry.everywhere ?
+                wf::geometry_t{0, 0, 0, 0} : view->get_bounding_box();
+            result.push_back(entry);
+        }
+    }
+
+    return result;
+}
+
+void wf::input_index_t::rebuild(std::vector<entry_t> new_entries)
+{
+    entries     = std::move(new_entries);
+    output_size = output->get_screen_size();
+
+    columns = std::max(1, (output_size.width + CELL_SIZE - 1) / CELL_SIZE);
+    rows    = std::max(1, (output_size.height + CELL_SIZE - 1) / CELL_SIZE);
+    cells.resize(columns * rows);
+    for (auto& cell : cells)
+    {
+        cell.clear();
+    }
+
+    on_view_damaged.disconnect();
+
+    static const wf::signal_id_t region_damaged =
+        wf::get_signal_id("region-damaged");
+
+    wf::geometry_t output_box = {0, 0, output_size.width, output_size.height};
+    for (uint32_t i = 0; i < entries.size(); i++)
+    {
+        auto& entry = entries[i];
+        entry.view->connect_signal(region_damaged, &on_view_damaged);
+
+        if (entry.everywhere)
+        {
+            for (auto& cell : cells)
+            {
+                cell.push_back(i);
+            }
+
+            continue;
+        }
+
+        auto box = wf::geometry_intersection(entry.box, output_box);
+        if ((box.width <= 0) || (box.height <= 0))
+        {
+            continue;
+        }
+
+        int x1 = box.x / CELL_SIZE, x2 = (box.x + box.width - 1) / CELL_SIZE;
+        int y1 = box.y / CELL_SIZE, y2 = (box.y + box.height - 1) / CELL_SIZE;
+        for (int y = y1; y <= y2; y++)
+        {
+            for (int x = x1; x <= x2; x++)
+            {
+                cells[y * columns + x].push_back(i);
+            }
+        }
+    }
+}
+
+void wf::input_index_t::update()
+{
+    auto views = output->workspace->get_views_in_layer_snapshot(
+        wf::VISIBLE_LAYERS);
+    if ((views != snapshot) || (output->get_screen_size() != output_size))
+    {
+        snapshot    = views;
+        check_boxes = false;
+        rebuild(generate_entries());
+
+        return;
+    }
+
+    if (check_boxes)
+    {
+        check_boxes = false;
+        auto new_entries = generate_entries();
+        if (new_entries != entries)
+        {
+            rebuild(std::move(new_entries));
+        }
+    }
+}
+
+const std::vector<wayfire_view>& wf::input_index_t::get_candidates(
+    wf::pointf_t point)
+{
+    update();
+
+    candidates.clear();
+    auto push_candidate = [&] (const entry_t& entry)
+    {
+        if (entry.everywhere || (entry.box & point))
+        {
+            candidates.push_back(entry.view);
+        }
+    };
+
+    int x = std::floor(point.x / CELL_SIZE);
+    int y = std::floor(point.y / CELL_SIZE);
+    if ((x < 0) || (x >= columns) || (y < 0) || (y >= rows))
+    {
+        /* Points outside of the output are not in the grid */
+        for (auto& entry : entries)
+        {
+            push_candidate(entry);
+        }
+    } else
+    {
+        for (auto& i : cells[y * columns + x])
+        {
+            push_candidate(entries[i]);
+        }
+    }
+
+    return candidates;
+}
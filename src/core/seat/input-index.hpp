@@ -0,0 +1,86 @@
+#ifndef WF_SEAT_INPUT_INDEX_HPP
+#define WF_SEAT_INPUT_INDEX_HPP
+
+#include <vector>
+#include <wayfire/object.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/view.hpp>
+#include <wayfire/workspace-manager.hpp>
+
+namespace wf
+{
+/**
+ * A spatial index of the views on an output. input_surface_at() uses it to
+ * find the views which may contain a point, so that only those need the
+ * precise (and expensive) test with map_input_coordinates().
+ *
+ * The output is divided into a grid of cells. Each cell holds the views whose
+ * bounding box intersects it, in stacking order. Views with transformers and
+ * unmapped views are put in every cell, because plugins may change
+ * transformers without damaging the view.
+ *
+ * The index is rebuilt lazily, when the stacking order or the size of the
+ * output changes, or when a view is mapped, unmapped or focused. When one of
+ * the indexed views is damaged, the bounding boxes of all views are checked on
+ * the next query, and the grid is rebuilt only if one of them has changed.
+ */
+class input_index_t : public custom_data_t
+{
+  public:
+    input_index_t(wf::output_t *output);
+
+    /** Get the index of the given output, creating it if necessary. */
+    static nonstd::observer_ptr<input_index_t> get(wf::output_t *output);
+
+    /**
+     * Get the views whose bounding box may contain the given point, from the
+     * topmost to the bottommost one. Minimized views are included.
+     *
+     * @param point The point, in output-local coordinates.
+     * @return The candidate views, valid until the next query.
+     */
+    const std::vector<wayfire_view>& get_candidates(wf::pointf_t point);
+
+  private:
+    struct entry_t
+    {
+        wayfire_view view;
+        wf::geometry_t box;
+        /* Whether the view is a candidate everywhere */
+        bool everywhere;
+
+        bool operator ==(const entry_t& other) const;
+    };
+
+    /* Size of a grid cell, in output-local pixels */
+    static constexpr int CELL_SIZE = 256;
+
+    wf::output_t *output;
+
+    /* The views in stacking order, topmost first */
+    std::vector<entry_t> entries;
+    /* For each cell, the indices of the entries which intersect it */
+    std::vector<std::vector<uint32_t>> cells;
+    int columns = 0, rows = 0;
+
+    /* The stacking order snapshot the index was built from */
+    workspace_manager::views_snapshot_t snapshot;
+    wf::dimensions_t output_size = {0, 0};
+    /* Set when an indexed view was damaged */
+    bool check_boxes = false;
+
+    std::vector<wayfire_view> candidates;
+
+    wf::signal_connection_t on_view_damaged;
+    wf::signal_connection_t on_views_changed;
+
+    /** Generate the entries for the current stacking order. */
+    std::vector<entry_t> generate_entries();
+    /** Rebuild the grid from the given entries. */
+    void rebuild(std::vector<entry_t> new_entries);
+    /** Make sure the index matches the current state of the output. */
+    void update();
+};
+}
+
+#endif /* end of include guard: WF_SEAT_INPUT_INDEX_HPP */
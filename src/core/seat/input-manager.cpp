@@ -14,6 +14,7 @@ extern "C"
 #include "keyboard.hpp"
 #include "cursor.hpp"
 #include "input-manager.hpp"
+#include "input-index.hpp"
 #include "wayfire/output-layout.hpp"
 #include "wayfire/workspace-manager.hpp"
 #include <wayfire/util/log.hpp>
@@ -191,8 +192,14 @@ input_manager::input_manager()
 
     create_seat();
 
-    config_updated = [=] (wf::signal_data_t*)
+    config_updated = [=] (wf::signal_data_t *data)
     {
+        auto ev = static_cast<wf::reload_config_signal*>(data);
+        if (!ev->section_changed("input"))
+        {
+            return;
+        }
+
         for (auto& dev : input_devices)
         {
             dev->update_options();
@@ -323,17 +330,15 @@ wf::surface_interface_t*input_manager::input_surface_at(wf::pointf_t global,
     global.x -= og.x;
     global.y -= og.y;
 
-    for (auto& v : output->workspace->get_views_in_layer(wf::VISIBLE_LAYERS))
+    /* Only views whose bounding box contains the point can accept input */
+    for (auto& view : wf::input_index_t::get(output)->get_candidates(global))
     {
-        for (auto& view : v->enumerate_views())
+        if (!view->minimized && can_focus_surface(view.get()))
         {
-            if (!view->minimized && can_focus_surface(view.get()))
+            auto surface = view->map_input_coordinates(global, local);
+            if (surface)
             {
-                auto surface = view->map_input_coordinates(global, local);
-                if (surface)
-                {
-                    return surface;
-                }
+                return surface;
             }
         }
     }
@@ -379,14 +384,22 @@ wf::binding_t*input_manager::new_binding(wf_binding_type type,
     binding->output   = output;
     binding->call.raw = callback;
 
+    binding->value_updated = [=] ()
+    {
+        binding_index.clear();
+    };
+    value->add_updated_handler(&binding->value_updated);
+
     auto raw = binding.get();
     bindings[type].push_back(std::move(binding));
+    binding_index.clear();
 
     return raw;
 }
 
 void input_manager::rem_binding(binding_criteria criteria)
 {
+    binding_index.clear();
     for (auto& category : bindings)
     {
         auto& container = category.second;
@@ -422,85 +435,57 @@ void input_manager::free_output_bindings(wf::output_t *output)
     });
 }
 
-bool input_manager::check_button_bindings(uint32_t button)
+size_t input_manager::push_matched_bindings(wf::binding_input_t input,
+    uint32_t mods, uint32_t code)
 {
-    std::vector<std::function<bool()>> callbacks;
+    return binding_index.push_matched(bindings, input, mods, code,
+        wf::get_core().get_active_output());
+}
 
+bool input_manager::check_button_bindings(uint32_t button)
+{
     auto oc = wf::get_core().get_active_output()->get_cursor_position();
-    auto mod_state = get_modifiers();
 
-    for (auto& binding : bindings[WF_BINDING_BUTTON])
-    {
-        auto as_button = std::dynamic_pointer_cast<
-            wf::config::option_t<wf::buttonbinding_t>>(binding->value);
-        assert(as_button);
+    /* Callbacks might remove bindings or trigger other bindings, so the
+     * matched bindings are accessed by index, and copied before calling */
+    size_t first = push_matched_bindings(wf::BINDING_INPUT_BUTTON,
+        get_modifiers(), button);
+    size_t last = binding_index.matched.size();
 
-        if ((binding->output == wf::get_core().get_active_output()) &&
-            (wf::buttonbinding_t{mod_state, button} == as_button->get_value()))
-        {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->call.button;
-            callbacks.push_back([=] ()
-            {
-                return (*callback)(button, oc.x, oc.y);
-            });
-        }
-    }
-
-    for (auto& binding : bindings[WF_BINDING_ACTIVATOR])
+    bool binding_handled = false;
+    for (size_t i = first; i < last; i++)
     {
-        auto as_activator = std::dynamic_pointer_cast<
-            wf::config::option_t<wf::activatorbinding_t>>(binding->value);
-        assert(as_activator);
-
-        if ((binding->output == wf::get_core().get_active_output()) &&
-            as_activator->get_value().has_match(
-                wf::buttonbinding_t{mod_state, button}))
+        auto match = binding_index.matched[i];
+        if (match.type == WF_BINDING_BUTTON)
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->call.activator;
-            callbacks.push_back([=] ()
-            {
-                return (*callback)(wf::ACTIVATOR_SOURCE_BUTTONBINDING, button);
-            });
+            binding_handled |= (*match.call.button)(button, oc.x, oc.y);
+        } else
+        {
+            binding_handled |= (*match.call.activator)(
+                wf::ACTIVATOR_SOURCE_BUTTONBINDING, button);
         }
     }
 
-    bool binding_handled = false;
-    for (auto call : callbacks)
-    {
-        binding_handled |= call();
-    }
+    binding_index.matched.resize(first);
 
-    return !callbacks.empty() && binding_handled;
+    return (last > first) && binding_handled;
 }
 
 bool input_manager::check_axis_bindings(wlr_event_pointer_axis *ev)
 {
-    std::vector<wf::axis_callback*> callbacks;
-    auto mod_state = get_modifiers();
+    size_t first = push_matched_bindings(wf::BINDING_INPUT_AXIS,
+        get_modifiers(), 0);
+    size_t last = binding_index.matched.size();
 
-    for (auto& binding : bindings[WF_BINDING_AXIS])
+    for (size_t i = first; i < last; i++)
     {
-        auto as_key = std::dynamic_pointer_cast<
-            wf::config::option_t<wf::keybinding_t>>(binding->value);
-        assert(as_key);
-
-        if ((binding->output == wf::get_core().get_active_output()) &&
-            (as_key->get_value() == wf::keybinding_t{mod_state, 0}))
-        {
-            callbacks.push_back(binding->call.axis);
-        }
+        auto match = binding_index.matched[i];
+        (*match.call.axis)(ev);
     }
 
-    for (auto call : callbacks)
-    {
-        (*call)(ev);
-    }
+    binding_index.matched.resize(first);
 
-    return !callbacks.empty();
+    return last > first;
 }
 
 wf::SurfaceMapStateListener::SurfaceMapStateListener()
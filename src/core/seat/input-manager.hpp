@@ -2,12 +2,14 @@
 #define INPUT_MANAGER_HPP
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <chrono>
 
 #include "seat.hpp"
 #include "cursor.hpp"
 #include "pointer.hpp"
+#include "binding-index.hpp"
 #include "wayfire/plugin.hpp"
 #include "wayfire/view.hpp"
 #include "wayfire/core.hpp"
@@ -41,36 +43,6 @@ enum wf_locked_mods
     WF_KB_CAPS = 1 << 1,
 };
 
-enum wf_binding_type
-{
-    WF_BINDING_KEY,
-    WF_BINDING_BUTTON,
-    WF_BINDING_AXIS,
-    WF_BINDING_TOUCH,
-    WF_BINDING_GESTURE,
-    WF_BINDING_ACTIVATOR,
-};
-
-struct wf::binding_t
-{
-    std::shared_ptr<wf::config::option_base_t> value;
-    wf_binding_type type;
-    wf::output_t *output;
-
-    union
-    {
-        void *raw;
-        wf::key_callback *key;
-        wf::axis_callback *axis;
-        wf::touch_callback *touch;
-        wf::button_callback *button;
-        wf::gesture_callback *gesture;
-        wf::activator_callback *activator;
-    } call;
-};
-
-using wf_binding_ptr = std::unique_ptr<wf::binding_t>;
-
 /* TODO: most probably we want to split even more of input_manager's functionality
  * into
  * wf_keyboard, wf_cursor and wf_touch */
@@ -90,12 +62,30 @@ class input_manager
     using binding_criteria = std::function<bool (wf::binding_t*)>;
     void rem_binding(binding_criteria criteria);
 
+    /* The lookup of bindings, and the stack of matched bindings */
+    wf::binding_index_t binding_index;
+
+    /**
+     * Push the bindings of the active output which match the given input to
+     * binding_index.matched.
+     *
+     * @return The index of the first pushed binding.
+     */
+    size_t push_matched_bindings(wf::binding_input_t input, uint32_t mods,
+        uint32_t code);
+
     void create_seat();
 
     void validate_drag_request(wlr_seat_request_start_drag_event *ev);
     std::chrono::steady_clock::time_point mod_binding_start;
-    std::vector<std::function<bool()>> match_keys(uint32_t mods, uint32_t key,
-        uint32_t mod_binding_key = 0);
+    /**
+     * Call the key and activator bindings in binding_index.matched, starting
+     * from the given index, and remove them from it.
+     *
+     * @param actual_key The key which is passed to the callbacks.
+     * @return Whether any binding handled the key.
+     */
+    bool call_key_bindings(size_t first, uint32_t actual_key);
 
     wf::signal_callback_t output_added;
 
@@ -176,11 +166,15 @@ class input_manager
 };
 
 template<class EventType>
-void emit_device_event_signal(std::string event_name, EventType *event)
+using device_event_signal_t = wf::signal_t<wf::input_event_signal<EventType>>;
+
+template<class EventType>
+void emit_device_event_signal(const device_event_signal_t<EventType>& signal,
+    EventType *event)
 {
     wf::input_event_signal<EventType> data;
     data.event = event;
-    wf::get_core().emit_signal(event_name, &data);
+    wf::get_core().emit_signal(signal, &data);
 }
 
 #endif /* end of include guard: INPUT_MANAGER_HPP */
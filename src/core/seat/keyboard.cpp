@@ -23,7 +23,9 @@ void wf_keyboard::setup_listeners()
     on_key.set_callback([&] (void *data)
     {
         auto ev = static_cast<wlr_event_keyboard_key*>(data);
-        emit_device_event_signal("keyboard_key", ev);
+        static const device_event_signal_t<wlr_event_keyboard_key>
+            signal_key{"keyboard_key"};
+        emit_device_event_signal(signal_key, ev);
 
         auto seat = wf::get_core().get_current_seat();
         wlr_seat_set_keyboard(seat, this->device);
@@ -266,55 +268,30 @@ static uint32_t mod_from_key(wlr_seat *seat, uint32_t key)
     return 0;
 }
 
-std::vector<std::function<bool()>> input_manager::match_keys(uint32_t mod_state,
-    uint32_t key, uint32_t mod_binding_key)
+bool input_manager::call_key_bindings(size_t first, uint32_t actual_key)
 {
-    std::vector<std::function<bool()>> callbacks;
+    /* Callbacks might remove bindings or trigger other bindings, so the
+     * matched bindings are accessed by index, and copied before calling */
+    size_t last = binding_index.matched.size();
 
-    uint32_t actual_key = key == 0 ? mod_binding_key : key;
-
-    for (auto& binding : bindings[WF_BINDING_KEY])
+    bool handled = false;
+    for (size_t i = first; i < last; i++)
     {
-        auto as_key = std::dynamic_pointer_cast<
-            wf::config::option_t<wf::keybinding_t>>(binding->value);
-        assert(as_key);
-
-        if ((as_key->get_value() == wf::keybinding_t{mod_state, key}) &&
-            (binding->output == wf::get_core().get_active_output()))
+        auto match = binding_index.matched[i];
+        if (match.type == WF_BINDING_KEY)
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->call.key;
-            callbacks.push_back([actual_key, callback] ()
-            {
-                return (*callback)(actual_key);
-            });
-        }
-    }
-
-    for (auto& binding : bindings[WF_BINDING_ACTIVATOR])
-    {
-        auto as_activator = std::dynamic_pointer_cast<
-            wf::config::option_t<wf::activatorbinding_t>>(binding->value);
-        assert(as_activator);
-
-        if (as_activator->get_value().has_match(wf::keybinding_t{mod_state, key}) &&
-            (binding->output == wf::get_core().get_active_output()))
+            handled |= (*match.call.key)(actual_key);
+        } else
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda
-             *
-             * Also, do not send keys for modifier bindings */
-            auto callback = binding->call.activator;
-            callbacks.push_back([=] ()
-            {
-                return (*callback)(wf::ACTIVATOR_SOURCE_KEYBINDING,
-                    mod_from_key(seat, actual_key) ? 0 : actual_key);
-            });
+            /* Do not send keys for modifier bindings */
+            handled |= (*match.call.activator)(wf::ACTIVATOR_SOURCE_KEYBINDING,
+                mod_from_key(seat, actual_key) ? 0 : actual_key);
         }
     }
 
-    return callbacks;
+    binding_index.matched.resize(first);
+
+    return handled;
 }
 
 void update_keyboard_locked_mods(wlr_keyboard *kbd, xkb_mod_mask_t& locked_mods)
@@ -362,7 +339,8 @@ bool input_manager::handle_keyboard_key(uint32_t key, uint32_t state)
         handle_keyboard_mod(mod, state);
     }
 
-    std::vector<std::function<bool()>> callbacks;
+    size_t first_binding = binding_index.matched.size();
+    uint32_t actual_key  = key;
     auto kbd = wlr_seat_get_keyboard(seat);
     update_keyboard_locked_mods(kbd, locked_mods);
 
@@ -399,7 +377,7 @@ bool input_manager::handle_keyboard_key(uint32_t key, uint32_t state)
             mod_binding_key = 0;
         }
 
-        callbacks = match_keys(get_modifiers(), key);
+        push_matched_bindings(wf::BINDING_INPUT_KEY, get_modifiers(), key);
     } else
     {
         if (mod_binding_key != 0)
@@ -411,18 +389,16 @@ bool input_manager::handle_keyboard_key(uint32_t key, uint32_t state)
                     mod_binding_start) <=
                  milliseconds(timeout)))
             {
-                callbacks = match_keys(get_modifiers() | mod, 0, mod_binding_key);
+                push_matched_bindings(wf::BINDING_INPUT_KEY,
+                    get_modifiers() | mod, 0);
+                actual_key = mod_binding_key;
             }
         }
 
         mod_binding_key = 0;
     }
 
-    bool keybinding_handled = false;
-    for (auto call : callbacks)
-    {
-        keybinding_handled |= call();
-    }
+    bool keybinding_handled = call_key_bindings(first_binding, actual_key);
 
     auto iv = interactive_view_from_view(keyboard_focus.get());
     if (iv)
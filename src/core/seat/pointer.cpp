@@ -185,7 +185,7 @@ wf::pointf_t wf::LogicalPointer::get_absolute_position_from_relative(
     auto output_geometry = view->get_output_geometry();
     wf::point_t origin   = {output_geometry.x, output_geometry.y};
 
-    for (auto& surf : view->enumerate_surfaces(origin))
+    for (auto& surf : view->traverse_surfaces(origin))
     {
         if (surf.surface == this->cursor_focus)
         {
@@ -21,7 +21,9 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
     on_down.set_callback([=] (void *data)
     {
         auto ev = static_cast<wlr_event_touch_down*>(data);
-        emit_device_event_signal("touch_down", &ev);
+        static const device_event_signal_t<wlr_event_touch_down>
+            signal_down{"touch_down"};
+        emit_device_event_signal(signal_down, ev);
 
         double lx, ly;
         wlr_cursor_absolute_to_layout_coords(cursor, ev->device,
@@ -37,7 +39,9 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
     on_up.set_callback([=] (void *data)
     {
         auto ev = static_cast<wlr_event_touch_up*>(data);
-        emit_device_event_signal("touch_up", ev);
+        static const device_event_signal_t<wlr_event_touch_up>
+            signal_up{"touch_up"};
+        emit_device_event_signal(signal_up, ev);
         handle_touch_up(ev->touch_id, ev->time_msec);
         wlr_idle_notify_activity(wf::get_core().protocols.idle,
             wf::get_core().get_current_seat());
@@ -46,7 +50,9 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
     on_motion.set_callback([=] (void *data)
     {
         auto ev = static_cast<wlr_event_touch_motion*>(data);
-        emit_device_event_signal("touch_motion", &ev);
+        static const device_event_signal_t<wlr_event_touch_motion>
+            signal_motion{"touch_motion"};
+        emit_device_event_signal(signal_motion, ev);
 
         double lx, ly;
         wlr_cursor_absolute_to_layout_coords(
@@ -4,13 +4,13 @@
 #include <getopt.h>
 #include <signal.h>
 #include <map>
+#include <chrono>
 
 #include <sys/inotify.h>
 #include <unistd.h>
 
 #include "debug-func.hpp"
 #include "main.hpp"
-#include "wayfire/nonstd/safe-list.hpp"
 #include <wayfire/config/file.hpp>
 
 extern "C"
@@ -28,6 +28,8 @@ extern "C"
 #include "core/core-impl.hpp"
 #include "view/view-impl.hpp"
 #include "wayfire/output.hpp"
+#include "wayfire/signal-definitions.hpp"
+#include "output/frame-profiler.hpp"
 
 wf_runtime_config runtime_config;
 
@@ -36,6 +38,11 @@ static char buf[INOT_BUF_SIZE];
 
 static std::string config_dir, config_file;
 
+/* Editors often write the config file in several chunks, so the config is
+ * reloaded only after the file has not changed for this long. */
+static const int CONFIG_RELOAD_DELAY_MS = 100;
+static wl_event_source *config_reload_timer;
+
 static void reload_config(int fd)
 {
     wf::config::load_configuration_options_from_file(
@@ -44,15 +51,84 @@ static void reload_config(int fd)
     inotify_add_watch(fd, config_file.c_str(), IN_MODIFY);
 }
 
+/** Get the values of all options, by their section/option name. */
+static std::map<std::string, std::string> get_option_values(
+    wf::config::config_manager_t& config)
+{
+    std::map<std::string, std::string> values;
+    for (auto& section : config.get_all_sections())
+    {
+        for (auto& option : section->get_registered_options())
+        {
+            values[section->get_name() + "/" + option->get_name()] =
+                option->get_value_str();
+        }
+    }
+
+    return values;
+}
+
+static int handle_config_reload(void *data)
+{
+    using namespace std::chrono;
+    int fd = *static_cast<int*>(data);
+
+    auto start = steady_clock::now();
+    auto old_values = get_option_values(wf::get_core().config);
+    reload_config(fd);
+
+    wf::reload_config_signal reload_data;
+    auto new_values = get_option_values(wf::get_core().config);
+    for (auto& value : new_values)
+    {
+        auto it = old_values.find(value.first);
+        if ((it == old_values.end()) || (it->second != value.second))
+        {
+            reload_data.changed_options.push_back(value.first);
+        }
+    }
+
+    /* Options removed from the file, e.g. a deleted [command] binding */
+    for (auto& value : old_values)
+    {
+        if (!new_values.count(value.first))
+        {
+            reload_data.changed_options.push_back(value.first);
+        }
+    }
+
+    auto loaded = steady_clock::now();
+    if (!reload_data.changed_options.empty())
+    {
+        wf::get_core().emit_signal("reload-config", &reload_data);
+    }
+
+    auto applied = steady_clock::now();
+    auto to_ms   = [] (steady_clock::duration d)
+    {
+        return duration_cast<microseconds>(d).count() / 1000.0;
+    };
+    LOGI("Reloaded configuration file: ", reload_data.changed_options.size(),
+        " options changed, loading took ", to_ms(loaded - start),
+        "ms, applying took ", to_ms(applied - loaded), "ms");
+
+    return 0;
+}
+
 static int handle_config_updated(int fd, uint32_t mask, void *data)
 {
-    LOGD("Reloading configuration file");
+    LOGD("Configuration file changed, scheduling reload");
 
     /* read, but don't use */
     read(fd, buf, INOT_BUF_SIZE);
-    reload_config(fd);
+    wl_event_source_timer_update(config_reload_timer, CONFIG_RELOAD_DELAY_MS);
 
-    wf::get_core().emit_signal("reload-config", nullptr);
+    return 0;
+}
+
+static int handle_dump_frame_profile(int signal, void *data)
+{
+    wf::frame_profiler_t::dump_all();
 
     return 0;
 }
@@ -74,6 +150,13 @@ static void print_help()
         " -D,  --damage-debug      enable additional debug for damaged regions" <<
         std::endl;
     std::cout << " -R,  --damage-rerender   rerender damaged regions" << std::endl;
+    std::cout <<
+        " -p,  --profile-frames    measure frame times, send SIGUSR1 to dump them" <<
+        std::endl;
+    std::cout << " -G,  --frame-graph       show a graph of frame times" <<
+        std::endl;
+    std::cout << " -T,  --frame-trace FILE  write a Chrome trace of frame times" <<
+        std::endl;
     std::cout << " -v,  --version           print version and exit" << std::endl;
     exit(0);
 }
@@ -147,19 +230,6 @@ wlr_renderer *add_egl_depth_renderer(wlr_egl *egl, EGLenum platform,
     return renderer;
 }
 
-namespace wf
-{
-namespace _safe_list_detail
-{
-wl_event_loop *event_loop;
-void idle_cleanup_func(void *data)
-{
-    auto priv = reinterpret_cast<std::function<void()>*>(data);
-    (*priv)();
-}
-}
-}
-
 static bool drop_permissions(void)
 {
     if ((getuid() != geteuid()) || (getgid() != getegid()))
@@ -280,13 +350,16 @@ int main(int argc, char *argv[])
         {"debug", no_argument, NULL, 'd'},
         {"damage-debug", no_argument, NULL, 'D'},
         {"damage-rerender", no_argument, NULL, 'R'},
+        {"profile-frames", no_argument, NULL, 'p'},
+        {"frame-graph", no_argument, NULL, 'G'},
+        {"frame-trace", required_argument, NULL, 'T'},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         {0, 0, NULL, 0}
     };
 
     int c, i;
-    while ((c = getopt_long(argc, argv, "c:dDhRv", opts, &i)) != -1)
+    while ((c = getopt_long(argc, argv, "c:dDhRvpGT:", opts, &i)) != -1)
     {
         switch (c)
         {
@@ -302,6 +375,20 @@ int main(int argc, char *argv[])
             runtime_config.no_damage_track = true;
             break;
 
+          case 'p':
+            runtime_config.profile_frames = true;
+            break;
+
+          case 'G':
+            runtime_config.profile_frames = true;
+            runtime_config.frame_graph    = true;
+            break;
+
+          case 'T':
+            runtime_config.profile_frames   = true;
+            runtime_config.frame_trace_file = optarg;
+            break;
+
           case 'h':
             print_help();
             break;
@@ -334,10 +421,7 @@ int main(int argc, char *argv[])
 #endif
 
     LOGI("Starting wayfire version ", WAYFIRE_VERSION);
-    /* First create display and initialize safe-list's event loop, so that
-     * wf objects (which depend on safe-list) can work */
     auto display = wl_display_create();
-    wf::_safe_list_detail::event_loop = wl_display_get_event_loop(display);
 
     auto& core = wf::get_core_impl();
 
@@ -374,11 +458,20 @@ int main(int argc, char *argv[])
     core.config = wf::config::build_configuration(
         xmldirs, SYSCONFDIR "/wayfire/defaults.ini", config_file);
 
-    int inotify_fd = inotify_init1(IN_CLOEXEC);
+    static int inotify_fd = inotify_init1(IN_CLOEXEC);
     reload_config(inotify_fd);
 
+    config_reload_timer = wl_event_loop_add_timer(core.ev_loop,
+        handle_config_reload, &inotify_fd);
     wl_event_loop_add_fd(core.ev_loop, inotify_fd, WL_EVENT_READABLE,
         handle_config_updated, NULL);
+
+    if (runtime_config.profile_frames)
+    {
+        wl_event_loop_add_signal(core.ev_loop, SIGUSR1,
+            handle_dump_frame_profile, NULL);
+    }
+
     core.init();
 
     auto socket = choose_socket(core.display);
@@ -1,10 +1,17 @@
 #ifndef MAIN_HPP
 #define MAIN_HPP
 
+#include <string>
+
 extern struct wf_runtime_config
 {
     bool no_damage_track = false;
     bool damage_debug    = false;
+
+    /* Frame profiling, see output/frame-profiler.hpp */
+    bool profile_frames = false;
+    bool frame_graph    = false;
+    std::string frame_trace_file;
 } runtime_config;
 
 #endif /* end of include guard: MAIN_HPP */
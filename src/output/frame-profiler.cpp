@@ -0,0 +1,568 @@
+#include "frame-profiler.hpp"
+#include "../main.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <time.h>
+#include <wayfire/util/log.hpp>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+
+namespace wf
+{
+namespace
+{
+/** Maximal number of finished frames kept for statistics and the graph */
+constexpr size_t MAX_HISTORY = 256;
+/** Maximal number of frames waiting for GPU results */
+constexpr size_t MAX_PENDING = 8;
+
+/** Entry points of GL_EXT_disjoint_timer_query */
+struct gpu_timer_ext_t
+{
+    bool checked   = false;
+    bool available = false;
+
+    PFNGLGENQUERIESEXTPROC gen_queries;
+    PFNGLDELETEQUERIESEXTPROC delete_queries;
+    PFNGLQUERYCOUNTEREXTPROC query_counter;
+    PFNGLGETQUERYIVEXTPROC get_queryiv;
+    PFNGLGETQUERYOBJECTUIVEXTPROC get_query_objectuiv;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_objectui64v;
+
+    /** Load the extension. Requires a current GL context. */
+    bool init()
+    {
+        if (checked)
+        {
+            return available;
+        }
+
+        checked = true;
+        auto extensions = (const char*)glGetString(GL_EXTENSIONS);
+        if (!extensions ||
+            (std::string(extensions).find("GL_EXT_disjoint_timer_query") ==
+             std::string::npos))
+        {
+            LOGI("GL_EXT_disjoint_timer_query not available, "
+                 "GPU frame times will not be measured");
+
+            return false;
+        }
+
+        gen_queries = (PFNGLGENQUERIESEXTPROC)
+            eglGetProcAddress("glGenQueriesEXT");
+        delete_queries = (PFNGLDELETEQUERIESEXTPROC)
+            eglGetProcAddress("glDeleteQueriesEXT");
+        query_counter = (PFNGLQUERYCOUNTEREXTPROC)
+            eglGetProcAddress("glQueryCounterEXT");
+        get_queryiv = (PFNGLGETQUERYIVEXTPROC)
+            eglGetProcAddress("glGetQueryivEXT");
+        get_query_objectuiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)
+            eglGetProcAddress("glGetQueryObjectuivEXT");
+        get_query_objectui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)
+            eglGetProcAddress("glGetQueryObjectui64vEXT");
+
+        if (!gen_queries || !delete_queries || !query_counter ||
+            !get_queryiv || !get_query_objectuiv || !get_query_objectui64v)
+        {
+            return false;
+        }
+
+        /* Implementations may support only GL_TIME_ELAPSED_EXT */
+        GLint bits = 0;
+        get_queryiv(GL_TIMESTAMP_EXT, GL_QUERY_COUNTER_BITS_EXT, &bits);
+        available = (bits > 0);
+
+        return available;
+    }
+} gpu_timer;
+
+std::vector<frame_profiler_t*> active_profilers;
+int next_trace_tid = 1;
+
+std::ofstream trace_file;
+bool trace_file_opened = false;
+
+/** Get the trace file, opening it if necessary. */
+std::ofstream *get_trace_file()
+{
+    if (runtime_config.frame_trace_file.empty())
+    {
+        return nullptr;
+    }
+
+    if (!trace_file_opened)
+    {
+        trace_file_opened = true;
+        trace_file.open(runtime_config.frame_trace_file, std::ios::trunc);
+        if (!trace_file)
+        {
+            LOGE("Failed to open frame trace file ",
+                runtime_config.frame_trace_file);
+        } else
+        {
+            /* The JSON array format of Chrome traces does not require the
+             * closing bracket, so events can be streamed as they come. */
+            trace_file << "[\n";
+        }
+    }
+
+    return trace_file ? &trace_file : nullptr;
+}
+
+std::string escape_json(const std::string& str)
+{
+    std::string result;
+    for (char c : str)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            result += '\\';
+        }
+
+        result += c;
+    }
+
+    return result;
+}
+
+void write_thread_name(std::ostream& out, int tid, const std::string& name)
+{
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid <<
+        ",\"args\":{\"name\":\"" << escape_json(name) << "\"}},\n";
+}
+
+void write_event(std::ostream& out, int tid, const std::string& name,
+    int64_t start_ns, int64_t duration_ns)
+{
+    out << "{\"name\":\"" << escape_json(name) << "\",\"ph\":\"X\",\"pid\":1," <<
+        "\"tid\":" << tid << ",\"ts\":" << start_ns / 1000.0 <<
+        ",\"dur\":" << duration_ns / 1000.0 << "},\n";
+}
+}
+
+bool frame_profiler_t::is_enabled()
+{
+    return runtime_config.profile_frames;
+}
+
+int64_t frame_profiler_t::now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+}
+
+frame_profiler_t::frame_profiler_t(std::string output_name)
+{
+    this->output_name = output_name;
+    /* Each profiler uses two trace threads: one for CPU and one for GPU */
+    this->trace_tid = next_trace_tid;
+    next_trace_tid += 2;
+
+    if (auto out = get_trace_file())
+    {
+        write_thread_name(*out, trace_tid, output_name + " (CPU)");
+        write_thread_name(*out, trace_tid + 1, output_name + " (GPU)");
+    }
+
+    active_profilers.push_back(this);
+}
+
+frame_profiler_t::~frame_profiler_t()
+{
+    auto it = std::find(active_profilers.begin(), active_profilers.end(), this);
+    if (it != active_profilers.end())
+    {
+        active_profilers.erase(it);
+    }
+
+    if (gpu_timer.available)
+    {
+        OpenGL::render_begin();
+        for (auto& frame : pending)
+        {
+            free_queries.insert(free_queries.end(),
+                frame.gpu_queries.begin(), frame.gpu_queries.end());
+        }
+
+        free_queries.insert(free_queries.end(),
+            current.gpu_queries.begin(), current.gpu_queries.end());
+        if (!free_queries.empty())
+        {
+            gpu_timer.delete_queries(free_queries.size(), free_queries.data());
+        }
+
+        OpenGL::render_end();
+    }
+
+    if (active_profilers.empty() && trace_file)
+    {
+        trace_file.flush();
+    }
+}
+
+void frame_profiler_t::begin_frame(int64_t start)
+{
+    if (in_frame)
+    {
+        end_frame();
+    }
+
+    in_frame = true;
+    current  = {};
+    current.start = start;
+    open_stages.clear();
+}
+
+void frame_profiler_t::end_frame()
+{
+    if (!in_frame)
+    {
+        return;
+    }
+
+    while (!open_stages.empty())
+    {
+        end_stage();
+    }
+
+    in_frame    = false;
+    current.end = now();
+    if (current.gpu_queries.empty())
+    {
+        finish_frame(std::move(current));
+    } else
+    {
+        pending.push_back(std::move(current));
+        if (pending.size() > MAX_PENDING)
+        {
+            /* Results never arrived, give up on them */
+            free_queries.insert(free_queries.end(),
+                pending.front().gpu_queries.begin(),
+                pending.front().gpu_queries.end());
+            pending.front().gpu_queries.clear();
+            finish_frame(std::move(pending.front()));
+            pending.pop_front();
+        }
+    }
+
+    current = {};
+}
+
+GLuint frame_profiler_t::get_query()
+{
+    if (free_queries.empty())
+    {
+        GLuint query;
+        gpu_timer.gen_queries(1, &query);
+
+        return query;
+    }
+
+    GLuint query = free_queries.back();
+    free_queries.pop_back();
+
+    return query;
+}
+
+void frame_profiler_t::begin_stage(const std::string& name, bool gpu)
+{
+    if (!in_frame)
+    {
+        return;
+    }
+
+    frame_stage_t stage;
+    stage.name  = name;
+    stage.depth = open_stages.size();
+    stage.cpu_start = now();
+
+    if (gpu && gpu_timer.init())
+    {
+        GLuint query = get_query();
+        gpu_timer.query_counter(query, GL_TIMESTAMP_EXT);
+        stage.gpu_query_start = current.gpu_queries.size();
+        current.gpu_queries.push_back(query);
+    }
+
+    open_stages.push_back(current.stages.size());
+    current.stages.push_back(std::move(stage));
+}
+
+void frame_profiler_t::end_stage()
+{
+    if (!in_frame || open_stages.empty())
+    {
+        return;
+    }
+
+    auto& stage = current.stages[open_stages.back()];
+    open_stages.pop_back();
+
+    if (stage.gpu_query_start >= 0)
+    {
+        GLuint query = get_query();
+        gpu_timer.query_counter(query, GL_TIMESTAMP_EXT);
+        stage.gpu_query_end = current.gpu_queries.size();
+        current.gpu_queries.push_back(query);
+    }
+
+    stage.cpu_end = now();
+}
+
+void frame_profiler_t::add_stage(const std::string& name,
+    int64_t start, int64_t end)
+{
+    if (!in_frame)
+    {
+        return;
+    }
+
+    frame_stage_t stage;
+    stage.name  = name;
+    stage.depth = open_stages.size();
+    stage.cpu_start = start;
+    stage.cpu_end   = end;
+    current.stages.push_back(std::move(stage));
+}
+
+bool frame_profiler_t::read_gpu_results(frame_record_t& frame)
+{
+    GLuint available = 0;
+    gpu_timer.get_query_objectuiv(frame.gpu_queries.back(),
+        GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    if (!available)
+    {
+        return false;
+    }
+
+    std::vector<GLuint64> timestamps(frame.gpu_queries.size());
+    for (size_t i = 0; i < frame.gpu_queries.size(); i++)
+    {
+        gpu_timer.get_query_objectui64v(frame.gpu_queries[i],
+            GL_QUERY_RESULT_EXT, &timestamps[i]);
+    }
+
+    GLuint64 first = *std::min_element(timestamps.begin(), timestamps.end());
+    for (auto& stage : frame.stages)
+    {
+        if (stage.gpu_query_start >= 0)
+        {
+            stage.gpu_duration = timestamps[stage.gpu_query_end] -
+                timestamps[stage.gpu_query_start];
+            stage.gpu_offset = timestamps[stage.gpu_query_start] - first;
+        }
+    }
+
+    return true;
+}
+
+void frame_profiler_t::collect_gpu_results()
+{
+    if (pending.empty())
+    {
+        return;
+    }
+
+    /* If a disjoint operation occurred, the results are garbage */
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    while (!pending.empty())
+    {
+        auto& frame = pending.front();
+        if (!disjoint && !read_gpu_results(frame))
+        {
+            break;
+        }
+
+        free_queries.insert(free_queries.end(),
+            frame.gpu_queries.begin(), frame.gpu_queries.end());
+        frame.gpu_queries.clear();
+        finish_frame(std::move(frame));
+        pending.pop_front();
+    }
+}
+
+void frame_profiler_t::finish_frame(frame_record_t&& frame)
+{
+    write_trace(frame);
+    history.push_back(std::move(frame));
+    if (history.size() > MAX_HISTORY)
+    {
+        history.pop_front();
+    }
+
+    ++graph_serial;
+}
+
+void frame_profiler_t::write_trace(const frame_record_t& frame)
+{
+    auto out = get_trace_file();
+    if (!out)
+    {
+        return;
+    }
+
+    write_event(*out, trace_tid, "frame", frame.start, frame.end - frame.start);
+
+    /* GPU timestamps are in an unrelated time domain, so we align the first
+     * GPU stage with the CPU time at which it was started. */
+    int64_t gpu_base = -1;
+    for (auto& stage : frame.stages)
+    {
+        write_event(*out, trace_tid, stage.name,
+            stage.cpu_start, stage.cpu_end - stage.cpu_start);
+        if (stage.gpu_duration < 0)
+        {
+            continue;
+        }
+
+        if (gpu_base < 0)
+        {
+            gpu_base = stage.cpu_start - stage.gpu_offset;
+        }
+
+        write_event(*out, trace_tid + 1, stage.name,
+            gpu_base + stage.gpu_offset, stage.gpu_duration);
+    }
+}
+
+void frame_profiler_t::dump_stats() const
+{
+    struct stage_stats_t
+    {
+        int count = 0;
+        int64_t cpu_total = 0;
+        int64_t cpu_max   = 0;
+        int gpu_count     = 0;
+        int64_t gpu_total = 0;
+        int64_t gpu_max   = 0;
+    };
+
+    std::map<std::string, stage_stats_t> stats;
+    stage_stats_t frame_stats;
+    for (auto& frame : history)
+    {
+        auto duration = frame.end - frame.start;
+        frame_stats.count++;
+        frame_stats.cpu_total += duration;
+        frame_stats.cpu_max    = std::max(frame_stats.cpu_max, duration);
+
+        for (auto& stage : frame.stages)
+        {
+            auto& st = stats[stage.name];
+            auto cpu = stage.cpu_end - stage.cpu_start;
+            st.count++;
+            st.cpu_total += cpu;
+            st.cpu_max    = std::max(st.cpu_max, cpu);
+            if (stage.gpu_duration >= 0)
+            {
+                st.gpu_count++;
+                st.gpu_total += stage.gpu_duration;
+                st.gpu_max    = std::max(st.gpu_max, stage.gpu_duration);
+            }
+        }
+    }
+
+    if (frame_stats.count == 0)
+    {
+        LOGI("Frame profile for ", output_name, ": no frames recorded");
+
+        return;
+    }
+
+    auto ms = [] (int64_t nsec) { return nsec / 1'000'000.0; };
+    LOGI("Frame profile for ", output_name, " (last ", frame_stats.count,
+        " frames): avg ", ms(frame_stats.cpu_total / frame_stats.count),
+        "ms, max ", ms(frame_stats.cpu_max), "ms");
+
+    for (auto& [name, st] : stats)
+    {
+        if (st.gpu_count > 0)
+        {
+            LOGI("  ", name, ": ", st.count, "x, CPU avg ",
+                ms(st.cpu_total / st.count), "ms max ", ms(st.cpu_max),
+                "ms, GPU avg ", ms(st.gpu_total / st.gpu_count), "ms max ",
+                ms(st.gpu_max), "ms");
+        } else
+        {
+            LOGI("  ", name, ": ", st.count, "x, CPU avg ",
+                ms(st.cpu_total / st.count), "ms max ", ms(st.cpu_max), "ms");
+        }
+    }
+}
+
+void frame_profiler_t::dump_all()
+{
+    for (auto profiler : active_profilers)
+    {
+        profiler->dump_stats();
+    }
+
+    if (trace_file)
+    {
+        trace_file.flush();
+    }
+}
+
+/* Layout of the on-screen graph */
+static constexpr int GRAPH_BAR_WIDTH  = 2;
+static constexpr int GRAPH_HEIGHT     = 100;
+static constexpr int GRAPH_MARGIN     = 10;
+static constexpr double GRAPH_PX_PER_MS = 4.0;
+
+wf::geometry_t frame_profiler_t::get_graph_box() const
+{
+    return {GRAPH_MARGIN, GRAPH_MARGIN,
+        (int)MAX_HISTORY * GRAPH_BAR_WIDTH, GRAPH_HEIGHT};
+}
+
+uint64_t frame_profiler_t::get_graph_serial() const
+{
+    return graph_serial;
+}
+
+void frame_profiler_t::render_graph(const wf::framebuffer_t& fb,
+    int64_t refresh_nsec)
+{
+    auto box = get_graph_box();
+    auto projection = fb.get_orthographic_projection();
+
+    OpenGL::render_begin(fb);
+    fb.logic_scissor(box);
+    OpenGL::render_rectangle(box, {0, 0, 0, 0.6}, projection);
+
+    int x = box.x + box.width - GRAPH_BAR_WIDTH * history.size();
+    for (auto& frame : history)
+    {
+        double duration_ms = (frame.end - frame.start) / 1'000'000.0;
+        int height = std::min(box.height, int(duration_ms * GRAPH_PX_PER_MS));
+        bool missed = refresh_nsec > 0 &&
+            (frame.end - frame.start) > refresh_nsec;
+
+        wf::color_t color = missed ?
+            wf::color_t{1, 0.2, 0.2, 1} : wf::color_t{0.2, 1, 0.2, 1};
+        OpenGL::render_rectangle(
+            {x, box.y + box.height - height, GRAPH_BAR_WIDTH, height},
+            color, projection);
+        x += GRAPH_BAR_WIDTH;
+    }
+
+    /* A line at the refresh interval */
+    if (refresh_nsec > 0)
+    {
+        int y = box.y + box.height -
+            std::min(box.height, int(refresh_nsec / 1'000'000.0 * GRAPH_PX_PER_MS));
+        OpenGL::render_rectangle({box.x, y, box.width, 1},
+            {1, 1, 1, 1}, projection);
+    }
+
+    OpenGL::render_end();
+}
+}
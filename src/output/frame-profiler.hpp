@@ -0,0 +1,169 @@
+#ifndef WF_FRAME_PROFILER_HPP
+#define WF_FRAME_PROFILER_HPP
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <wayfire/opengl.hpp>
+#include <wayfire/nonstd/noncopyable.hpp>
+
+namespace wf
+{
+/**
+ * A single measured stage of a frame, for example an effect hook or the
+ * rendering of the scenegraph.
+ */
+struct frame_stage_t
+{
+    std::string name;
+    /* Nesting level of the stage, 0 for top-level stages */
+    int depth = 0;
+
+    /* CPU timestamps in nanoseconds, CLOCK_MONOTONIC */
+    int64_t cpu_start = 0;
+    int64_t cpu_end   = 0;
+
+    /* Indices of the GPU timestamp queries of the stage, or -1 if the stage
+     * is not measured on the GPU. */
+    int gpu_query_start = -1;
+    int gpu_query_end   = -1;
+
+    /* GPU duration in nanoseconds, or -1 if not available */
+    int64_t gpu_duration = -1;
+    /* GPU start relative to the first GPU timestamp of the frame */
+    int64_t gpu_offset = 0;
+};
+
+/** All stages of a single frame. */
+struct frame_record_t
+{
+    int64_t start = 0;
+    int64_t end   = 0;
+    std::vector<frame_stage_t> stages;
+
+    /* GPU timestamp queries issued during this frame */
+    std::vector<GLuint> gpu_queries;
+};
+
+/**
+ * frame_profiler_t records how long the stages of an output's repaint take.
+ *
+ * CPU time is measured with CLOCK_MONOTONIC. GPU time is measured with
+ * timestamp queries if GL_EXT_disjoint_timer_query is available. GPU results
+ * are collected asynchronously a few frames later, so that the profiler never
+ * stalls the pipeline.
+ *
+ * The profiler is enabled from the command line, see runtime_config. The
+ * recorded data can be dumped to the log (SIGUSR1), streamed to a Chrome trace
+ * file, and drawn as a graph on top of the output.
+ */
+class frame_profiler_t : public noncopyable_t
+{
+  public:
+    frame_profiler_t(std::string output_name);
+    ~frame_profiler_t();
+
+    /** @return true if frame profiling has been enabled. */
+    static bool is_enabled();
+
+    /** Write the statistics of all active profilers to the log. */
+    static void dump_all();
+
+    /** @return The current CLOCK_MONOTONIC time in nanoseconds. */
+    static int64_t now();
+
+    /**
+     * Start recording a new frame.
+     * @param start The time the frame started, in nanoseconds.
+     */
+    void begin_frame(int64_t start);
+
+    /** Finish the current frame. */
+    void end_frame();
+
+    /**
+     * Start a new stage. Stages may be nested.
+     *
+     * @param name The name of the stage.
+     * @param gpu Whether to measure the stage on the GPU as well. Should only
+     *   be used while the output is bound for rendering.
+     */
+    void begin_stage(const std::string& name, bool gpu = false);
+
+    /** End the last started stage. */
+    void end_stage();
+
+    /** Add an already measured CPU-only stage to the current frame. */
+    void add_stage(const std::string& name, int64_t start, int64_t end);
+
+    /**
+     * Collect the results of GPU queries from previous frames. Should be called
+     * while the output is bound for rendering.
+     */
+    void collect_gpu_results();
+
+    /** @return The region of the on-screen graph, in output-local coordinates */
+    wf::geometry_t get_graph_box() const;
+
+    /** @return A number which changes whenever the graph data changes. */
+    uint64_t get_graph_serial() const;
+
+    /**
+     * Draw a graph of the recent frame times.
+     *
+     * @param fb The framebuffer to render to.
+     * @param refresh_nsec The refresh interval of the output.
+     */
+    void render_graph(const wf::framebuffer_t& fb, int64_t refresh_nsec);
+
+    /** RAII helper to measure a stage, no-op if profiler is null. */
+    class scoped_stage_t : public noncopyable_t
+    {
+      public:
+        scoped_stage_t(frame_profiler_t *profiler, const std::string& name,
+            bool gpu = false) : profiler(profiler)
+        {
+            if (profiler)
+            {
+                profiler->begin_stage(name, gpu);
+            }
+        }
+
+        ~scoped_stage_t()
+        {
+            if (profiler)
+            {
+                profiler->end_stage();
+            }
+        }
+
+      private:
+        frame_profiler_t *profiler;
+    };
+
+  private:
+    std::string output_name;
+    int trace_tid;
+
+    bool in_frame = false;
+    frame_record_t current;
+    std::vector<int> open_stages;
+
+    /* Frames which wait for GPU results */
+    std::deque<frame_record_t> pending;
+    /* Finished frames */
+    std::deque<frame_record_t> history;
+    /* Incremented for each finished frame */
+    uint64_t graph_serial = 0;
+    /* Unused query objects */
+    std::vector<GLuint> free_queries;
+
+    GLuint get_query();
+    bool read_gpu_results(frame_record_t& frame);
+    void finish_frame(frame_record_t&& frame);
+    void write_trace(const frame_record_t& frame);
+    void dump_stats() const;
+};
+}
+
+#endif /* end of include guard: WF_FRAME_PROFILER_HPP */
@@ -7,7 +7,11 @@
 #include "../core/seat/input-manager.hpp"
 #include "../core/opengl-priv.hpp"
 #include "../main.hpp"
+#include "frame-profiler.hpp"
 #include <algorithm>
+#include <cmath>
+#include <deque>
+#include <unordered_map>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/nonstd/safe-list.hpp>
 #include <wayfire/util/log.hpp>
@@ -33,6 +37,13 @@ struct output_damage_t
     wf::wl_listener_wrapper on_damage_destroy;
 
     wf::region_t frame_damage;
+    /* Damage on all workspaces, relative to the workspace, after scaling.
+     * It is already included in frame_damage for the current workspace. */
+    wf::region_t sticky_damage;
+    /* Damage which hasn't been passed to wlroots yet, after scaling */
+    wf::region_t pending_damage;
+    wf::wl_idle_call idle_flush_damage;
+
     wlr_output *output;
     wlr_output_damage *damage_manager;
     output_t *wo;
@@ -61,7 +72,7 @@ struct output_damage_t
         /* Wlroots expects damage after scaling */
         auto scaled_region = region * wo->handle->scale;
         frame_damage |= scaled_region;
-        wlr_output_damage_add(damage_manager, scaled_region.to_pixman());
+        add_pending_damage(scaled_region);
     }
 
     void damage(const wf::geometry_t& box)
@@ -74,7 +85,49 @@ struct output_damage_t
         /* Wlroots expects damage after scaling */
         auto scaled_box = box * wo->handle->scale;
         frame_damage |= scaled_box;
-        wlr_output_damage_add_box(damage_manager, &scaled_box);
+        add_pending_damage(scaled_box);
+    }
+
+    /**
+     * Same as render_manager::damage_sticky()
+     */
+    void damage_sticky(const wf::region_t& region)
+    {
+        auto visible = region & wo->get_relative_geometry();
+        if (visible.empty() || !damage_manager)
+        {
+            return;
+        }
+
+        auto scaled_region = visible * wo->handle->scale;
+        sticky_damage |= scaled_region;
+        frame_damage  |= scaled_region;
+        add_pending_damage(scaled_region);
+    }
+
+    /**
+     * Damage from several views and commits is collected, and passed to
+     * wlroots at once when the event loop goes idle, or before the next frame
+     * if it comes earlier.
+     */
+    void add_pending_damage(const wf::region_t& scaled_region)
+    {
+        pending_damage |= scaled_region;
+        if (!idle_flush_damage.is_connected())
+        {
+            idle_flush_damage.run_once([=] () { flush_damage(); });
+        }
+    }
+
+    void flush_damage()
+    {
+        idle_flush_damage.disconnect();
+        if (!pending_damage.empty() && damage_manager)
+        {
+            wlr_output_damage_add(damage_manager, pending_damage.to_pixman());
+        }
+
+        pending_damage.clear();
     }
 
     /**
@@ -89,6 +142,7 @@ struct output_damage_t
             return false;
         }
 
+        flush_damage();
         wf::region_t tmp_region;
         auto r = wlr_output_damage_attach_render(damage_manager, &needs_swap,
             tmp_region.to_pixman());
@@ -121,7 +175,22 @@ struct output_damage_t
             return {};
         }
 
-        return frame_damage * (1.0 / wo->handle->scale);
+        auto damage = frame_damage * (1.0 / wo->handle->scale);
+        if (!sticky_damage.empty())
+        {
+            auto sticky = sticky_damage * (1.0 / wo->handle->scale);
+            auto wsize  = wo->workspace->get_workspace_grid_size();
+            for (int i = 0; i < wsize.width; i++)
+            {
+                for (int j = 0; j < wsize.height; j++)
+                {
+                    auto ws_box = get_ws_box({i, j});
+                    damage |= sticky + wf::point_t{ws_box.x, ws_box.y};
+                }
+            }
+        }
+
+        return damage;
     }
 
     /**
@@ -147,6 +216,25 @@ struct output_damage_t
             const_cast<wf::region_t&>(swap_damage).to_pixman());
         wlr_output_commit(output);
         frame_damage.clear();
+        sticky_damage.clear();
+    }
+
+    /**
+     * Record damage which has already been repainted in the current frame, so
+     * that it is repainted on older buffers as well. In contrast to damage(),
+     * no new frame is scheduled.
+     *
+     * @param region The repainted region, in the damage coordinate system.
+     */
+    void add_repainted_damage(const wf::region_t& region)
+    {
+        if (!damage_manager)
+        {
+            return;
+        }
+
+        pixman_region32_union(&damage_manager->current, &damage_manager->current,
+            const_cast<wf::region_t&>(region).to_pixman());
     }
 
     bool force_next_frame = false;
@@ -191,9 +279,15 @@ struct output_damage_t
      */
     wf::region_t get_ws_damage(wf::point_t ws)
     {
+        auto ws_box = get_ws_box(ws);
         auto scaled = frame_damage * (1.0 / wo->handle->scale);
+        if (!sticky_damage.empty())
+        {
+            scaled |= sticky_damage * (1.0 / wo->handle->scale) +
+                wf::point_t{ws_box.x, ws_box.y};
+        }
 
-        return scaled & get_ws_box(ws);
+        return scaled & ws_box;
     }
 
     /**
@@ -235,9 +329,15 @@ struct effect_hook_manager_t
     using effect_container_t = wf::safe_list_t<effect_hook_t*>;
     effect_container_t effects[OUTPUT_EFFECT_TOTAL];
 
-    void add_effect(effect_hook_t *hook, output_effect_type_t type)
+    /* Names of the hooks, used for profiling */
+    std::unordered_map<effect_hook_t*, std::string> names;
+    frame_profiler_t *profiler = nullptr;
+
+    void add_effect(effect_hook_t *hook, output_effect_type_t type,
+        const std::string& name)
     {
         effects[type].push_back(hook);
+        names[hook] = name;
     }
 
     void rem_effect(effect_hook_t *hook)
@@ -246,12 +346,30 @@ struct effect_hook_manager_t
         {
             effects[i].remove_all(hook);
         }
+
+        names.erase(hook);
     }
 
     void run_effects(output_effect_type_t type)
     {
-        effects[type].for_each([] (auto effect)
-        { (*effect)(); });
+        if (!profiler)
+        {
+            effects[type].for_each([] (auto effect)
+            { (*effect)(); });
+
+            return;
+        }
+
+        static const char *type_names[] = {"pre", "overlay", "post"};
+        /* Overlay hooks run while the output is bound, so they can be
+         * measured on the GPU as well */
+        bool gpu = (type == OUTPUT_EFFECT_OVERLAY);
+        effects[type].for_each([&] (auto effect)
+        {
+            frame_profiler_t::scoped_stage_t stage{profiler,
+                std::string(type_names[type]) + " hook: " + names[effect], gpu};
+            (*effect)();
+        });
     }
 };
 
@@ -262,7 +380,15 @@ struct postprocessing_manager_t
 {
     using post_container_t = wf::safe_list_t<post_hook_t*>;
     post_container_t post_effects;
-    wf::framebuffer_base_t post_buffers[3];
+    /* The buffer other operations render to, followed by one buffer for each
+     * post hook except the last one */
+    std::deque<wf::framebuffer_base_t> post_buffers{1};
+
+    /* Names of the hooks, used for profiling */
+    std::unordered_map<post_hook_t*, std::string> names;
+    /* How each hook spreads damage */
+    std::unordered_map<post_hook_t*, post_damage_spread_t> spreads;
+    frame_profiler_t *profiler = nullptr;
     /* Buffer to which other operations render to */
     static constexpr uint32_t default_out_buffer = 0;
 
@@ -309,50 +435,116 @@ struct postprocessing_manager_t
         OpenGL::render_end();
     }
 
-    void add_post(post_hook_t *hook)
+    void add_post(post_hook_t *hook, const std::string& name,
+        post_damage_spread_t spread)
     {
         post_effects.push_back(hook);
+        names[hook]   = name;
+        spreads[hook] = spread;
         output->render->damage_whole_idle();
     }
 
     void rem_post(post_hook_t *hook)
     {
         post_effects.remove_all(hook);
+        names.erase(hook);
+        spreads.erase(hook);
         output->render->damage_whole_idle();
     }
 
-    /* Run all postprocessing effects, rendering to alternating buffers and
-     * finally to the screen.
+    /**
+     * Expand the damage of a hook's source to the damage of its destination.
+     */
+    void spread_damage(wf::region_t& damage, post_damage_spread_t spread,
+        const wlr_box& damage_box)
+    {
+        switch (spread.type)
+        {
+          case POST_DAMAGE_IDENTITY:
+            break;
+
+          case POST_DAMAGE_RADIUS:
+            damage.expand_edges(spread.radius);
+            damage &= damage_box;
+            break;
+
+          default:
+            damage |= damage_box;
+            break;
+        }
+    }
+
+    /**
+     * Run all postprocessing effects, each rendering to its own buffer, and
+     * the last one to the screen.
      *
-     * NB: 2 buffers just aren't enough. We render to the zero buffer, and then
-     * we alternately render to the second and the third. The reason: We track
-     * damage. So, we need to keep the whole buffer each frame. */
-    void run_post_effects()
+     * Passes only repaint the damaged part of their destination, so each
+     * buffer has to keep the output of the same hook from the previous frame.
+     * This is why the buffers are not shared between hooks.
+     *
+     * @param damage The damage of the output image before postprocessing, in
+     *   the damage coordinate system of the output. Afterwards, it contains
+     *   the damage of the final image.
+     */
+    void run_post_effects(wf::region_t& damage)
     {
         wf::framebuffer_base_t default_framebuffer;
         default_framebuffer.fb  = output_fb;
         default_framebuffer.tex = 0;
 
-        int last_buffer_idx = default_out_buffer;
-        int next_buffer_idx = 1;
+        int width, height;
+        wlr_output_transformed_resolution(output->handle, &width, &height);
+        wlr_box damage_box = {0, 0, width, height};
+
+        /* Used to convert damage boxes to scissor boxes. The damage is already
+         * scaled, but not rotated. */
+        auto scissor_fb = get_target_framebuffer();
+        scissor_fb.geometry = damage_box;
+        scissor_fb.scale    = 1;
 
+        size_t last_buffer_idx = default_out_buffer;
         post_effects.for_each([&] (auto post) -> void
         {
-            /* The last postprocessing hook renders directly to the screen, others to
-             * the currently free buffer */
+            /* The last postprocessing hook renders directly to the screen,
+             * others to their own buffer */
+            size_t next_buffer_idx = last_buffer_idx + 1;
+            if ((post != post_effects.back()) &&
+                (next_buffer_idx >= post_buffers.size()))
+            {
+                post_buffers.emplace_back();
+            }
+
             wf::framebuffer_base_t& next_buffer =
                 (post == post_effects.back() ? default_framebuffer :
                     post_buffers[next_buffer_idx]);
 
             OpenGL::render_begin();
-            /* Make sure we have the correct resolution */
-            next_buffer.allocate(output_width, output_height);
+            /* Make sure we have the correct resolution. A new buffer has no
+             * previous contents, so it has to be repainted fully. */
+            if (next_buffer.allocate(output_width, output_height))
+            {
+                damage |= damage_box;
+            }
+
             OpenGL::render_end();
 
-            (*post)(post_buffers[last_buffer_idx], next_buffer);
+            spread_damage(damage, spreads[post], damage_box);
+            auto extents = wlr_box_from_pixman_box(damage.get_extents());
+            if (damage.empty())
+            {
+                extents = {0, 0, 0, 0};
+            }
+
+            scissor_fb.scissor(
+                scissor_fb.framebuffer_box_from_geometry_box(extents));
+            {
+                frame_profiler_t::scoped_stage_t stage{profiler,
+                    profiler ? "post-processing hook: " + names[post] : "", true};
+                (*post)(post_buffers[last_buffer_idx], next_buffer);
+            }
 
-            last_buffer_idx  = next_buffer_idx;
-            next_buffer_idx ^= 0b11; // alternate 1 and 2
+            GL_CALL(glDisable(GL_SCISSOR_TEST));
+            last_buffer_idx = next_buffer_idx;
         });
     }
 
@@ -492,6 +684,87 @@ class depth_buffer_manager_t : public noncopyable_t
     std::vector<depth_buffer_t> buffers;
 };
 
+/**
+ * Keeps track of how long the recent repaints of an output took, and estimates
+ * how much time should be left for the next repaint.
+ *
+ * Used when core/adaptive_max_render_time is enabled.
+ */
+struct render_time_estimator_t
+{
+    /* How many of the most recent frames to use for the estimate */
+    static constexpr size_t MAX_SAMPLES = 120;
+    /* Do not delay repaints until we have seen at least this many frames */
+    static constexpr size_t MIN_SAMPLES = 30;
+    /* The percentile of recent frame times which is used for the estimate */
+    static constexpr double PERCENTILE = 0.95;
+
+    /* Safety margin added on top of the estimate, in nanoseconds */
+    static constexpr int64_t MIN_MARGIN = 1'000'000;
+    static constexpr int64_t MAX_MARGIN = 8'000'000;
+
+    /* After a missed frame, render without delay for this many frames */
+    static constexpr int MISS_COOLDOWN = 60;
+    /* Reduce the margin again after this many frames without a miss */
+    static constexpr int MARGIN_DECAY_FRAMES = 600;
+
+    std::deque<int64_t> samples;
+    int64_t margin = MIN_MARGIN;
+    int cooldown   = 0;
+    int frames_since_miss = 0;
+
+    /** Add the duration of a finished repaint, in nanoseconds. */
+    void add_sample(int64_t duration)
+    {
+        samples.push_back(duration);
+        if (samples.size() > MAX_SAMPLES)
+        {
+            samples.pop_front();
+        }
+
+        if (cooldown > 0)
+        {
+            --cooldown;
+        }
+
+        if ((++frames_since_miss >= MARGIN_DECAY_FRAMES) &&
+            (margin > MIN_MARGIN))
+        {
+            margin = std::max(MIN_MARGIN, margin / 2);
+            frames_since_miss = 0;
+        }
+    }
+
+    /**
+     * A delayed frame missed its deadline. Stop delaying repaints for a while
+     * and use a larger margin afterwards.
+     */
+    void frame_missed()
+    {
+        cooldown = MISS_COOLDOWN;
+        frames_since_miss = 0;
+        margin = std::min(MAX_MARGIN, margin * 2);
+    }
+
+    /**
+     * @return The time in nanoseconds which should be left for the next
+     *   repaint, or -1 if the repaint should not be delayed at all.
+     */
+    int64_t get_estimate() const
+    {
+        if ((cooldown > 0) || (samples.size() < MIN_SAMPLES))
+        {
+            return -1;
+        }
+
+        std::vector<int64_t> sorted{samples.begin(), samples.end()};
+        auto nth = sorted.begin() + (size_t)(PERCENTILE * (sorted.size() - 1));
+        std::nth_element(sorted.begin(), nth, sorted.end());
+
+        return *nth + margin;
+    }
+};
+
 class wf::render_manager::impl
 {
   public:
@@ -506,9 +779,34 @@ class wf::render_manager::impl
     std::unique_ptr<effect_hook_manager_t> effects;
     std::unique_ptr<postprocessing_manager_t> postprocessing;
     std::unique_ptr<depth_buffer_manager_t> depth_buffer_manager;
+    std::unique_ptr<frame_profiler_t> profiler;
+    /* When the repaint was delayed because of max_render_time */
+    int64_t repaint_delay_start = -1;
+    /* Whether the last call to do_paint() committed a new frame */
+    bool frame_committed = false;
+    /* Whether the last frame repainted nothing but the frame graph */
+    bool graph_only_frame = false;
+    /* The graph serial of the profiler when the graph was last drawn */
+    uint64_t drawn_graph_serial = 0;
+
+    render_time_estimator_t render_time;
+    /* Whether the current repaint was delayed by the adaptive render time */
+    bool adaptive_delay = false;
+    /* Time of the last presentation event of the output, in nanoseconds */
+    int64_t last_present = -1;
+    /* The latest time the currently delayed frame should have been presented */
+    int64_t present_deadline = -1;
+    /* Signalled when the GPU has finished the last committed frame */
+    GLsync render_fence = NULL;
+    /* When the frame guarded by render_fence started repainting, and when its
+     * commands were submitted, in nanoseconds */
+    int64_t render_fence_start     = -1;
+    int64_t render_fence_submitted = -1;
+    wf::wl_timer render_fence_timer;
 
     wf::option_wrapper_t<wf::color_t> background_color_opt;
     wf::option_wrapper_t<int> max_render_time_opt;
+    wf::option_wrapper_t<bool> adaptive_max_render_time_opt;
 
     impl(output_t *o) :
         output(o)
@@ -518,25 +816,36 @@ class wf::render_manager::impl
         postprocessing = std::make_unique<postprocessing_manager_t>(o);
         depth_buffer_manager = std::make_unique<depth_buffer_manager_t>();
 
+        if (frame_profiler_t::is_enabled())
+        {
+            profiler = std::make_unique<frame_profiler_t>(o->handle->name);
+            effects->profiler = profiler.get();
+            postprocessing->profiler = profiler.get();
+        }
+
         on_present.set_callback([&] (void *data)
         {
             auto ev = static_cast<wlr_output_event_present*>(data);
             this->refresh_nsec = ev->refresh;
+            if (ev->when)
+            {
+                handle_present(ev->when->tv_sec * 1'000'000'000ll +
+                    ev->when->tv_nsec);
+            }
         });
         on_present.connect(&output->handle->events.present);
 
         max_render_time_opt.load_option("core/max_render_time");
+        adaptive_max_render_time_opt.load_option("core/adaptive_max_render_time");
+        occluded_frame_rate_opt.load_option("core/occluded_frame_rate");
         on_frame.set_callback([&] (void*)
         {
             /*
              * Leave a bit of time for clients to render, see
              * https://github.com/swaywm/sway/pull/4588
              */
-            int64_t total = this->refresh_nsec / 1000000 - max_render_time_opt;
-            if ((total <= 0) || (max_render_time_opt <= 0) || this->renderer)
-            {
-                total = 0;
-            }
+            int64_t total = get_repaint_delay();
+            adaptive_delay = (total >= 1) && adaptive_max_render_time_opt;
 
             // We cannot really wait less than 1ms, render right away in that case
             if (total < 1)
@@ -545,6 +854,11 @@ class wf::render_manager::impl
             } else
             {
                 output->handle->frame_pending = true;
+                if (profiler)
+                {
+                    repaint_delay_start = frame_profiler_t::now();
+                }
+
                 repaint_timer.set_timeout(total, [=] ()
                 {
                     output->handle->frame_pending = false;
@@ -557,6 +871,7 @@ class wf::render_manager::impl
         on_frame.connect(&output_damage->damage_manager->events.frame);
 
         init_default_streams();
+        init_render_lists();
 
         background_color_opt.load_option("core/background_color");
         background_color_opt.set_callback([=] ()
@@ -567,6 +882,16 @@ class wf::render_manager::impl
         output_damage->schedule_repaint();
     }
 
+    ~impl()
+    {
+        if (render_fence)
+        {
+            OpenGL::render_begin();
+            GL_CALL(glDeleteSync(render_fence));
+            OpenGL::render_end();
+        }
+    }
+
     /* A stream for each workspace */
     std::vector<std::vector<workspace_stream_t>> default_streams;
     /* The stream pointing to the current workspace */
@@ -587,8 +912,27 @@ class wf::render_manager::impl
         }
     }
 
-    render_hook_t renderer;
+    damage_render_hook_t renderer;
     void set_renderer(render_hook_t rh)
+    {
+        if (!rh)
+        {
+            set_damage_renderer(nullptr);
+
+            return;
+        }
+
+        /* Plain render hooks repaint the whole output each frame */
+        set_damage_renderer([=] (const wf::framebuffer_t& fb,
+                                 const wf::region_t&) -> wf::region_t
+        {
+            rh(fb);
+
+            return output->get_relative_geometry();
+        });
+    }
+
+    void set_damage_renderer(damage_render_hook_t rh)
     {
         renderer = rh;
         output_damage->damage_whole_idle();
@@ -693,9 +1037,17 @@ class wf::render_manager::impl
     {
         if (renderer)
         {
-            renderer(postprocessing->get_target_framebuffer());
-            /* TODO: let custom renderers specify what they want to repaint... */
-            swap_damage |= output_damage->get_wlr_damage_box();
+            auto damage  = output_damage->get_scheduled_damage();
+            auto changed = renderer(postprocessing->get_target_framebuffer(),
+                damage) * output->handle->scale;
+            changed &= output_damage->get_wlr_damage_box();
+
+            /* The changes are not known to wlroots, which needs them to compute
+             * the damage of older buffers in later frames */
+            output_damage->add_repainted_damage(changed);
+            swap_damage  = damage * output->handle->scale;
+            swap_damage |= changed;
+            swap_damage &= output_damage->get_wlr_damage_box();
         } else
         {
             swap_damage =
@@ -725,10 +1077,185 @@ class wf::render_manager::impl
         }
     }
 
+    /**
+     * @return How many milliseconds to wait after a frame event before
+     *   repainting, either from core/max_render_time or estimated from the
+     *   recent repaints of the output.
+     */
+    int64_t get_repaint_delay()
+    {
+        if (this->renderer || (this->refresh_nsec <= 0))
+        {
+            return 0;
+        }
+
+        if (adaptive_max_render_time_opt)
+        {
+            int64_t estimate = render_time.get_estimate();
+            if (estimate < 0)
+            {
+                return 0;
+            }
+
+            return std::max(int64_t(0), (refresh_nsec - estimate) / 1000000);
+        }
+
+        if (max_render_time_opt <= 0)
+        {
+            return 0;
+        }
+
+        return std::max(int64_t(0),
+            this->refresh_nsec / 1000000 - max_render_time_opt);
+    }
+
+    /**
+     * Check whether a frame delayed by the adaptive render time was presented
+     * in time.
+     *
+     * @param when The presentation time in nanoseconds.
+     */
+    void handle_present(int64_t when)
+    {
+        if ((present_deadline >= 0) && (when > present_deadline))
+        {
+            LOGD("Output ", output->handle->name, " missed a frame, ",
+                "not delaying repaints for a while");
+            render_time.frame_missed();
+        }
+
+        present_deadline = -1;
+        last_present     = when;
+    }
+
+    /**
+     * @return The current time in nanoseconds, in the clock which the
+     *   backend uses for presentation timestamps.
+     */
+    static int64_t presentation_now()
+    {
+        timespec ts;
+        clock_gettime(wlr_backend_get_presentation_clock(
+            wf::get_core_impl().backend), &ts);
+
+        return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+    }
+
     /**
      * Repaints the whole output, includes all effects and hooks
      */
     void paint()
+    {
+        auto now = frame_profiler_t::now();
+        if (adaptive_delay && (last_present >= 0))
+        {
+            /* The frame should be presented at the first vblank after now.
+             * Allow for half a refresh cycle of jitter. The presentation
+             * timestamps may use a different clock than the profiler. */
+            int64_t cycles = (presentation_now() - last_present) /
+                refresh_nsec + 1;
+            present_deadline = last_present + cycles * refresh_nsec +
+                refresh_nsec / 2;
+        }
+
+        if (render_fence)
+        {
+            /* The GPU is still busy with the last frame */
+            poll_render_fence(true);
+        }
+
+        frame_committed = false;
+        if (profiler)
+        {
+            if (repaint_delay_start >= 0)
+            {
+                profiler->begin_frame(repaint_delay_start);
+                profiler->add_stage("max_render_time delay",
+                    repaint_delay_start, now);
+                repaint_delay_start = -1;
+            } else
+            {
+                profiler->begin_frame(now);
+            }
+        }
+
+        do_paint();
+        if (profiler)
+        {
+            profiler->end_frame();
+            damage_frame_graph();
+        }
+
+        if (!frame_committed)
+        {
+            present_deadline = -1;
+        } else if (render_fence)
+        {
+            render_fence_start     = now;
+            render_fence_submitted = frame_profiler_t::now();
+            render_fence_timer.set_timeout(1, [=] () { poll_render_fence(false); });
+        } else
+        {
+            render_time.add_sample(frame_profiler_t::now() - now);
+        }
+
+        adaptive_delay = false;
+    }
+
+    /**
+     * With the adaptive render time, insert a fence after the commands of the
+     * frame, so that the render time samples cover the GPU as well. Must be
+     * called while the output's context is current.
+     */
+    void submit_render_fence()
+    {
+        if (!adaptive_max_render_time_opt)
+        {
+            return;
+        }
+
+        render_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        /* Make sure the fence gets to the GPU, otherwise it never signals */
+        GL_CALL(glFlush());
+    }
+
+    /**
+     * Check whether the GPU has finished the last frame, and if so, add the
+     * time from the start of the repaint until then as a render time sample.
+     * The completion time is known up to the polling interval.
+     *
+     * @param force Whether to take the sample even if the GPU is not done yet,
+     *   with the current time as completion time.
+     */
+    void poll_render_fence(bool force)
+    {
+        OpenGL::render_begin();
+        GLenum status = glClientWaitSync(render_fence, 0, 0);
+        if ((status == GL_TIMEOUT_EXPIRED) && !force)
+        {
+            OpenGL::render_end();
+            render_fence_timer.set_timeout(1,
+                [=] () { poll_render_fence(false); });
+
+            return;
+        }
+
+        GL_CALL(glDeleteSync(render_fence));
+        OpenGL::render_end();
+        render_fence = NULL;
+        render_fence_timer.disconnect();
+
+        int64_t done = frame_profiler_t::now();
+        if (status == GL_WAIT_FAILED)
+        {
+            done = render_fence_submitted;
+        }
+
+        render_time.add_sample(
+            std::max(done, render_fence_submitted) - render_fence_start);
+    }
+
+    void do_paint()
     {
         /* Part 1: frame setup: query damage, etc. */
         effects->run_effects(OUTPUT_EFFECT_PRE);
@@ -753,25 +1280,48 @@ class wf::render_manager::impl
         }
 
         update_bound_output();
+        if (profiler)
+        {
+            profiler->collect_gpu_results();
+        }
 
         /* Part 2: call the renderer, which sets swap_damage and
          * draws the scenegraph */
-        render_output();
+        {
+            frame_profiler_t::scoped_stage_t stage{profiler.get(),
+                "render output", true};
+            render_output();
+        }
 
         /* Part 3: finalize the scene: overlay effects and sw cursors */
         effects->run_effects(OUTPUT_EFFECT_OVERLAY);
 
-        if (postprocessing->post_effects.size())
+        if (runtime_config.frame_graph && profiler)
         {
-            swap_damage |= output_damage->get_wlr_damage_box();
+            /* Same conversion as for the scheduled damage in render_output(),
+             * swap_buffers() then applies the output transform. */
+            wf::region_t graph_damage =
+                profiler->get_graph_box() * output->handle->scale;
+            graph_damage    &= output_damage->get_wlr_damage_box();
+            graph_only_frame = (swap_damage ^ graph_damage).empty();
+            swap_damage     |= graph_damage;
+
+            profiler->render_graph(postprocessing->get_target_framebuffer(),
+                refresh_nsec);
+            drawn_graph_serial = profiler->get_graph_serial();
         }
 
-        OpenGL::render_begin(postprocessing->get_target_framebuffer());
-        wlr_output_render_software_cursors(output->handle, swap_damage.to_pixman());
-        OpenGL::render_end();
+        {
+            frame_profiler_t::scoped_stage_t stage{profiler.get(),
+                "software cursors", true};
+            OpenGL::render_begin(postprocessing->get_target_framebuffer());
+            wlr_output_render_software_cursors(output->handle,
+                swap_damage.to_pixman());
+            OpenGL::render_end();
+        }
 
         /* Part 4: postprocessing effects */
-        postprocessing->run_post_effects();
+        postprocessing->run_post_effects(swap_damage);
         if (output_inhibit_counter)
         {
             OpenGL::render_begin(output->handle->width, output->handle->height,
@@ -782,7 +1332,14 @@ class wf::render_manager::impl
 
         /* Part 5: finalize frame: swap buffers, send frame_done, etc */
         OpenGL::unbind_output(output);
-        output_damage->swap_buffers(swap_damage);
+        submit_render_fence();
+        {
+            frame_profiler_t::scoped_stage_t stage{profiler.get(),
+                "swap buffers"};
+            output_damage->swap_buffers(swap_damage);
+        }
+
+        frame_committed = true;
         swap_damage.clear();
         post_paint();
     }
@@ -801,48 +1358,209 @@ class wf::render_manager::impl
     }
 
     /**
-     * Send frame_done to clients.
+     * Damage the frame graph if it does not show the latest frames anymore.
+     * Frames which repainted only the graph do not damage it again, otherwise
+     * the graph alone would keep the output repainting.
      */
-    void send_frame_done()
+    void damage_frame_graph()
+    {
+        if (!runtime_config.frame_graph || !frame_committed || graph_only_frame)
+        {
+            return;
+        }
+
+        if (profiler->get_graph_serial() != drawn_graph_serial)
+        {
+            output_damage->damage(profiler->get_graph_box());
+        }
+    }
+
+    wf::option_wrapper_t<int> occluded_frame_rate_opt;
+    wf::wl_timer occluded_frame_timer;
+    uint32_t last_occluded_frame_done = 0;
+    uint32_t throttled_surfaces_count = 0;
+
+    /**
+     * @return The minimal interval in milliseconds between two frame callbacks
+     * for fully occluded surfaces, or 0 if throttling is disabled.
+     */
+    uint32_t get_occluded_frame_interval()
+    {
+        if (occluded_frame_rate_opt <= 0)
+        {
+            return 0;
+        }
+
+        return std::max(1, 1000 / occluded_frame_rate_opt);
+    }
+
+    /**
+     * Walk over all mapped surfaces which would receive frame callbacks, from
+     * the topmost to the bottommost one, and report whether each of them is
+     * fully occluded by the opaque regions of the surfaces above it.
+     *
+     * This is the same opaque region subtraction that schedule_surface() does
+     * for the damaged region.
+     */
+    void for_each_frame_surface(
+        const std::function<void(wf::surface_interface_t*, bool)>& callback)
     {
-        /* TODO: do this only if the view isn't fully occluded by another */
-        std::vector<wayfire_view> visible_views;
         if (renderer)
         {
-            visible_views = output->workspace->get_views_in_layer(
+            /* Custom renderers may show any view in any way, so we cannot
+             * reason about occlusion there. */
+            auto views = output->workspace->get_views_in_layer_snapshot(
                 wf::VISIBLE_LAYERS);
-        } else
+            for (auto& v : *views)
+            {
+                for (auto& view : v->traverse_views())
+                {
+                    if (!view->is_mapped())
+                    {
+                        continue;
+                    }
+
+                    for (auto& child : view->traverse_surfaces())
+                    {
+                        callback(child.surface, false);
+                    }
+                }
+            }
+
+            return;
+        }
+
+        auto cws = output->workspace->get_current_workspace();
+        wf::region_t opaque;
+        auto is_occluded = [&] (const wlr_box& box)
+        {
+            if ((box.width <= 0) || (box.height <= 0))
+            {
+                return false;
+            }
+
+            return (wf::region_t{box} ^ opaque).empty();
+        };
+
+        auto views = output->workspace->get_views_in_layer_snapshot(
+            wf::VISIBLE_LAYERS);
+        for (auto& v : *views)
         {
-            visible_views = output->workspace->get_views_on_workspace(
-                output->workspace->get_current_workspace(),
-                wf::MIDDLE_LAYERS);
+            /* Regular views only need frame callbacks if they are on the
+             * current workspace, panels/backgrounds/etc. always get them. */
+            if ((output->workspace->get_view_layer(v) & wf::MIDDLE_LAYERS) &&
+                !output->workspace->view_visible_on(v, cws))
+            {
+                continue;
+            }
 
-            // send to all panels/backgrounds/etc
-            auto additional_views = output->workspace->get_views_in_layer(
-                wf::BELOW_LAYERS | wf::ABOVE_LAYERS);
+            for (auto& view : v->traverse_views())
+            {
+                if (!view->is_mapped())
+                {
+                    continue;
+                }
 
-            visible_views.insert(visible_views.end(),
-                additional_views.begin(), additional_views.end());
+                if (view->has_transformer())
+                {
+                    /* Transformed views are rendered as a whole, so we
+                     * consider all of their surfaces together */
+                    bool occluded = is_occluded(view->get_bounding_box());
+                    for (auto& child : view->traverse_surfaces())
+                    {
+                        callback(child.surface, occluded);
+                    }
+
+                    if (view->is_visible())
+                    {
+                        opaque |= view->get_transformed_opaque_region();
+                    }
+
+                    continue;
+                }
+
+                auto og = view->get_output_geometry();
+                for (auto& child : view->traverse_surfaces({og.x, og.y}))
+                {
+                    auto size = child.surface->get_size();
+                    wlr_box box = {child.position.x, child.position.y,
+                        size.width, size.height};
+                    callback(child.surface, is_occluded(box));
+
+                    if (view->is_visible())
+                    {
+                        opaque |=
+                            child.surface->get_opaque_region(child.position);
+                    }
+                }
+            }
         }
+    }
 
+    /**
+     * Send frame_done to clients.
+     *
+     * Surfaces which are fully occluded receive frame callbacks at most
+     * core/occluded_frame_rate times per second.
+     *
+     * @param occluded_only Whether to send frame callbacks only to occluded
+     *   surfaces, used when the throttling timer expires.
+     */
+    void send_frame_done(bool occluded_only = false)
+    {
         timespec repaint_ended;
         clockid_t presentation_clock =
             wlr_backend_get_presentation_clock(wf::get_core_impl().backend);
         clock_gettime(presentation_clock, &repaint_ended);
-        for (auto& v : visible_views)
+
+        const uint32_t interval = get_occluded_frame_interval();
+        const uint32_t now = get_current_time();
+        const bool occluded_due =
+            (interval == 0) || (now - last_occluded_frame_done >= interval);
+
+        uint32_t throttled = 0;
+        bool sent_to_occluded = false;
+        for_each_frame_surface([&] (wf::surface_interface_t *surface,
+                                    bool occluded)
         {
-            for (auto& view : v->enumerate_views())
+            if (!occluded)
             {
-                if (!view->is_mapped())
+                if (!occluded_only)
                 {
-                    continue;
+                    surface->send_frame_done(repaint_ended);
                 }
 
-                for (auto& child : view->enumerate_surfaces())
-                {
-                    child.surface->send_frame_done(repaint_ended);
-                }
+                return;
+            }
+
+            if (occluded_due)
+            {
+                surface->send_frame_done(repaint_ended);
+                sent_to_occluded = true;
+            } else
+            {
+                ++throttled;
             }
+        });
+
+        if (sent_to_occluded)
+        {
+            last_occluded_frame_done = now;
+        }
+
+        if (!occluded_only)
+        {
+            throttled_surfaces_count = throttled;
+        }
+
+        /* Occluded surfaces do not damage the output, so there might be no
+         * next frame. Make sure they still get their frame callbacks. */
+        if (throttled)
+        {
+            uint32_t elapsed = now - last_occluded_frame_done;
+            occluded_frame_timer.set_timeout(
+                interval > elapsed ? interval - elapsed : 1,
+                [=] () { send_frame_done(true); });
         }
     }
 
@@ -850,12 +1568,11 @@ class wf::render_manager::impl
     void workspace_stream_start(workspace_stream_t& stream)
     {
         stream.running = true;
-        stream.scale_x = stream.scale_y = 1;
 
         /* damage the whole workspace region, so that we get a full repaint
          * when updating the workspace */
         output_damage->damage(output_damage->get_ws_box(stream.ws));
-        workspace_stream_update(stream, 1, 1);
+        workspace_stream_update(stream, stream.scale_x, stream.scale_y);
     }
 
     /**
@@ -873,7 +1590,43 @@ class wf::render_manager::impl
         wf::region_t damage;
     };
 
-    using damaged_surface = std::unique_ptr<damaged_surface_t>;
+    /**
+     * A stack-like pool of damaged_surface_t entries which are reused between
+     * frames, so that scheduling surfaces does not allocate.
+     *
+     * Each workspace stream repaint uses the entries from the position of the
+     * arena when the repaint started up to the current top of the arena.
+     */
+    struct damaged_surface_arena_t
+    {
+        /* std::deque never invalidates references when growing */
+        std::deque<damaged_surface_t> entries;
+        size_t used = 0;
+
+        /** Get a new cleared entry on the top of the arena */
+        damaged_surface_t& push()
+        {
+            if (used == entries.size())
+            {
+                entries.emplace_back();
+            }
+
+            auto& ds = entries[used++];
+            ds.surface = nullptr;
+            ds.view    = nullptr;
+            ds.damage.clear();
+
+            return ds;
+        }
+
+        /** Drop the entry on the top of the arena */
+        void pop()
+        {
+            --used;
+        }
+    };
+
+    damaged_surface_arena_t surface_arena;
 
     /**
      * Represents the state while calculating what parts of the output
@@ -881,7 +1634,9 @@ class wf::render_manager::impl
      */
     struct workspace_stream_repaint_t
     {
-        std::vector<damaged_surface> to_render;
+        /* The surfaces to render are surface_arena.entries[first_surface, used),
+         * ordered from the topmost to the bottommost one */
+        size_t first_surface;
         wf::region_t ws_damage;
         wf::framebuffer_t fb;
 
@@ -898,17 +1653,20 @@ class wf::render_manager::impl
     void schedule_snapshotted_view(workspace_stream_repaint_t& repaint,
         wayfire_view view, wf::point_t view_delta)
     {
-        auto ds = damaged_surface(new damaged_surface_t);
+        auto& ds = surface_arena.push();
 
         auto bbox = view->get_bounding_box() + view_delta;
-        ds->damage = (repaint.ws_damage & bbox) + -view_delta;
-        if (!ds->damage.empty())
+        ds.damage  = repaint.ws_damage & bbox;
+        ds.damage += -view_delta;
+        if (!ds.damage.empty())
         {
-            ds->pos  = -view_delta;
-            ds->view = view.get();
+            ds.pos  = -view_delta;
+            ds.view = view.get();
             repaint.ws_damage ^=
                 view->get_transformed_opaque_region() + view_delta;
-            repaint.to_render.push_back(std::move(ds));
+        } else
+        {
+            surface_arena.pop();
         }
     }
 
@@ -929,7 +1687,7 @@ class wf::render_manager::impl
             return;
         }
 
-        auto ds = damaged_surface(new damaged_surface_t);
+        auto& ds = surface_arena.push();
         wlr_box obox = {
             .x     = pos.x,
             .y     = pos.y,
@@ -937,16 +1695,18 @@ class wf::render_manager::impl
             .height = surface->get_size().height
         };
 
-        ds->damage = repaint.ws_damage & obox;
-        if (!ds->damage.empty())
+        ds.damage = repaint.ws_damage & obox;
+        if (!ds.damage.empty())
         {
-            ds->pos     = pos;
-            ds->surface = surface;
+            ds.pos     = pos;
+            ds.surface = surface;
 
             /* Subtract opaque region from workspace damage. The views below
              * won't be visible, so no need to damage them */
-            repaint.ws_damage ^= ds->surface->get_opaque_region(pos);
-            repaint.to_render.push_back(std::move(ds));
+            repaint.ws_damage ^= ds.surface->get_opaque_region(pos);
+        } else
+        {
+            surface_arena.pop();
         }
     }
 
@@ -969,7 +1729,7 @@ class wf::render_manager::impl
         offset.x -= og.x;
         offset.y -= og.y;
 
-        for (auto& child : drag_icon->enumerate_surfaces(offset))
+        for (auto& child : drag_icon->traverse_surfaces(offset))
         {
             schedule_surface(repaint, child.surface, child.position);
         }
@@ -987,6 +1747,88 @@ class wf::render_manager::impl
         }
     }
 
+    /**
+     * The views which may be visible on a workspace, in stacking order.
+     */
+    struct workspace_render_list_t
+    {
+        /** The layer manager snapshot the list was built from. */
+        wf::workspace_manager::views_snapshot_t snapshot;
+        /** Whether the geometry of the views or the output has changed. */
+        bool geometry_dirty = true;
+        std::vector<wayfire_view> views;
+    };
+
+    /* A render list for each workspace */
+    std::vector<std::vector<workspace_render_list_t>> render_lists;
+
+    /**
+     * Changes in the stacking order or in the set of views on the output are
+     * detected by comparing the layer manager snapshots, so only changes which
+     * affect which views intersect a workspace need to be tracked here.
+     */
+    wf::signal_connection_t on_render_geometry_changed = [=] (wf::signal_data_t*)
+    {
+        for (auto& row : render_lists)
+        {
+            for (auto& list : row)
+            {
+                list.geometry_dirty = true;
+            }
+        }
+    };
+
+    void init_render_lists()
+    {
+        auto wsize = output->workspace->get_workspace_grid_size();
+        render_lists.resize(wsize.width);
+        for (auto& row : render_lists)
+        {
+            row.resize(wsize.height);
+        }
+
+        for (auto signal : {"workspace-changed", "view-geometry-changed",
+                            "view-transformers-changed",
+                            "output-configuration-changed"})
+        {
+            output->connect_signal(signal, &on_render_geometry_changed);
+        }
+    }
+
+    /**
+     * Get the list of views which are visible on the given workspace, in
+     * stacking order. The list is rebuilt only if the layer manager snapshot
+     * or the geometry of the views has changed since it was last used.
+     *
+     * Views with transformers are always included, because their visibility
+     * may change without any signal being emitted.
+     */
+    const std::vector<wayfire_view>& get_render_list(wf::point_t ws)
+    {
+        auto& list = render_lists[ws.x][ws.y];
+        auto views = output->workspace->get_views_in_layer_snapshot(
+            wf::VISIBLE_LAYERS);
+        if (!list.geometry_dirty && (list.snapshot == views))
+        {
+            return list.views;
+        }
+
+        list.views.clear();
+        for (auto& view : *views)
+        {
+            if (view->has_transformer() ||
+                output->workspace->view_visible_on(view, ws))
+            {
+                list.views.push_back(view);
+            }
+        }
+
+        list.snapshot       = views;
+        list.geometry_dirty = false;
+
+        return list.views;
+    }
+
     /**
      * Iterate all visible surfaces on the workspace, and check whether
      * they need repaint.
@@ -994,13 +1836,18 @@ class wf::render_manager::impl
     void check_schedule_surfaces(workspace_stream_repaint_t& repaint,
         workspace_stream_t& stream)
     {
-        auto views = output->workspace->get_views_on_workspace(stream.ws,
-            wf::VISIBLE_LAYERS);
-
         schedule_drag_icon(repaint);
-        for (auto& v : views)
+        for (auto& v : get_render_list(stream.ws))
         {
-            for (auto& view : v->enumerate_views(false))
+            /* Transformed views are always in the render list, because their
+             * visibility may change without notice */
+            if (v->has_transformer() &&
+                !output->workspace->view_visible_on(v, stream.ws))
+            {
+                continue;
+            }
+
+            for (auto& view : v->traverse_views(false))
             {
                 wf::point_t view_delta{0, 0};
                 if (!view->is_visible() || repaint.ws_damage.empty())
@@ -1030,7 +1877,7 @@ class wf::render_manager::impl
                     /* Make sure view position is relative to the workspace
                      * being rendered */
                     auto obox = view->get_output_geometry() + view_delta;
-                    for (auto& child : view->enumerate_surfaces({obox.x, obox.y}))
+                    for (auto& child : view->traverse_surfaces({obox.x, obox.y}))
                     {
                         schedule_surface(repaint, child.surface, child.position);
                     }
@@ -1046,7 +1893,23 @@ class wf::render_manager::impl
         workspace_stream_t& stream, float scale_x, float scale_y)
     {
         workspace_stream_repaint_t repaint;
-        repaint.ws_damage = output_damage->get_ws_damage(stream.ws);
+        repaint.first_surface = surface_arena.used;
+        repaint.ws_damage     = output_damage->get_ws_damage(stream.ws);
+
+        /* Streams which render directly to the output cannot be scaled.
+         * Framebuffers support only uniform scaling, so use the larger scale
+         * in both directions. */
+        float scale = std::max(scale_x, scale_y);
+        if ((stream.buffer.tex == 0) || (scale <= 0) || (scale > 1))
+        {
+            scale = 1;
+        }
+
+        if ((scale != stream.scale_x) || (scale != stream.scale_y))
+        {
+            stream.scale_x = stream.scale_y = scale;
+            repaint.ws_damage |= output_damage->get_ws_box(stream.ws);
+        }
 
         /* we don't have to update anything */
         if (repaint.ws_damage.empty())
@@ -1054,17 +1917,16 @@ class wf::render_manager::impl
             return repaint;
         }
 
-        if ((scale_x != stream.scale_x) || (scale_y != stream.scale_y))
-        {
-            /* FIXME: enable scaled rendering */
-            // stream->scale_x = scale_x;
-            // stream->scale_y = scale_y;
+        int width  = std::max(1, (int)std::ceil(output->handle->width * scale));
+        int height = std::max(1, (int)std::ceil(output->handle->height * scale));
 
-            // ws_damage |= get_damage_box();
+        OpenGL::render_begin();
+        if (stream.buffer.allocate(width, height))
+        {
+            /* The buffer contents are undefined after resizing it */
+            repaint.ws_damage |= output_damage->get_ws_box(stream.ws);
         }
 
-        OpenGL::render_begin();
-        stream.buffer.allocate(output->handle->width, output->handle->height);
         OpenGL::render_end();
 
         repaint.fb = postprocessing->get_target_framebuffer();
@@ -1073,6 +1935,9 @@ class wf::render_manager::impl
             /* Use the workspace buffers */
             repaint.fb.fb  = stream.buffer.fb;
             repaint.fb.tex = stream.buffer.tex;
+            repaint.fb.viewport_width  = width;
+            repaint.fb.viewport_height = height;
+            repaint.fb.scale *= scale;
         }
 
         auto g   = output->get_relative_geometry();
@@ -1112,22 +1977,23 @@ class wf::render_manager::impl
     {
         wf::geometry_t fb_geometry = repaint.fb.geometry;
 
-        for (auto& ds : wf::reverse(repaint.to_render))
+        for (size_t i = surface_arena.used; i > repaint.first_surface; i--)
         {
-            if (ds->view)
+            auto& ds = surface_arena.entries[i - 1];
+            if (ds.view)
             {
-                repaint.fb.geometry = fb_geometry + ds->pos;
-                ds->view->render_transformed(repaint.fb, ds->damage);
-                for (auto& child : ds->view->enumerate_surfaces({0, 0}))
+                repaint.fb.geometry = fb_geometry + ds.pos;
+                ds.view->render_transformed(repaint.fb, ds.damage);
+                for (auto& child : ds.view->traverse_surfaces({0, 0}))
                 {
                     send_sampled_on_output(child.surface);
                 }
             } else
             {
                 repaint.fb.geometry = fb_geometry;
-                ds->surface->simple_render(repaint.fb,
-                    ds->pos.x, ds->pos.y, ds->damage);
-                send_sampled_on_output(ds->surface);
+                ds.surface->simple_render(repaint.fb,
+                    ds.pos.x, ds.pos.y, ds.damage);
+                send_sampled_on_output(ds.surface);
             }
         }
 
@@ -1147,8 +2013,10 @@ class wf::render_manager::impl
         }
 
         {
+            static const wf::signal_t<stream_signal_t>
+                signal_stream_pre{"workspace-stream-pre"};
             stream_signal_t data(stream.ws, repaint.ws_damage, repaint.fb);
-            output->render->emit_signal("workspace-stream-pre", &data);
+            output->render->emit_signal(signal_stream_pre, &data);
         }
 
         check_schedule_surfaces(repaint, stream);
@@ -1162,11 +2030,15 @@ class wf::render_manager::impl
         }
 
         render_views(repaint);
+        /* Release the entries of this repaint */
+        surface_arena.used = repaint.first_surface;
 
         unschedule_drag_icon();
         {
+            static const wf::signal_t<stream_signal_t>
+                signal_stream_post{"workspace-stream-post"};
             stream_signal_t data(stream.ws, repaint.ws_damage, repaint.fb);
-            output->render->emit_signal("workspace-stream-post", &data);
+            output->render->emit_signal(signal_stream_post, &data);
         }
     }
 
@@ -1185,6 +2057,11 @@ void render_manager::set_renderer(render_hook_t rh)
     pimpl->set_renderer(rh);
 }
 
+void render_manager::set_damage_renderer(damage_render_hook_t rh)
+{
+    pimpl->set_damage_renderer(rh);
+}
+
 void render_manager::set_redraw_always(bool always)
 {
     pimpl->set_redraw_always(always);
@@ -1205,9 +2082,10 @@ void render_manager::add_inhibit(bool add)
     pimpl->add_inhibit(add);
 }
 
-void render_manager::add_effect(effect_hook_t *hook, output_effect_type_t type)
+void render_manager::add_effect(effect_hook_t *hook, output_effect_type_t type,
+    std::string name)
 {
-    pimpl->effects->add_effect(hook, type);
+    pimpl->effects->add_effect(hook, type, name);
 }
 
 void render_manager::rem_effect(effect_hook_t *hook)
@@ -1215,9 +2093,10 @@ void render_manager::rem_effect(effect_hook_t *hook)
     pimpl->effects->rem_effect(hook);
 }
 
-void render_manager::add_post(post_hook_t *hook)
+void render_manager::add_post(post_hook_t *hook, std::string name,
+    post_damage_spread_t spread)
 {
-    pimpl->postprocessing->add_post(hook);
+    pimpl->postprocessing->add_post(hook, name, spread);
 }
 
 void render_manager::rem_post(post_hook_t *hook)
@@ -1225,6 +2104,11 @@ void render_manager::rem_post(post_hook_t *hook)
     pimpl->postprocessing->rem_post(hook);
 }
 
+uint32_t render_manager::get_throttled_surfaces_count() const
+{
+    return pimpl->throttled_surfaces_count;
+}
+
 wf::region_t render_manager::get_scheduled_damage()
 {
     return pimpl->output_damage->get_scheduled_damage();
@@ -1250,6 +2134,16 @@ void render_manager::damage(const wf::region_t& region)
     pimpl->output_damage->damage(region);
 }
 
+void render_manager::damage_sticky(const wf::region_t& region)
+{
+    pimpl->output_damage->damage_sticky(region);
+}
+
+wf::region_t render_manager::get_ws_damage(wf::point_t ws)
+{
+    return pimpl->output_damage->get_ws_damage(ws);
+}
+
 wlr_box render_manager::get_ws_box(wf::point_t ws) const
 {
     return pimpl->output_damage->get_ws_box(ws);
@@ -1268,7 +2162,7 @@ void render_manager::workspace_stream_start(workspace_stream_t& stream)
 void render_manager::workspace_stream_update(workspace_stream_t& stream,
     float scale_x, float scale_y)
 {
-    pimpl->workspace_stream_update(stream);
+    pimpl->workspace_stream_update(stream, scale_x, scale_y);
 }
 
 void render_manager::workspace_stream_stop(workspace_stream_t& stream)
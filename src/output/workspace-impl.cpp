@@ -6,69 +6,14 @@
 #include <wayfire/signal-definitions.hpp>
 #include <wayfire/opengl.hpp>
 #include <list>
+#include <memory>
 #include <algorithm>
+#include <unordered_map>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/util/log.hpp>
 
 namespace wf
 {
-/** Find a smart pointer inside a list */
-template<class Haystack, class Needle>
-typename std::list<Haystack>::iterator find_in(std::list<Haystack>& hay,
-    const Needle& needle)
-{
-    return std::find_if(std::begin(hay), std::end(hay), [=] (const auto& elem)
-    {
-        return elem.get() == needle.get();
-    });
-}
-
-/** Bring to front or lower to back inside a container of smart pointers */
-template<class Haystack, class Needle>
-void raise_to_front(std::list<Haystack>& hay, const Needle& needle,
-    bool reverse = false)
-{
-    auto it = find_in(hay, needle);
-    hay.splice(reverse ? hay.end() : hay.begin(), hay, it);
-}
-
-/** Reorder list so that @element is directly above @below. */
-template<class Haystack, class Needle>
-void reorder_above(
-    std::list<Haystack>& list, const Needle& element, const Needle& below)
-{
-    auto element_it = find_in(list, element);
-    auto pos = find_in(list, below);
-    list.splice(pos, list, element_it);
-}
-
-/** Reorder list so that @element is directly below @above. */
-template<class Haystack, class Needle>
-void reorder_below(
-    std::list<Haystack>& list, const Needle& element, const Needle& above)
-{
-    auto element_it = find_in(list, element);
-    auto pos = find_in(list, above);
-    assert(pos != list.end());
-    list.splice(std::next(pos), list, element_it);
-}
-
-/**
- * Remove needle from haystack, where both needle and elements in haystack are
- * smart pointers.
- */
-template<class Haystack, class Needle>
-void remove_from(Haystack& haystack, Needle& n)
-{
-    auto it = std::remove_if(std::begin(haystack), std::end(haystack),
-        [=] (const auto& contained)
-    {
-        return contained.get() == n.get();
-    });
-
-    haystack.erase(it, std::end(haystack));
-}
-
 struct layer_container_t;
 /**
  * Implementation of the sublayer struct.
@@ -90,6 +35,9 @@ struct sublayer_t
      * elsewhere.
      */
     bool is_single_view;
+
+    /** The position of the sublayer in its layer's list for its mode */
+    std::list<std::unique_ptr<sublayer_t>>::iterator position;
 };
 
 class layer_view_data_t : public custom_data_t
@@ -98,6 +46,8 @@ class layer_view_data_t : public custom_data_t
     nonstd::observer_ptr<sublayer_t> sublayer;
     /* Promoted to the fullscreen layer? */
     bool is_promoted = false;
+    /** The position of the view in sublayer->views, valid if sublayer is set */
+    std::list<wayfire_view>::iterator position;
 };
 
 /**
@@ -116,23 +66,60 @@ struct layer_container_t
     /** List of sublayers docked above */
     sublayer_container_t above;
 
-    void remove_sublayer(nonstd::observer_ptr<sublayer_t> sublayer)
+    /** @return The list which contains sublayers with the given mode */
+    sublayer_container_t& get_container(sublayer_mode_t mode)
     {
-        for (auto container : {& below, & floating, & above})
+        switch (mode)
         {
-            remove_from(*container, sublayer);
+          case SUBLAYER_DOCKED_BELOW:
+            return below;
+
+          case SUBLAYER_DOCKED_ABOVE:
+            return above;
+
+          default:
+            return floating;
         }
     }
+
+    void remove_sublayer(nonstd::observer_ptr<sublayer_t> sublayer)
+    {
+        get_container(sublayer->mode).erase(sublayer->position);
+    }
 };
 
 /**
  * output_layer_manager_t is a part of the workspace_manager module. It provides
  * the functionality related to layers and sublayers.
+ *
+ * Views and sublayers remember their position in their containing lists, so
+ * that restacking does not need to search for them.
+ *
+ * Lists of views in stacking order are requested many times per frame, so they
+ * are cached until the stacking order changes. Each change of the stacking
+ * order increments the stacking generation, which invalidates the cache.
  */
 class output_layer_manager_t
 {
     layer_container_t layers[TOTAL_LAYERS];
 
+    uint64_t generation = 0;
+
+    struct cached_views_t
+    {
+        uint64_t generation;
+        workspace_manager::views_snapshot_t views;
+    };
+
+    /* Cached results of get_views_in_layer(), by layer mask */
+    std::unordered_map<uint32_t, cached_views_t> cache;
+
+    /** Invalidate the cached view lists. */
+    void stacking_changed()
+    {
+        ++generation;
+    }
+
   public:
     output_layer_manager_t()
     {
@@ -147,34 +134,46 @@ class output_layer_manager_t
         return __builtin_ctz(layer_mask);
     }
 
+    nonstd::observer_ptr<layer_view_data_t> get_view_data(wayfire_view view)
+    {
+        return view->get_data_safe<layer_view_data_t>();
+    }
+
     nonstd::observer_ptr<sublayer_t>& get_view_sublayer(wayfire_view view)
     {
-        return view->get_data_safe<layer_view_data_t>()->sublayer;
+        return get_view_data(view)->sublayer;
     }
 
     uint32_t get_view_layer(wayfire_view view)
     {
-        if (!view->has_data<layer_view_data_t>())
-        {
-            return 0;
-        }
+        auto data = view->get_data<layer_view_data_t>();
 
         /*
          * A view might have layer data set from a previous output.
          * That does not mean it has an assigned layer.
          */
-        auto sublayer = get_view_sublayer(view);
-        if (!sublayer)
+        if (!data || !data->sublayer)
         {
             return 0;
         }
 
-        return sublayer->layer->layer;
+        return data->sublayer->layer->layer;
+    }
+
+    void set_promoted(wayfire_view view, bool promoted)
+    {
+        auto data = get_view_data(view);
+        if (data->is_promoted != promoted)
+        {
+            data->is_promoted = promoted;
+            stacking_changed();
+        }
     }
 
     void remove_view(wayfire_view view)
     {
-        auto& sublayer = get_view_sublayer(view);
+        auto data = get_view_data(view);
+        auto sublayer = data->sublayer;
         if (!sublayer)
         {
             return;
@@ -182,22 +181,26 @@ class output_layer_manager_t
 
         view->damage();
 
-        remove_from(sublayer->views, view);
+        sublayer->views.erase(data->position);
         if (sublayer->is_single_view)
         {
             sublayer->layer->remove_sublayer(sublayer);
         }
 
         /* Reset the view's sublayer */
-        sublayer = nullptr;
+        data->sublayer = nullptr;
+        stacking_changed();
     }
 
     void add_view_to_sublayer(wayfire_view view,
         nonstd::observer_ptr<sublayer_t> sublayer)
     {
         remove_view(view);
-        get_view_sublayer(view) = sublayer;
-        sublayer->views.push_front(view);
+
+        auto data = get_view_data(view);
+        data->sublayer = sublayer;
+        data->position = sublayer->views.insert(sublayer->views.begin(), view);
+        stacking_changed();
     }
 
     nonstd::observer_ptr<sublayer_t> create_sublayer(layer_t layer_mask,
@@ -211,21 +214,13 @@ class output_layer_manager_t
         sublayer->mode  = mode;
         sublayer->is_single_view = false;
 
-        switch (mode)
-        {
-          case SUBLAYER_DOCKED_BELOW:
-            layer.below.emplace_back(std::move(sublayer));
-            break;
-
-          case SUBLAYER_DOCKED_ABOVE:
-            layer.above.emplace_front(std::move(sublayer));
-            break;
-
-          case SUBLAYER_FLOATING:
-            layer.floating.emplace_front(std::move(sublayer));
-            break;
-        }
+        auto& container = layer.get_container(mode);
+        /* Docked below sublayers are added on the bottom, the others on top */
+        auto pos = (mode == SUBLAYER_DOCKED_BELOW) ?
+            container.end() : container.begin();
+        ptr->position = container.insert(pos, std::move(sublayer));
 
+        /* Empty sublayers do not change the stacking order of views */
         return ptr;
     }
 
@@ -242,25 +237,29 @@ class output_layer_manager_t
     {
         view->damage();
 
-        auto sublayer = get_view_sublayer(view);
+        auto data = get_view_data(view);
+        auto sublayer = data->sublayer;
         assert(sublayer);
         if (sublayer->mode == SUBLAYER_FLOATING)
         {
-            raise_to_front(sublayer->layer->floating, sublayer);
+            auto& floating = sublayer->layer->floating;
+            floating.splice(floating.begin(), floating, sublayer->position);
         }
 
-        raise_to_front(sublayer->views, view);
+        sublayer->views.splice(sublayer->views.begin(), sublayer->views,
+            data->position);
+        stacking_changed();
     }
 
     wayfire_view get_front_view(wf::layer_t layer)
     {
         auto views = get_views_in_layer(layer);
-        if (views.size() == 0)
+        if (views->size() == 0)
         {
             return nullptr;
         }
 
-        return views.front();
+        return views->front();
     }
 
     /** Precondition: view and below are in the same layer */
@@ -268,13 +267,17 @@ class output_layer_manager_t
     {
         view->damage();
 
-        auto view_sublayer  = get_view_sublayer(view);
-        auto below_sublayer = get_view_sublayer(below);
+        auto view_data  = get_view_data(view);
+        auto below_data = get_view_data(below);
+        auto view_sublayer  = view_data->sublayer;
+        auto below_sublayer = below_data->sublayer;
         assert(view_sublayer->layer == below_sublayer->layer);
 
+        auto& views = view_sublayer->views;
         if (view_sublayer == below_sublayer)
         {
-            reorder_above(view_sublayer->views, view, below);
+            views.splice(below_data->position, views, view_data->position);
+            stacking_changed();
 
             return;
         }
@@ -285,8 +288,12 @@ class output_layer_manager_t
             return;
         }
 
-        reorder_above(view_sublayer->layer->floating, view_sublayer, below_sublayer);
-        raise_to_front(view_sublayer->views, view, true); // bring to back == reverse
+        auto& floating = view_sublayer->layer->floating;
+        floating.splice(below_sublayer->position, floating,
+            view_sublayer->position);
+        /* Bring to the back of its sublayer, so that it is directly above */
+        views.splice(views.end(), views, view_data->position);
+        stacking_changed();
     }
 
     /** Precondition: view and above are in the same layer */
@@ -294,13 +301,18 @@ class output_layer_manager_t
     {
         view->damage();
 
-        auto view_sublayer  = get_view_sublayer(view);
-        auto above_sublayer = get_view_sublayer(above);
+        auto view_data  = get_view_data(view);
+        auto above_data = get_view_data(above);
+        auto view_sublayer  = view_data->sublayer;
+        auto above_sublayer = above_data->sublayer;
         assert(view_sublayer->layer == above_sublayer->layer);
 
+        auto& views = view_sublayer->views;
         if (view_sublayer == above_sublayer)
         {
-            reorder_below(view_sublayer->views, view, above);
+            views.splice(std::next(above_data->position), views,
+                view_data->position);
+            stacking_changed();
 
             return;
         }
@@ -311,8 +323,12 @@ class output_layer_manager_t
             return;
         }
 
-        reorder_below(view_sublayer->layer->floating, view_sublayer, above_sublayer);
-        raise_to_front(view_sublayer->views, view);
+        auto& floating = view_sublayer->layer->floating;
+        floating.splice(std::next(above_sublayer->position), floating,
+            view_sublayer->position);
+        /* Bring to the front of its sublayer, so that it is directly below */
+        views.splice(views.begin(), views, view_data->position);
+        stacking_changed();
     }
 
     void push_views(std::vector<wayfire_view>& into, layer_t layer_e,
@@ -337,7 +353,7 @@ class output_layer_manager_t
         }
     }
 
-    std::vector<wayfire_view> get_views_in_layer(uint32_t layers_mask)
+    std::vector<wayfire_view> generate_views_in_layer(uint32_t layers_mask)
     {
         std::vector<wayfire_view> views;
         auto try_push = [&] (layer_t layer, bool promoted = false)
@@ -369,6 +385,19 @@ class output_layer_manager_t
         return views;
     }
 
+    workspace_manager::views_snapshot_t get_views_in_layer(uint32_t layers_mask)
+    {
+        auto& cached = cache[layers_mask];
+        if (!cached.views || (cached.generation != generation))
+        {
+            cached.generation = generation;
+            cached.views = std::make_shared<const std::vector<wayfire_view>>(
+                generate_views_in_layer(layers_mask));
+        }
+
+        return cached.views;
+    }
+
     std::vector<wayfire_view> get_promoted_views()
     {
         std::vector<wayfire_view> views;
@@ -548,17 +577,17 @@ class output_viewport_manager_t
         uint32_t layers_mask)
     {
         /* get all views in the given layers */
-        std::vector<wayfire_view> views =
-            output->workspace->get_views_in_layer(layers_mask);
+        auto all_views =
+            output->workspace->get_views_in_layer_snapshot(layers_mask);
 
-        /* remove those which aren't visible on the workspace */
-        auto it = std::remove_if(views.begin(), views.end(), [&] (wayfire_view view)
+        /* keep those which are visible on the workspace */
+        std::vector<wayfire_view> views;
+        std::copy_if(all_views->begin(), all_views->end(),
+            std::back_inserter(views), [&] (wayfire_view view)
         {
-            return !view_visible_on(view, vp);
+            return view_visible_on(view, vp);
         });
 
-        views.erase(it, views.end());
-
         return views;
     }
 
@@ -640,12 +669,14 @@ class output_viewport_manager_t
         auto dx     = (data.old_viewport.x - nws.x) * screen.width;
         auto dy     = (data.old_viewport.y - nws.y) * screen.height;
 
-        for (auto& view : output->workspace->get_views_in_layer(MIDDLE_LAYERS))
+        auto middle_views =
+            output->workspace->get_views_in_layer_snapshot(MIDDLE_LAYERS);
+        for (auto& view : *middle_views)
         {
             auto it = std::find(fixed_views.cbegin(), fixed_views.cend(), view);
             if (it == fixed_views.end())
             {
-                for (auto v : view->enumerate_views())
+                for (auto v : view->traverse_views())
                 {
                     v->move(v->get_wm_geometry().x + dx,
                         v->get_wm_geometry().y + dy);
@@ -801,7 +832,8 @@ class workspace_manager::impl
         auto old_w = output_geometry.width, old_h = output_geometry.height;
         auto new_size = output->get_screen_size();
 
-        for (auto& view : layer_manager.get_views_in_layer(MIDDLE_LAYERS))
+        auto middle_views = layer_manager.get_views_in_layer(MIDDLE_LAYERS);
+        for (auto& view : *middle_views)
         {
             if (!view->is_mapped())
             {
@@ -935,7 +967,7 @@ class workspace_manager::impl
         auto already_promoted = viewport_manager.get_promoted_views(vp);
         for (auto& view : already_promoted)
         {
-            view->get_data_safe<layer_view_data_t>()->is_promoted = false;
+            layer_manager.set_promoted(view, false);
         }
 
         auto views = viewport_manager.get_views_on_workspace(
@@ -951,7 +983,7 @@ class workspace_manager::impl
 
         if (!views.empty() && views.front()->fullscreen)
         {
-            views.front()->get_data_safe<layer_view_data_t>()->is_promoted = true;
+            layer_manager.set_promoted(views.front(), true);
         }
 
         check_autohide_panels();
@@ -1158,6 +1190,12 @@ uint32_t workspace_manager::get_view_layer(wayfire_view view)
 }
 
 std::vector<wayfire_view> workspace_manager::get_views_in_layer(uint32_t layers_mask)
+{
+    return *pimpl->layer_manager.get_views_in_layer(layers_mask);
+}
+
+workspace_manager::views_snapshot_t workspace_manager::get_views_in_layer_snapshot(
+    uint32_t layers_mask)
 {
     return pimpl->layer_manager.get_views_in_layer(layers_mask);
 }
@@ -15,6 +15,9 @@ extern "C"
 #undef static
 }
 
+static const wf::signal_t<wf::view_geometry_changed_signal>
+    signal_geometry_changed{"geometry-changed"};
+
 /* Implementation of mirror_view_t */
 wf::mirror_view_t::mirror_view_t(wayfire_view base_view) :
     wf::view_interface_t()
@@ -111,7 +114,7 @@ void wf::mirror_view_t::move(int x, int y)
     this->y = y;
 
     damage();
-    emit_signal("geometry-changed", &data);
+    emit_signal(signal_geometry_changed, &data);
 }
 
 wf::geometry_t wf::mirror_view_t::get_output_geometry()
@@ -199,7 +202,8 @@ wf::dimensions_t wf::color_rect_view_t::get_size() const
 }
 
 static void render_colored_rect(const wf::framebuffer_t& fb,
-    int x, int y, int w, int h, const wf::color_t& color)
+    int x, int y, int w, int h, const wf::geometry_t& clip,
+    const wf::color_t& color)
 {
     wf::color_t premultiply{
         color.r * color.a,
@@ -207,37 +211,42 @@ static void render_colored_rect(const wf::framebuffer_t& fb,
         color.b * color.a,
         color.a};
 
-    OpenGL::render_rectangle({x, y, w, h}, premultiply,
-        fb.get_orthographic_projection());
+    OpenGL::batch_rectangle(fb, {x, y, w, h}, clip, premultiply);
 }
 
 void wf::color_rect_view_t::simple_render(const wf::framebuffer_t& fb, int x, int y,
     const wf::region_t& damage)
 {
     OpenGL::render_begin(fb);
+
+    /* Border and inside don't overlap, so we can draw all border parts first
+     * and then the inside, which results in only two batches. */
     for (const auto& box : damage)
     {
-        fb.logic_scissor(wlr_box_from_pixman_box(box));
+        auto clip = wlr_box_from_pixman_box(box);
 
         /* Draw the border, making sure border parts don't overlap, otherwise
          * we will get wrong corners if border has alpha != 1.0 */
         // top
-        render_colored_rect(fb, x, y, geometry.width, border,
+        render_colored_rect(fb, x, y, geometry.width, border, clip,
             _border_color);
         // bottom
         render_colored_rect(fb, x, y + geometry.height - border,
-            geometry.width, border, _border_color);
+            geometry.width, border, clip, _border_color);
         // left
         render_colored_rect(fb, x, y + border, border,
-            geometry.height - 2 * border, _border_color);
+            geometry.height - 2 * border, clip, _border_color);
         // right
-        render_colored_rect(fb, x + geometry.width - border,
-            y + border, border, geometry.height - 2 * border, _border_color);
+        render_colored_rect(fb, x + geometry.width - border, y + border,
+            border, geometry.height - 2 * border, clip, _border_color);
+    }
 
-        /* Draw the inside of the rect */
+    /* Draw the inside of the rect */
+    for (const auto& box : damage)
+    {
         render_colored_rect(fb, x + border, y + border,
             geometry.width - 2 * border, geometry.height - 2 * border,
-            _color);
+            wlr_box_from_pixman_box(box), _color);
     }
 
     OpenGL::render_end();
@@ -253,7 +262,7 @@ void wf::color_rect_view_t::move(int x, int y)
     this->geometry.y = y;
 
     damage();
-    emit_signal("geometry-changed", &data);
+    emit_signal(signal_geometry_changed, &data);
 }
 
 void wf::color_rect_view_t::resize(int w, int h)
@@ -266,7 +275,7 @@ void wf::color_rect_view_t::resize(int w, int h)
     this->geometry.height = h;
 
     damage();
-    emit_signal("geometry-changed", &data);
+    emit_signal(signal_geometry_changed, &data);
 }
 
 wf::geometry_t wf::color_rect_view_t::get_output_geometry()
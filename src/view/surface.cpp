@@ -16,6 +16,7 @@ extern "C"
 
 #include "surface-impl.hpp"
 #include "subsurface.hpp"
+#include "tree-walk.hpp"
 #include "wayfire/opengl.hpp"
 #include "../core/core-impl.hpp"
 #include "wayfire/output.hpp"
@@ -72,36 +73,41 @@ wf::surface_interface_t*wf::surface_interface_t::get_main_surface()
 std::vector<wf::surface_iterator_t> wf::surface_interface_t::enumerate_surfaces(
     wf::point_t surface_origin)
 {
-    std::vector<wf::surface_iterator_t> result;
-    auto add_surfaces_recursive = [&] (surface_interface_t *child)
-    {
-        if (!child->is_mapped())
-        {
-            return;
-        }
+    auto surfaces = traverse_surfaces(surface_origin);
 
-        auto child_surfaces = child->enumerate_surfaces(
-            child->get_offset() + surface_origin);
-        result.insert(result.end(),
-            child_surfaces.begin(), child_surfaces.end());
-    };
+    return {surfaces.begin(), surfaces.end()};
+}
 
-    for (auto& child : priv->surface_children_above)
-    {
-        add_surfaces_recursive(child.get());
-    }
+wf::iterator_range_t<wf::surface_tree_iterator_t> wf::surface_interface_t::
+traverse_surfaces(wf::point_t surface_origin, bool bottom_first)
+{
+    return {surface_tree_iterator_t{this, surface_origin, bottom_first},
+        surface_tree_iterator_t{}};
+}
 
-    if (is_mapped())
-    {
-        result.push_back({this, surface_origin});
-    }
+/****************************
+* surface_tree_iterator_t functions
+****************************/
+wf::surface_tree_iterator_t::surface_tree_iterator_t(surface_interface_t *root,
+    wf::point_t root_origin, bool bottom_first)
+{
+    this->root    = root;
+    this->current = {root, root_origin};
+    this->bottom_first = bottom_first;
+    advance();
+}
 
-    for (auto& child : priv->surface_children_below)
-    {
-        add_surfaces_recursive(child.get());
-    }
+wf::surface_tree_iterator_t& wf::surface_tree_iterator_t::operator ++()
+{
+    advance();
 
-    return result;
+    return *this;
+}
+
+void wf::surface_tree_iterator_t::advance()
+{
+    wf::tree_walk::advance_surface(root, current, bottom_first,
+        in_first_children, visited_children);
 }
 
 wf::output_t*wf::surface_interface_t::get_output()
@@ -401,8 +407,8 @@ void wf::wlr_surface_base_t::_simple_render(const wf::framebuffer_t& fb,
     OpenGL::render_begin(fb);
     for (const auto& rect : damage)
     {
-        fb.logic_scissor(wlr_box_from_pixman_box(rect));
-        OpenGL::render_texture(texture, fb, geometry);
+        OpenGL::batch_texture(texture, fb, geometry,
+            wlr_box_from_pixman_box(rect));
     }
 
     OpenGL::render_end();
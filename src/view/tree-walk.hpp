@@ -0,0 +1,166 @@
+#ifndef TREE_WALK_HPP
+#define TREE_WALK_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+/*
+ * The steps of surface_tree_iterator_t and view_tree_iterator_t.
+ *
+ * They are templates which only use the members of surfaces and views that the
+ * walk needs, so that benchmarks/traversal.cpp can run the same code on plain
+ * nodes, without a compositor. This header must not depend on wlroots.
+ */
+namespace wf
+{
+namespace tree_walk
+{
+/*
+ * The surfaces of a tree are visited depth-first: the children above a
+ * surface, the surface itself, and then the children below it (or the other
+ * way around if bottom_first). Instead of keeping a stack, the walk goes back
+ * to the parent surface once all children of a surface are visited, and finds
+ * where it left off in the parent's children.
+ *
+ * Surface needs is_mapped(), get_offset(), and a priv with parent_surface,
+ * surface_children_above and surface_children_below.
+ */
+template<class Surface>
+auto& get_children(Surface *surface, bool above)
+{
+    return above ? surface->priv->surface_children_above :
+           surface->priv->surface_children_below;
+}
+
+/** Get the next mapped child of current.surface to visit, or nullptr */
+template<class Surface, class Position>
+Surface *next_child(Position& current, bool bottom_first,
+    bool in_first_children, size_t& visited_children)
+{
+    auto& children = get_children<Surface>(current.surface,
+        in_first_children != bottom_first);
+    for (; visited_children < children.size(); visited_children++)
+    {
+        size_t i = bottom_first ?
+            children.size() - 1 - visited_children : visited_children;
+        if (children[i]->is_mapped())
+        {
+            return children[i].get();
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Go to the next surface of the tree, or set current.surface to nullptr after
+ * the last one.
+ */
+template<class Surface, class Position>
+void advance_surface(Surface *root, Position& current, bool bottom_first,
+    bool& in_first_children, size_t& visited_children)
+{
+    while (current.surface)
+    {
+        if (auto child = next_child<Surface>(current, bottom_first,
+            in_first_children, visited_children))
+        {
+            current.surface   = child;
+            current.position  = current.position + child->get_offset();
+            in_first_children = true;
+            visited_children  = 0;
+            continue;
+        }
+
+        if (in_first_children)
+        {
+            in_first_children = false;
+            visited_children  = 0;
+            if (current.surface->is_mapped())
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        /* All children have been visited, go back to the parent */
+        Surface *child = current.surface;
+        if (child == root)
+        {
+            current.surface = nullptr;
+
+            return;
+        }
+
+        current.surface  = child->priv->parent_surface;
+        current.position = current.position - child->get_offset();
+        for (bool first : {true, false})
+        {
+            in_first_children = first;
+            auto& children = get_children<Surface>(current.surface,
+                first != bottom_first);
+            auto it = std::find_if(children.begin(), children.end(),
+                [=] (const auto& ptr) { return ptr.get() == child; });
+            if (it != children.end())
+            {
+                size_t i = it - children.begin();
+                visited_children =
+                    (bottom_first ? children.size() - 1 - i : i) + 1;
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Children views are visited before their parent. Instead of keeping a stack,
+ * the walk goes back to the parent once a view is visited, and finds where it
+ * left off in the parent's children.
+ *
+ * View is a pointer to something with is_mapped(), parent and children.
+ */
+
+/** Go down to the first mapped view without unvisited mapped children */
+template<class View>
+void descend_view(View& current, size_t& visited_children)
+{
+    while (visited_children < current->children.size())
+    {
+        auto child = current->children[visited_children];
+        if (child->is_mapped())
+        {
+            current = child;
+            visited_children = 0;
+        } else
+        {
+            visited_children++;
+        }
+    }
+}
+
+/**
+ * Go to the next view of the tree, or set current to nullptr after the last
+ * one.
+ */
+template<class View>
+void advance_view(const View& root, View& current, size_t& visited_children)
+{
+    if (current == root)
+    {
+        current = nullptr;
+
+        return;
+    }
+
+    auto child = current;
+    current = current->parent;
+    auto& children = current->children;
+    visited_children =
+        std::find(children.begin(), children.end(), child) - children.begin() + 1;
+    descend_view(current, visited_children);
+}
+}
+}
+
+#endif /* end of include guard: TREE_WALK_HPP */
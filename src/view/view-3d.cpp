@@ -173,6 +173,21 @@ void wf::view_2D::render_box(wf::texture_t src_tex, wlr_box src_box,
     OpenGL::render_end();
 }
 
+bool wf::view_2D::has_changed()
+{
+    auto center = get_center(view->get_wm_geometry());
+    std::array<float, 8> state = {
+        angle, scale_x, scale_y, translation_x, translation_y, alpha,
+        (float)center.x, (float)center.y
+    };
+
+    bool changed = !last_state_valid || (state != last_state);
+    last_state = state;
+    last_state_valid = true;
+
+    return changed;
+}
+
 const float wf::view_3D::fov = PI / 4;
 glm::mat4 wf::view_3D::default_view_matrix()
 {
@@ -255,3 +270,16 @@ void wf::view_3D::render_box(wf::texture_t src_tex, wlr_box src_box,
         transform, color);
     OpenGL::render_end();
 }
+
+bool wf::view_3D::has_changed()
+{
+    auto transform = calculate_total_transform();
+    bool changed   = !last_state_valid || (transform != last_transform) ||
+        (color != last_color);
+
+    last_transform   = transform;
+    last_color       = color;
+    last_state_valid = true;
+
+    return changed;
+}
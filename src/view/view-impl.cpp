@@ -14,6 +14,11 @@ extern "C"
 #include <wlr/util/edges.h>
 }
 
+static const wf::signal_t<wf::view_geometry_changed_signal>
+    signal_geometry_changed{"geometry-changed"};
+static const wf::signal_t<wf::view_geometry_changed_signal>
+    signal_view_geometry_changed{"view-geometry-changed"};
+
 wf::wlr_view_t::wlr_view_t() :
     wf::wlr_surface_base_t(this), wf::view_interface_t()
 {}
@@ -135,11 +140,11 @@ void wf::wlr_view_t::set_position(int x, int y,
 
     if (send_signal)
     {
-        emit_signal("geometry-changed", &data);
-        wf::get_core().emit_signal("view-geometry-changed", &data);
+        emit_signal(signal_geometry_changed, &data);
+        wf::get_core().emit_signal(signal_view_geometry_changed, &data);
         if (get_output())
         {
-            get_output()->emit_signal("view-geometry-changed", &data);
+            get_output()->emit_signal(signal_view_geometry_changed, &data);
         }
     }
 
@@ -199,11 +204,11 @@ void wf::wlr_view_t::update_size()
     /* Damage new size */
     last_bounding_box = get_bounding_box();
     view_damage_raw(self(), last_bounding_box);
-    emit_signal("geometry-changed", &data);
-    wf::get_core().emit_signal("view-geometry-changed", &data);
+    emit_signal(signal_geometry_changed, &data);
+    wf::get_core().emit_signal(signal_view_geometry_changed, &data);
     if (get_output())
     {
-        get_output()->emit_signal("view-geometry-changed", &data);
+        get_output()->emit_signal(signal_view_geometry_changed, &data);
     }
 
     if (view_impl->frame)
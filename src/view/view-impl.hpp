@@ -26,6 +26,12 @@ struct view_transform_block_t : public noncopyable_t
     std::unique_ptr<wf::view_transformer_t> transform;
     wf::framebuffer_t fb;
 
+    /* Whether fb holds the result of the transformer for the current chain.
+     * Reset when transformers are added or removed. */
+    bool fb_valid = false;
+    /* The bounding box of the input of the transformer when fb was rendered */
+    wf::geometry_t input_box = {0, 0, 0, 0};
+
     view_transform_block_t();
     ~view_transform_block_t();
 };
@@ -61,6 +67,9 @@ class view_interface_t::view_priv_impl
     int visibility_counter   = 1;
 
     wf::safe_list_t<std::shared_ptr<view_transform_block_t>> transforms;
+    /* Damage of the untransformed view since it was last rendered with its
+     * transformers, in output-local coordinates */
+    wf::region_t transform_damage;
 
     struct offscreen_buffer_t : public wf::framebuffer_t
     {
@@ -84,6 +93,7 @@ class view_interface_t::view_priv_impl
  * views.
  */
 void view_damage_raw(wayfire_view view, const wlr_box& box);
+void view_damage_raw(wayfire_view view, const wf::region_t& region);
 
 /**
  * Implementation of a view backed by a wlr_* shell struct.
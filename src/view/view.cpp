@@ -1,6 +1,7 @@
 #include <wayfire/util/log.hpp>
 #include "../core/core-impl.hpp"
 #include "view-impl.hpp"
+#include "tree-walk.hpp"
 #include "wayfire/opengl.hpp"
 #include "wayfire/output.hpp"
 #include "wayfire/view.hpp"
@@ -26,6 +27,9 @@ extern "C"
 #undef static
 }
 
+static const wf::signal_t<wf::signal_data_t>
+    signal_region_damaged{"region-damaged"};
+
 static void reposition_relative_to_parent(wayfire_view view)
 {
     if (!view->parent)
@@ -147,21 +151,38 @@ void wf::view_interface_t::set_toplevel_parent(wayfire_view new_parent)
 std::vector<wayfire_view> wf::view_interface_t::enumerate_views(
     bool mapped_only)
 {
-    if (!this->is_mapped() && mapped_only)
-    {
-        return {};
-    }
+    auto views = traverse_views(mapped_only);
+
+    return {views.begin(), views.end()};
+}
 
-    std::vector<wayfire_view> result;
-    for (auto& v : this->children)
+wf::iterator_range_t<wf::view_tree_iterator_t> wf::view_interface_t::
+traverse_views(bool mapped_only)
+{
+    return {view_tree_iterator_t{self(), mapped_only}, view_tree_iterator_t{}};
+}
+
+wf::view_tree_iterator_t::view_tree_iterator_t(wayfire_view root,
+    bool mapped_only)
+{
+    if (root->is_mapped() || !mapped_only)
     {
-        auto cdr = v->enumerate_views();
-        result.insert(result.end(), cdr.begin(), cdr.end());
+        this->root    = root;
+        this->current = root;
+        descend();
     }
+}
 
-    result.push_back(self());
+void wf::view_tree_iterator_t::descend()
+{
+    wf::tree_walk::descend_view(current, visited_children);
+}
 
-    return result;
+wf::view_tree_iterator_t& wf::view_tree_iterator_t::operator ++()
+{
+    wf::tree_walk::advance_view(root, current, visited_children);
+
+    return *this;
 }
 
 void wf::view_interface_t::set_role(view_role_t new_role)
@@ -338,7 +359,7 @@ wf::surface_interface_t*wf::view_interface_t::map_input_coordinates(
     auto view_relative_coordinates =
         global_to_local_point(cursor, nullptr);
 
-    for (auto& child : enumerate_surfaces({0, 0}))
+    for (auto& child : traverse_surfaces({0, 0}))
     {
         local.x = view_relative_coordinates.x - child.position.x;
         local.y = view_relative_coordinates.y - child.position.y;
@@ -633,10 +654,35 @@ void wf::view_interface_t::set_visible(bool visible)
     this->damage();
 }
 
+/**
+ * Remember damage of the untransformed view, so that only the damaged parts of
+ * the transformers' offscreen buffers are rendered again.
+ */
+static void add_transform_damage(wf::view_interface_t::view_priv_impl *impl,
+    const wlr_box& box)
+{
+    /* Transformers added later start with an invalid buffer anyway */
+    if (impl->transforms.size())
+    {
+        impl->transform_damage |= box;
+    }
+}
+
+/** Make sure all transformers render their offscreen buffers again. */
+static void invalidate_transform_buffers(
+    wf::view_interface_t::view_priv_impl *impl)
+{
+    impl->transforms.for_each([] (auto& tr)
+    {
+        tr->fb_valid = false;
+    });
+}
+
 void wf::view_interface_t::damage()
 {
     auto bbox = get_untransformed_bounding_box();
     view_impl->offscreen_buffer.cached_damage |= bbox;
+    add_transform_damage(view_impl.get(), bbox);
     view_damage_raw(self(), transform_region(bbox));
 }
 
@@ -760,7 +806,9 @@ void wf::view_interface_t::add_transformer(
         return view_impl->transforms.INSERT_NONE;
     });
 
+    invalidate_transform_buffers(view_impl.get());
     damage();
+    emit_transformers_changed();
 }
 
 nonstd::observer_ptr<wf::view_transformer_t> wf::view_interface_t::get_transformer(
@@ -786,6 +834,8 @@ void wf::view_interface_t::pop_transformer(
         return tr->transform.get() == transformer.get();
     });
 
+    invalidate_transform_buffers(view_impl.get());
+
     /* Since we can remove transformers while rendering the output, damaging it
      * won't help at this stage (damage is already calculated).
      *
@@ -794,6 +844,19 @@ void wf::view_interface_t::pop_transformer(
     {
         get_output()->render->damage_whole_idle();
     }
+
+    emit_transformers_changed();
+}
+
+void wf::view_interface_t::emit_transformers_changed()
+{
+    view_transformers_changed_signal data;
+    data.view = self();
+    emit_signal("transformers-changed", &data);
+    if (get_output())
+    {
+        get_output()->emit_signal("view-transformers-changed", &data);
+    }
 }
 
 void wf::view_interface_t::pop_transformer(std::string name)
@@ -816,7 +879,7 @@ wf::geometry_t wf::view_interface_t::get_untransformed_bounding_box()
     auto bbox = get_output_geometry();
     wf::region_t bounding_region = bbox;
 
-    for (auto& child : enumerate_surfaces({bbox.x, bbox.y}))
+    for (auto& child : traverse_surfaces({bbox.x, bbox.y}))
     {
         auto dim = child.surface->get_size();
         bounding_region |= {child.position.x, child.position.y,
@@ -895,7 +958,7 @@ bool wf::view_interface_t::intersects_region(const wlr_box& region)
     }
 
     auto origin = get_output_geometry();
-    for (auto& child : enumerate_surfaces({origin.x, origin.y}))
+    for (auto& child : traverse_surfaces({origin.x, origin.y}))
     {
         wlr_box box = {child.position.x, child.position.y,
             child.surface->get_size().width, child.surface->get_size().height};
@@ -921,7 +984,7 @@ wf::region_t wf::view_interface_t::get_transformed_opaque_region()
     auto og   = get_output_geometry();
 
     wf::region_t opaque;
-    for (auto& surf : enumerate_surfaces({og.x, og.y}))
+    for (auto& surf : traverse_surfaces({og.x, og.y}))
     {
         opaque |= surf.surface->get_opaque_region(surf.position);
     }
@@ -949,7 +1012,9 @@ bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuff
     wf::texture_t previous_texture;
     float texture_scale;
 
-    if (is_mapped() && (enumerate_surfaces().size() == 1) && get_wlr_surface())
+    auto surfaces = traverse_surfaces();
+    auto second_surface = ++surfaces.begin();
+    if (is_mapped() && (second_surface == surfaces.end()) && get_wlr_surface())
     {
         /* Optimized case: there is a single mapped surface.
          * We can directly start with its texture */
@@ -974,9 +1039,17 @@ bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuff
     /* final_transform is the one that should render to the screen */
     std::shared_ptr<view_transform_block_t> final_transform = nullptr;
 
+    /* The damage of the input of the current transform since the last time
+     * the view was rendered */
+    wf::region_t stage_damage = view_impl->transform_damage;
+    view_impl->transform_damage.clear();
+
     /* Render the view passing its snapshot through the transformers.
      * For each transformer except the last we render on offscreen buffers,
-     * and the last one is rendered to the real fb. */
+     * and the last one is rendered to the real fb.
+     *
+     * The offscreen buffers are kept between frames, so only the parts whose
+     * input has been damaged need to be rendered again. */
     auto& transforms = view_impl->transforms;
     transforms.for_each([&] (auto& transform) -> void
     {
@@ -996,20 +1069,56 @@ bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuff
 
         /* Prepare buffer to store result after the transform */
         OpenGL::render_begin();
-        transform->fb.allocate(scaled_width, scaled_height);
+        bool resized = transform->fb.allocate(scaled_width, scaled_height);
+        OpenGL::render_end();
+
+        /* Must be called every time, so that the transformer tracks its state */
+        bool changed = transform->transform->has_changed();
+
+        wf::region_t transformed_damage;
+        if (changed || resized || !transform->fb_valid ||
+            (transform->fb.scale != texture_scale) ||
+            (transform->fb.geometry != transformed_box) ||
+            (transform->input_box != obox))
+        {
+            transformed_damage = transformed_box;
+        } else
+        {
+            for (const auto& rect : stage_damage)
+            {
+                transformed_damage |= transform->transform->get_bounding_box(
+                    obox, wlr_box_from_pixman_box(rect));
+            }
+
+            transformed_damage &= transformed_box;
+        }
+
         transform->fb.scale    = texture_scale;
         transform->fb.geometry = transformed_box;
-        transform->fb.bind(); // bind buffer to clear it
-        OpenGL::clear({0, 0, 0, 0});
-        OpenGL::render_end();
+        transform->input_box   = obox;
+        transform->fb_valid    = true;
 
-        /* Actually render the transform to the next framebuffer */
-        transform->transform->render_with_damage(previous_texture, obox,
-            wf::region_t{transformed_box}, transform->fb);
+        if (!transformed_damage.empty())
+        {
+            OpenGL::render_begin();
+            transform->fb.bind(); // bind buffer to clear it
+            for (const auto& rect : transformed_damage)
+            {
+                transform->fb.logic_scissor(wlr_box_from_pixman_box(rect));
+                OpenGL::clear({0, 0, 0, 0});
+            }
+
+            OpenGL::render_end();
+
+            /* Actually render the transform to the next framebuffer */
+            transform->transform->render_with_damage(previous_texture, obox,
+                transformed_damage, transform->fb);
+        }
 
         previous_transform = transform;
         previous_texture   = previous_transform->fb.tex;
         obox = transformed_box;
+        stage_damage = std::move(transformed_damage);
     });
 
     /* This can happen in two ways:
@@ -1099,8 +1208,8 @@ void wf::view_interface_t::take_snapshot()
     OpenGL::render_end();
 
     auto output_geometry = get_output_geometry();
-    auto children = enumerate_surfaces({output_geometry.x, output_geometry.y});
-    for (auto& child : wf::reverse(children))
+    for (auto& child : traverse_surfaces(
+        {output_geometry.x, output_geometry.y}, true))
     {
         wlr_box child_box{
             child.position.x,
@@ -1167,10 +1276,35 @@ void wf::view_interface_t::damage_surface_box(const wlr_box& box)
     damaged.x += obox.x;
     damaged.y += obox.y;
     view_impl->offscreen_buffer.cached_damage |= damaged;
+    add_transform_damage(view_impl.get(), damaged);
     view_damage_raw(self(), transform_region(damaged));
 }
 
+void wf::view_interface_t::damage_surface_region(const wf::region_t& region)
+{
+    /* Damage the whole region at once, so that a commit results in a single
+     * damage operation on the output */
+    auto obox = get_output_geometry();
+    wf::region_t damaged;
+    for (const auto& rect : region)
+    {
+        auto box = wlr_box_from_pixman_box(rect);
+        box.x += obox.x;
+        box.y += obox.y;
+        view_impl->offscreen_buffer.cached_damage |= box;
+        add_transform_damage(view_impl.get(), box);
+        damaged |= transform_region(box);
+    }
+
+    view_damage_raw(self(), damaged);
+}
+
 void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
+{
+    view_damage_raw(view, wf::region_t{box});
+}
+
+void wf::view_damage_raw(wayfire_view view, const wf::region_t& region)
 {
     auto output = view->get_output();
     if (!output)
@@ -1179,31 +1313,18 @@ void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
     }
 
     /* shell views are visible in all workspaces. That's why we must apply
-     * their damage to all workspaces as well */
+     * their damage to all workspaces as well. Only their visible region is
+     * damaged, so that hidden panels don't spill damage onto other
+     * workspaces. */
     if (view->role == wf::VIEW_ROLE_DESKTOP_ENVIRONMENT)
     {
-        auto wsize = output->workspace->get_workspace_grid_size();
-        auto cws   = output->workspace->get_current_workspace();
-
-        /* Damage only the visible region of the shell view.
-         * This prevents hidden panels from spilling damage onto other workspaces */
-        wlr_box ws_box = output->get_relative_geometry();
-        wlr_box visible_damage = geometry_intersection(box, ws_box);
-        for (int i = 0; i < wsize.width; i++)
-        {
-            for (int j = 0; j < wsize.height; j++)
-            {
-                const int dx = (i - cws.x) * ws_box.width;
-                const int dy = (j - cws.y) * ws_box.height;
-                output->render->damage(visible_damage + wf::point_t{dx, dy});
-            }
-        }
+        output->render->damage_sticky(region);
     } else
     {
-        output->render->damage(box);
+        output->render->damage(region);
     }
 
-    view->emit_signal("region-damaged", nullptr);
+    view->emit_signal(signal_region_damaged, nullptr);
 }
 
 void wf::view_interface_t::destruct()